@@ -192,6 +192,28 @@ gx_default_fill_linear_color_scanline(gx_device *dev, const gs_fill_attributes *
      */
     /* First determine if we are doing high level style colors or pure colors */
     bool devn = dev_proc(dev, dev_spec_op)(dev, gxdso_supports_devn, NULL, 0);
+
+    /* Todo: set this up to vector earlier */
+    if (devn)  /* Note, PDF14 could be additive and doing devn */
+        return gx_hl_fill_linear_color_scanline(dev, fa, i0, j, w, c0, c0f,
+                                                cg_num, cg_den);
+    return gx_fill_linear_color_scanline_runs(dev, fa, i0, j, w, c0, c0f,
+                                              cg_num, cg_den,
+                                              dev_proc(dev, fill_rectangle));
+}
+
+/*
+ * Decompose a scanline into runs of a constant color index, as above, and
+ * fill each of them with fill_run. A device that can write such runs more
+ * cheaply than its fill_rectangle can pass its own procedure here and still
+ * get exactly the same pixels.
+ */
+int
+gx_fill_linear_color_scanline_runs(gx_device *dev, const gs_fill_attributes *fa,
+        int i0, int j, int w,
+        const frac31 *c0, const int32_t *c0f, const int32_t *cg_num, int32_t cg_den,
+        dev_proc_fill_rectangle((*fill_run)))
+{
     frac31 c[GX_DEVICE_COLOR_MAX_COMPONENTS];
     ulong f[GX_DEVICE_COLOR_MAX_COMPONENTS];
     int i, i1 = i0 + w, bi = i0, k;
@@ -205,10 +227,6 @@ gx_default_fill_linear_color_scanline(gx_device *dev, const gs_fill_attributes *
                          (gx_color_index)(dev->graphics_type_tag & ~GS_DEVICE_ENCODES_TAGS) << cinfo->comp_shift[n]
                          : 0;
 
-    /* Todo: set this up to vector earlier */
-    if (devn)  /* Note, PDF14 could be additive and doing devn */
-        return gx_hl_fill_linear_color_scanline(dev, fa, i0, j, w, c0, c0f,
-                                                cg_num, cg_den);
     if (j < fixed2int(fa->clip->p.y) ||
             j > fixed2int_ceiling(fa->clip->q.y)) /* Must be compatible to the clipping logic. */
         return 0;
@@ -269,9 +287,9 @@ gx_default_fill_linear_color_scanline(gx_device *dev, const gs_fill_attributes *
             if (si < ei) {
                 ci0 |= tag;		/* set tag (may be 0 if the device doesn't use tags) */
                 if (fa->swap_axes) {
-                    code = dev_proc(dev, fill_rectangle)(dev, j, si, 1, ei - si, ci0);
+                    code = fill_run(dev, j, si, 1, ei - si, ci0);
                 } else {
-                    code = dev_proc(dev, fill_rectangle)(dev, si, j, ei - si, 1, ci0);
+                    code = fill_run(dev, si, j, ei - si, 1, ci0);
                 }
                 if (code < 0)
                     return code;
@@ -321,9 +339,9 @@ gx_default_fill_linear_color_scanline(gx_device *dev, const gs_fill_attributes *
     if (si < ei) {
         ci0 |= tag;		/* set tag (may be 0 if the device doesn't use tags) */
         if (fa->swap_axes) {
-            return dev_proc(dev, fill_rectangle)(dev, j, si, 1, ei - si, ci0);
+            return fill_run(dev, j, si, 1, ei - si, ci0);
         } else {
-            return dev_proc(dev, fill_rectangle)(dev, si, j, ei - si, 1, ci0);
+            return fill_run(dev, si, j, ei - si, 1, ci0);
         }
     }
     return 0;
@@ -132,10 +132,10 @@ static void pdf14_debug_mask_stack_state(pdf14_ctx *ctx);
 #endif
 
 /* Buffer stack	data structure */
-gs_private_st_ptrs7(st_pdf14_buf, pdf14_buf, "pdf14_buf",
+gs_private_st_ptrs8(st_pdf14_buf, pdf14_buf, "pdf14_buf",
                     pdf14_buf_enum_ptrs, pdf14_buf_reloc_ptrs,
                     saved, data, backdrop, transfer_fn, mask_stack,
-                    matte, parent_color_info);
+                    matte, parent_color_info, dirty_tiles);
 
 gs_private_st_ptrs2(st_pdf14_ctx, pdf14_ctx, "pdf14_ctx",
                     pdf14_ctx_enum_ptrs, pdf14_ctx_reloc_ptrs,
@@ -182,6 +182,7 @@ dev_proc_encode_color(pdf14_encode_color16_tag);
 dev_proc_decode_color(pdf14_decode_color16);
 static	dev_proc_fill_rectangle(pdf14_fill_rectangle);
 static  dev_proc_fill_rectangle_hl_color(pdf14_fill_rectangle_hl_color);
+static  dev_proc_fill_linear_color_scanline(pdf14_fill_linear_color_scanline);
 static	dev_proc_fill_path(pdf14_fill_path);
 static	dev_proc_fill_stroke_path(pdf14_fill_stroke_path);
 static  dev_proc_copy_mono(pdf14_copy_mono);
@@ -204,6 +205,7 @@ static  dev_proc_copy_alpha(pdf14_copy_alpha);
 static  dev_proc_copy_planes(pdf14_copy_planes);
 static  dev_proc_copy_alpha_hl_color(pdf14_copy_alpha_hl_color);
 static  dev_proc_discard_transparency_layer(pdf14_discard_trans_layer);
+static int pdf14_text_group_settle(pdf14_device *pdev);
 static	const gx_color_map_procs *
     pdf14_get_cmap_procs(const gs_gstate *, const gx_device *);
 
@@ -270,7 +272,7 @@ static	const gx_color_map_procs *
         NULL,                           /* pattern_manage */\
         pdf14_fill_rectangle_hl_color,	/* fill_rectangle_hl_color */\
         NULL,				/* include_color_space */\
-        NULL,				/* fill_linear_color_scanline */\
+        pdf14_fill_linear_color_scanline,	/* fill_linear_color_scanline */\
         NULL,				/* fill_linear_color_trapezoid */\
         NULL,				/* fill_linear_color_triangle */\
         gx_forward_update_spot_equivalent_colors,	/* update spot */\
@@ -1135,11 +1137,16 @@ pdf14_buf_new(gs_int_rect *rect, bool has_tags, bool has_alpha_g,
     result->parent_color_info->previous = NULL;
     result->parent_color_info->encode = NULL;
     result->parent_color_info->decode = NULL;
+    result->dirty_tiles = NULL;
+    result->dirty_tiles_wide = 0;
     if (idle || height <= 0) {
         /* Empty clipping - will skip all drawings. */
         result->planestride = 0;
         result->data = 0;
     } else {
+        int tiles_high = (height + (1 << PDF14_DIRTY_TILE_SHIFT) - 1) >>
+                         PDF14_DIRTY_TILE_SHIFT;
+
         planestride = rowstride * height;
         result->planestride = planestride;
         result->data = gs_alloc_bytes(memory, planestride * n_planes,
@@ -1148,6 +1155,20 @@ pdf14_buf_new(gs_int_rect *rect, bool has_tags, bool has_alpha_g,
             gs_free_object(memory, result, "pdf14_buf_new");
             return NULL;
         }
+        result->dirty_tiles_wide = (rect->q.x - rect->p.x +
+                                    (1 << PDF14_DIRTY_TILE_SHIFT) - 1) >>
+                                   PDF14_DIRTY_TILE_SHIFT;
+        if (result->dirty_tiles_wide < 1)
+            result->dirty_tiles_wide = 1;
+        result->dirty_tiles = gs_alloc_bytes(memory,
+                                             result->dirty_tiles_wide * tiles_high,
+                                             "pdf14_buf_new");
+        if (result->dirty_tiles == NULL) {
+            gs_free_object(memory, result->data, "pdf14_buf_new");
+            gs_free_object(memory, result, "pdf14_buf_new");
+            return NULL;
+        }
+        memset(result->dirty_tiles, 0, result->dirty_tiles_wide * tiles_high);
         if (has_alpha_g) {
             int alpha_g_plane = n_chan + (has_shape ? 1 : 0);
             /* Memsetting by 0, so this copes with the deep case too */
@@ -1170,6 +1191,116 @@ pdf14_buf_new(gs_int_rect *rect, bool has_tags, bool has_alpha_g,
     return result;
 }
 
+/*
+ * pdf14_buf_mark_dirty: Note that an area of a buffer has been marked.
+ *
+ * This grows the dirty rectangle to include the area, and marks the tiles
+ * of the buffer that it touches.
+ */
+void
+pdf14_buf_mark_dirty(pdf14_buf *buf, int x, int y, int w, int h)
+{
+    int tx0, ty0, tx1, ty1;
+    byte *row;
+
+    if (x < buf->dirty.p.x) buf->dirty.p.x = x;
+    if (y < buf->dirty.p.y) buf->dirty.p.y = y;
+    if (x + w > buf->dirty.q.x) buf->dirty.q.x = x + w;
+    if (y + h > buf->dirty.q.y) buf->dirty.q.y = y + h;
+
+    if (buf->dirty_tiles == NULL)
+        return;
+    tx0 = max(x, buf->rect.p.x) - buf->rect.p.x;
+    ty0 = max(y, buf->rect.p.y) - buf->rect.p.y;
+    tx1 = min(x + w, buf->rect.q.x) - buf->rect.p.x;
+    ty1 = min(y + h, buf->rect.q.y) - buf->rect.p.y;
+    if (tx0 >= tx1 || ty0 >= ty1)
+        return;
+    tx0 >>= PDF14_DIRTY_TILE_SHIFT;
+    ty0 >>= PDF14_DIRTY_TILE_SHIFT;
+    tx1 = (tx1 - 1) >> PDF14_DIRTY_TILE_SHIFT;
+    ty1 = (ty1 - 1) >> PDF14_DIRTY_TILE_SHIFT;
+    row = buf->dirty_tiles + ty0 * buf->dirty_tiles_wide + tx0;
+    for (; ty0 <= ty1; ty0++, row += buf->dirty_tiles_wide)
+        memset(row, 1, tx1 - tx0 + 1);
+}
+
+void
+pdf14_dirty_runs_init(pdf14_dirty_runs_t *runs, const pdf14_buf *buf,
+                      const gs_int_rect *bounds)
+{
+    runs->buf = buf;
+    runs->bounds = *bounds;
+    runs->tx = runs->ty = 0;
+    if (buf->dirty_tiles != NULL) {
+        rect_intersect(runs->bounds, buf->rect);
+        if (runs->bounds.p.x < runs->bounds.q.x) {
+            runs->tx = (runs->bounds.p.x - buf->rect.p.x) >> PDF14_DIRTY_TILE_SHIFT;
+            runs->ty = (runs->bounds.p.y - buf->rect.p.y) >> PDF14_DIRTY_TILE_SHIFT;
+        }
+    }
+}
+
+/*
+ * Return the next run of marked tiles along a row of tiles, clipped to the
+ * bounds.  Rows that are marked right across the bounds are returned
+ * together as a single rectangle.
+ */
+bool
+pdf14_dirty_runs_next(pdf14_dirty_runs_t *runs, gs_int_rect *r)
+{
+    const pdf14_buf *buf = runs->buf;
+    const gs_int_rect *bounds = &runs->bounds;
+    int tx_first, tx_end, ty_end;
+
+    if (bounds->p.x >= bounds->q.x || bounds->p.y >= bounds->q.y)
+        return false;
+    if (buf->dirty_tiles == NULL) {
+        /* No tiles, so all of the bounds counts as marked. */
+        *r = *bounds;
+        runs->bounds.q.y = runs->bounds.p.y;
+        return true;
+    }
+    tx_first = (bounds->p.x - buf->rect.p.x) >> PDF14_DIRTY_TILE_SHIFT;
+    tx_end = ((bounds->q.x - buf->rect.p.x - 1) >> PDF14_DIRTY_TILE_SHIFT) + 1;
+    ty_end = ((bounds->q.y - buf->rect.p.y - 1) >> PDF14_DIRTY_TILE_SHIFT) + 1;
+    for (; runs->ty < ty_end; runs->ty++, runs->tx = tx_first) {
+        const byte *row = buf->dirty_tiles + runs->ty * buf->dirty_tiles_wide;
+        int tx0 = runs->tx, tx1, ty1 = runs->ty + 1;
+
+        while (tx0 < tx_end && !row[tx0])
+            tx0++;
+        if (tx0 == tx_end)
+            continue;
+        tx1 = tx0 + 1;
+        while (tx1 < tx_end && row[tx1])
+            tx1++;
+        if (tx0 == tx_first && tx1 == tx_end) {
+            /* Take in any following rows that are marked all the way across. */
+            for (; ty1 < ty_end; ty1++) {
+                const byte *next = buf->dirty_tiles + ty1 * buf->dirty_tiles_wide;
+                int tx;
+
+                for (tx = tx_first; tx < tx_end && next[tx]; tx++)
+                    DO_NOTHING;
+                if (tx < tx_end)
+                    break;
+            }
+        }
+        r->p.x = max(buf->rect.p.x + (tx0 << PDF14_DIRTY_TILE_SHIFT), bounds->p.x);
+        r->q.x = min(buf->rect.p.x + (tx1 << PDF14_DIRTY_TILE_SHIFT), bounds->q.x);
+        r->p.y = max(buf->rect.p.y + (runs->ty << PDF14_DIRTY_TILE_SHIFT), bounds->p.y);
+        r->q.y = min(buf->rect.p.y + (ty1 << PDF14_DIRTY_TILE_SHIFT), bounds->q.y);
+        if (ty1 > runs->ty + 1) {
+            runs->ty = ty1;
+            runs->tx = tx_first;
+        } else
+            runs->tx = tx1;
+        return true;
+    }
+    return false;
+}
+
 static	void
 pdf14_buf_free(pdf14_buf *buf)
 {
@@ -1183,6 +1314,7 @@ pdf14_buf_free(pdf14_buf *buf)
     gs_free_object(memory, buf->transfer_fn, "pdf14_buf_free");
     gs_free_object(memory, buf->matte, "pdf14_buf_free");
     gs_free_object(memory, buf->data, "pdf14_buf_free");
+    gs_free_object(memory, buf->dirty_tiles, "pdf14_buf_free");
 
     while (old_parent_color_info) {
        if (old_parent_color_info->icc_profile != NULL) {
@@ -1467,6 +1599,8 @@ pdf14_pop_transparency_group(gs_gstate *pgs, pdf14_ctx *ctx,
     pdf14_mask_t *mask_stack = tos->mask_stack;
     pdf14_buf *maskbuf;
     int x0, x1, y0, y1;
+    gs_int_rect bounds, r;
+    pdf14_dirty_runs_t runs;
     int nos_num_color_comp;
     bool icc_match;
     pdf14_device *pdev = (pdf14_device *)dev;
@@ -1502,6 +1636,11 @@ pdf14_pop_transparency_group(gs_gstate *pgs, pdf14_ctx *ctx,
     y1 = min(tos->dirty.q.y, nos->rect.q.y);
     x0 = max(tos->dirty.p.x, nos->rect.p.x);
     x1 = min(tos->dirty.q.x, nos->rect.q.x);
+    /* Of that, only the tiles of tos that were marked need composing. */
+    bounds.p.x = x0;
+    bounds.p.y = y0;
+    bounds.q.x = x1;
+    bounds.q.y = y1;
     if (ctx->mask_stack) {
         /* This can occur when we have a situation where we are ending out of
            a group that has internal to it a soft mask and another group.
@@ -1579,17 +1718,23 @@ pdf14_pop_transparency_group(gs_gstate *pgs, pdf14_ctx *ctx,
                             ctx->stack->deep);
 #endif
              /* compose. never do overprint in this case */
-            pdf14_compose_group(tos, nos, maskbuf, x0, x1, y0, y1, nos->n_chan,
-                 nos->parent_color_info->isadditive,
-                 nos->parent_color_info->parent_blending_procs,
-                 has_matte, false, drawn_comps, ctx->memory, dev);
+            pdf14_dirty_runs_init(&runs, tos, &bounds);
+            while (pdf14_dirty_runs_next(&runs, &r))
+                pdf14_compose_group(tos, nos, maskbuf, r.p.x, r.q.x, r.p.y, r.q.y,
+                     nos->n_chan, nos->parent_color_info->isadditive,
+                     nos->parent_color_info->parent_blending_procs,
+                     has_matte, false, drawn_comps, ctx->memory, dev);
         }
     } else {
         /* Group color spaces are the same.  No color conversions needed */
-        if (x0 < x1 && y0 < y1)
-            pdf14_compose_group(tos, nos, maskbuf, x0, x1, y0, y1, nos->n_chan,
-                                ctx->additive, pblend_procs, has_matte, overprint,
-                                drawn_comps, ctx->memory, dev);
+        if (x0 < x1 && y0 < y1) {
+            pdf14_dirty_runs_init(&runs, tos, &bounds);
+            while (pdf14_dirty_runs_next(&runs, &r))
+                pdf14_compose_group(tos, nos, maskbuf, r.p.x, r.q.x, r.p.y, r.q.y,
+                                    nos->n_chan, ctx->additive, pblend_procs,
+                                    has_matte, overprint, drawn_comps,
+                                    ctx->memory, dev);
+        }
     }
 exit:
     ctx->stack = nos;
@@ -1735,6 +1880,28 @@ static void pdf14_free_mask_stack(pdf14_ctx *ctx, gs_memory_t *memory)
     ctx->mask_stack = NULL;
 }
 
+/* Return true if all the pixels of buf within its rect are the same. */
+static bool
+pdf14_buf_is_constant(const pdf14_buf *buf)
+{
+    int width = (buf->rect.q.x - buf->rect.p.x) << buf->deep;
+    int height = buf->rect.q.y - buf->rect.p.y;
+    int pixel_mask = buf->deep ? 1 : 0;
+    int i, x, y;
+
+    for (i = 0; i < buf->n_planes; i++) {
+        const byte *row = buf->data + i * buf->planestride;
+
+        for (x = pixel_mask + 1; x < width; x++)
+            if (row[x] != row[x & pixel_mask])
+                return false;
+        for (y = 1; y < height; y++)
+            if (memcmp(row + y * buf->rowstride, row, width) != 0)
+                return false;
+    }
+    return true;
+}
+
 static	int
 pdf14_pop_transparency_mask(pdf14_ctx *ctx, gs_gstate *pgs, gx_device *dev)
 {
@@ -1747,6 +1914,8 @@ pdf14_pop_transparency_mask(pdf14_ctx *ctx, gs_gstate *pgs, gx_device *dev)
     gsicc_link_t *icc_link;
     gsicc_rendering_param_t render_cond;
     cmm_dev_profile_t *dev_profile;
+    int height = tos->rect.q.y - tos->rect.p.y;
+    bool constant;
 
     dev_proc(dev, get_profile)(dev,  &dev_profile);
     gsicc_extract_profile(GS_UNKNOWN_TAG, dev_profile, &src_profile,
@@ -1804,6 +1973,23 @@ pdf14_pop_transparency_mask(pdf14_ctx *ctx, gs_gstate *pgs, gx_device *dev)
         }
         ctx->smask_blend = false;  /* just in case */
     } else {
+        /* A mask whose contents are the same all over, such as one with a
+           single colour filling it, or nothing drawn in it at all, is
+           common. There is no need to map all of it, and we keep just one
+           row of the result, with a rowstride of 0 so that it is used for
+           every row. To map a single row we move the first row of each
+           plane down next to each other, which leaves the buffer looking
+           like one with a height of 1. */
+        constant = pdf14_buf_is_constant(tos);
+        if (constant) {
+            int i;
+
+            for (i = 1; i < tos->n_planes; i++)
+                memmove(tos->data + i * tos->rowstride,
+                        tos->data + i * tos->planestride, tos->rowstride);
+            tos->planestride = tos->rowstride;
+            height = 1;
+        }
         /* If we are already in the source space then there is no reason
            to do the transformation */
         /* Lets get this to a monochrome buffer and map it to a luminance only value */
@@ -1822,14 +2008,14 @@ pdf14_pop_transparency_mask(pdf14_ctx *ctx, gs_gstate *pgs, gx_device *dev)
            and we are all done */
         if (tos->SMask_SubType == TRANSPARENCY_MASK_Alpha) {
             ctx->smask_blend = false;  /* not used in this case */
-            smask_copy(tos->rect.q.y - tos->rect.p.y,
+            smask_copy(height,
                        (tos->rect.q.x - tos->rect.p.x)<<tos->deep,
                        tos->rowstride,
                        (tos->data)+tos->planestride, new_data_buf);
 #if RAW_DUMP
             /* Dump the current buffer to see what we have. */
             dump_raw_buffer(ctx->memory,
-                            tos->rect.q.y-tos->rect.p.y,
+                            height,
                             tos->rowstride>>tos->deep, tos->n_planes,
                             tos->planestride, tos->rowstride,
                             "SMask_Pop_Alpha(Mask_Plane1)",tos->data,
@@ -1841,7 +2027,7 @@ pdf14_pop_transparency_mask(pdf14_ctx *ctx, gs_gstate *pgs, gx_device *dev)
 #if RAW_DUMP
                 /* Dump the current buffer to see what we have. */
                 dump_raw_buffer(ctx->memory,
-                                tos->rect.q.y-tos->rect.p.y,
+                                height,
                                 tos->rowstride>>tos->deep, tos->n_planes,
                                 tos->planestride, tos->rowstride,
                                 "SMask_Pop_Lum(Mask_Plane0)",tos->data,
@@ -1859,25 +2045,25 @@ pdf14_pop_transparency_mask(pdf14_ctx *ctx, gs_gstate *pgs, gx_device *dev)
                    ever has a alpha value not 1 so that we could detect and
                    avoid this blend if not needed. */
                 smask_blend(tos->data, tos->rect.q.x - tos->rect.p.x,
-                            tos->rect.q.y - tos->rect.p.y, tos->rowstride,
+                            height, tos->rowstride,
                             tos->planestride, tos->deep);
 #if RAW_DUMP
                 /* Dump the current buffer to see what we have. */
                 dump_raw_buffer(ctx->memory,
-                                tos->rect.q.y-tos->rect.p.y,
+                                height,
                                 tos->rowstride>>tos->deep, tos->n_planes,
                                 tos->planestride, tos->rowstride,
                                 "SMask_Pop_Lum_Post_Blend",tos->data,
                                 tos->deep);
                 global_index++;
 #endif
-                smask_copy(tos->rect.q.y - tos->rect.p.y,
+                smask_copy(height,
                            (tos->rect.q.x - tos->rect.p.x)<<tos->deep,
                            tos->rowstride, tos->data, new_data_buf);
             } else {
                 if ( icc_match == -1 ) {
                     /* The slow old fashioned way */
-                    smask_luminosity_mapping(tos->rect.q.y - tos->rect.p.y ,
+                    smask_luminosity_mapping(height ,
                         tos->rect.q.x - tos->rect.p.x,tos->n_chan,
                         tos->rowstride, tos->planestride,
                         tos->data,  new_data_buf, ctx->additive, tos->SMask_SubType,
@@ -1897,7 +2083,7 @@ pdf14_pop_transparency_mask(pdf14_ctx *ctx, gs_gstate *pgs, gx_device *dev)
                     rendering_params.cmm = gsCMM_DEFAULT;
                     icc_link = gsicc_get_link_profile(pgs, dev, des_profile,
                         src_profile, &rendering_params, pgs->memory, false);
-                    smask_icc(dev, tos->rect.q.y - tos->rect.p.y,
+                    smask_icc(dev, height,
                               tos->rect.q.x - tos->rect.p.x, tos->n_chan,
                               tos->rowstride, tos->planestride,
                               tos->data, new_data_buf, icc_link, tos->deep);
@@ -1912,6 +2098,8 @@ pdf14_pop_transparency_mask(pdf14_ctx *ctx, gs_gstate *pgs, gx_device *dev)
         /* Data is single channel now */
         tos->n_chan = 1;
         tos->n_planes = 1;
+        if (constant)
+            tos->rowstride = 0;
         /* Assign as reference counted mask buffer */
         if (ctx->mask_stack != NULL) {
             /* In this case, the source file is wacky as it already had a
@@ -1955,7 +2143,10 @@ pdf14_push_transparency_state(gx_device *dev, gs_gstate *pgs)
     pdf14_device *pdev = (pdf14_device *)dev;
     pdf14_ctx *ctx = pdev->ctx;
     pdf14_mask_t *new_mask;
+    int code = pdf14_text_group_settle(pdev);
 
+    if (code < 0)
+        return code;
     if_debug0m('v', ctx->memory, "pdf14_push_transparency_state\n");
     /* We need to push the current mask buffer   */
     /* Allocate a new element for the stack.
@@ -1982,7 +2173,10 @@ pdf14_pop_transparency_state(gx_device *dev, gs_gstate *pgs)
     pdf14_device *pdev = (pdf14_device *)dev;
     pdf14_ctx *ctx = pdev->ctx;
     pdf14_mask_t *old_mask;
+    int code = pdf14_text_group_settle(pdev);
 
+    if (code < 0)
+        return code;
     if_debug0m('v', ctx->memory, "pdf14_pop_transparency_state\n");
     /* rc decrement the current link after we break it from
        the list, then free the stack element.  Don't do
@@ -2034,6 +2228,7 @@ pdf14_open(gx_device *dev)
         return_error(gs_error_VMerror);
     pdev->free_devicen = true;
     pdev->text_group = PDF14_TEXTGROUP_NO_BT;
+    pdev->text_group_deferred = false;
     return 0;
 }
 
@@ -2092,10 +2287,14 @@ pdf14_get_buffer_information(const gx_device * dev,
     pdf14_buf *buf;
     gs_int_rect rect;
     int x1,y1,width,height;
+    int code;
 
     if ( pdev->ctx == NULL){
         return 0;  /* this can occur if the pattern is a clist */
     }
+    code = pdf14_text_group_settle((pdf14_device *)dev);
+    if (code < 0)
+        return code;
 #ifdef DEBUG
     pdf14_debug_mask_stack_state(pdev->ctx);
 #endif
@@ -2230,26 +2429,17 @@ pdf14_get_buffer_information(const gx_device * dev,
 typedef void(*blend_image_row_proc_t) (const byte *gs_restrict buf_ptr,
     int planestride, int width, int num_comp, uint16_t bg, byte *gs_restrict linebuf);
 
-/**
- * pdf14_put_image: Put rendered image to target device.
- * @pdev: The PDF 1.4 rendering device.
- * @pgs: State for image draw operation.
- * @target: The target device.
- *
- * Puts the rendered image in @pdev's buffer to @target. This is called
- * as part of the sequence of popping the PDF 1.4 device filter.
- *
- * Return code: negative on error.
- **/
+/* Put the rectangle prect of the rendered image to the target device. */
 static	int
-pdf14_put_image(gx_device * dev, gs_gstate * pgs, gx_device * target)
+pdf14_put_image_rect(gx_device * dev, gs_gstate * pgs, gx_device * target,
+                     const gs_int_rect *prect)
 {
     const pdf14_device * pdev = (pdf14_device *)dev;
     int code;
     gs_image1_t image;
     gx_image_enum_common_t *info;
     pdf14_buf *buf = pdev->ctx->stack;
-    gs_int_rect rect = buf->rect;
+    gs_int_rect rect = *prect;
     int y;
     int num_comp = buf->n_chan - 1;
     byte *linebuf, *linebuf_unaligned;
@@ -2271,12 +2461,6 @@ pdf14_put_image(gx_device * dev, gs_gstate * pgs, gx_device * target)
     int rowstride = buf->rowstride;
     blend_image_row_proc_t blend_row;
 
-    /* Make sure that this is the only item on the stack. Fuzzing revealed a
-       potential problem. Bug 694190 */
-    if (buf->saved != NULL) {
-        return gs_throw(gs_error_unknownerror, "PDF14 device push/pop out of sync");
-    }
-    if_debug0m('v', dev->memory, "[v]pdf14_put_image\n");
     rect_intersect(rect, buf->dirty);
     x1 = min(pdev->width, rect.q.x);
     y1 = min(pdev->height, rect.q.y);
@@ -2555,6 +2739,46 @@ pdf14_put_image(gx_device * dev, gs_gstate * pgs, gx_device * target)
     return code;
 }
 
+/**
+ * pdf14_put_image: Put rendered image to target device.
+ * @pdev: The PDF 1.4 rendering device.
+ * @pgs: State for image draw operation.
+ * @target: The target device.
+ *
+ * Puts the rendered image in @pdev's buffer to @target. This is called
+ * as part of the sequence of popping the PDF 1.4 device filter.
+ *
+ * Only the tiles of the buffer that were marked are put, except when
+ * a blending color space is in use: the color conversion replaces the
+ * buffer, so it can only be done once, for the whole of the dirty area.
+ *
+ * Return code: negative on error.
+ **/
+static	int
+pdf14_put_image(gx_device * dev, gs_gstate * pgs, gx_device * target)
+{
+    const pdf14_device * pdev = (pdf14_device *)dev;
+    pdf14_buf *buf = pdev->ctx->stack;
+    pdf14_dirty_runs_t runs;
+    gs_int_rect rect;
+    int code = 0;
+
+    /* Make sure that this is the only item on the stack. Fuzzing revealed a
+       potential problem. Bug 694190 */
+    if (buf->saved != NULL) {
+        return gs_throw(gs_error_unknownerror, "PDF14 device push/pop out of sync");
+    }
+    if_debug0m('v', dev->memory, "[v]pdf14_put_image\n");
+    if (pdev->using_blend_cs)
+        return pdf14_put_image_rect(dev, pgs, target, &buf->rect);
+    rect = buf->rect;
+    rect_intersect(rect, buf->dirty);
+    pdf14_dirty_runs_init(&runs, buf, &rect);
+    while (code >= 0 && pdf14_dirty_runs_next(&runs, &rect))
+        code = pdf14_put_image_rect(dev, pgs, target, &rect);
+    return code;
+}
+
 /**
  * pdf14_cmykspot_put_image: Put rendered image to target device.
  * @pdev: The PDF 1.4 rendering device.
@@ -2581,6 +2805,8 @@ pdf14_cmykspot_put_image(gx_device * dev, gs_gstate * pgs, gx_device * target)
     const uint16_t bg = pdev->ctx->additive ? 65535 : 0;
     int num_comp = buf->n_chan - 1;
     byte *buf_ptr;
+    pdf14_dirty_runs_t runs;
+    int code = 0;
 
     /* Make sure that this is the only item on the stack. Fuzzing revealed a
        potential problem. Bug 694190 */
@@ -2595,7 +2821,6 @@ pdf14_cmykspot_put_image(gx_device * dev, gs_gstate * pgs, gx_device * target)
     height = y1 - rect.p.y;
     if (width <= 0 || height <= 0 || buf->data == NULL)
         return 0;
-    buf_ptr = buf->data + rect.p.y * buf->rowstride + (rect.p.x<<deep);
 #if RAW_DUMP
     /* Dump the current buffer to see what we have. */
     dump_raw_buffer(pdev->ctx->memory,
@@ -2609,9 +2834,17 @@ pdf14_cmykspot_put_image(gx_device * dev, gs_gstate * pgs, gx_device * target)
     global_index++;
     clist_band_count++;
 #endif
-    return gx_put_blended_image_cmykspot(target, buf_ptr, planestride, rowstride,
-                      rect.p.x, rect.p.y, width, height, num_comp, bg,
-                      buf->has_tags, rect, pseparations, deep);
+    /* Only put the tiles that were marked. */
+    rect.q.x = x1;
+    rect.q.y = y1;
+    pdf14_dirty_runs_init(&runs, buf, &rect);
+    while (code >= 0 && pdf14_dirty_runs_next(&runs, &rect)) {
+        buf_ptr = buf->data + rect.p.y * buf->rowstride + (rect.p.x<<deep);
+        code = gx_put_blended_image_cmykspot(target, buf_ptr, planestride, rowstride,
+                      rect.p.x, rect.p.y, rect.q.x - rect.p.x, rect.q.y - rect.p.y,
+                      num_comp, bg, buf->has_tags, rect, pseparations, deep);
+    }
+    return code;
 }
 
 /**
@@ -2706,6 +2939,7 @@ pdf14_close(gx_device *dev)
         pdf14_ctx_free(pdev->ctx);
         pdev->ctx = NULL;
     }
+    pdev->text_group_deferred = false;
     return 0;
 }
 
@@ -2767,6 +3001,7 @@ pdf14_discard_trans_layer(gx_device *dev, gs_gstate * pgs)
         gs_free_object (ctx->memory, ctx, "pdf14_discard_trans_layer");
         pdev->ctx = NULL;
     }
+    pdev->text_group_deferred = false;
     return 0;
 }
 
@@ -3036,6 +3271,9 @@ pdf14_fill_path(gx_device *dev,	const gs_gstate *pgs,
 
     if (pdcolor == NULL)
        return_error(gs_error_unknownerror);	/* color must be defined */
+    code = pdf14_text_group_settle((pdf14_device *)dev);
+    if (code < 0)
+        return code;
     if (gx_dc_is_pattern1_color(pdcolor)){
         if( gx_pattern1_get_transptr(pdcolor) != NULL ||
             gx_pattern1_clist_has_trans(pdcolor) ){
@@ -3160,6 +3398,9 @@ pdf14_stroke_path(gx_device *dev, const	gs_gstate	*pgs,
 
     if (pdcolor == NULL)
        return_error(gs_error_unknownerror);	/* color must be defined */
+    code = pdf14_text_group_settle((pdf14_device *)dev);
+    if (code < 0)
+        return code;
     if (gx_dc_is_pattern2_color(pdcolor)) {
         /* Non-idempotent blends require a transparency
          * group to be pushed because shadings might
@@ -3257,6 +3498,9 @@ pdf14_fill_stroke_path(gx_device *dev, const gs_gstate *cpgs, gx_path *ppath,
     if ((pgs->fillconstantalpha == 0.0 && pgs->strokeconstantalpha == 0.0) ||
         (pgs->ctm.xx == 0.0 && pgs->ctm.xy == 0.0 && pgs->ctm.yx == 0.0 && pgs->ctm.yy == 0.0))
         return 0;
+    code = pdf14_text_group_settle(p14dev);
+    if (code < 0)
+        return code;
 
     opacity = pgs->opacity.alpha;
     blend_mode = pgs->blend_mode;
@@ -3498,10 +3742,7 @@ do_pdf14_copy_alpha_color(gx_device * dev, const byte * data, int data_x,
     if (x + w > buf->rect.q.x) w = buf->rect.q.x - x;
     if (y + h > buf->rect.q.y) h = buf->rect.q.y - y;
     /* Update the dirty rectangle. */
-    if (x < buf->dirty.p.x) buf->dirty.p.x = x;
-    if (y < buf->dirty.p.y) buf->dirty.p.y = y;
-    if (x + w > buf->dirty.q.x) buf->dirty.q.x = x + w;
-    if (y + h > buf->dirty.q.y) buf->dirty.q.y = y + h;
+    pdf14_buf_mark_dirty(buf, x, y, w, h);
     line = buf->data + (x - buf->rect.p.x) + (y - buf->rect.p.y) * rowstride;
 
     for (j = 0; j < h; ++j, aa_row += aa_raster) {
@@ -3685,10 +3926,7 @@ do_pdf14_copy_alpha_color_16(gx_device * dev, const byte * data, int data_x,
     if (x + w > buf->rect.q.x) w = buf->rect.q.x - x;
     if (y + h > buf->rect.q.y) h = buf->rect.q.y - y;
     /* Update the dirty rectangle. */
-    if (x < buf->dirty.p.x) buf->dirty.p.x = x;
-    if (y < buf->dirty.p.y) buf->dirty.p.y = y;
-    if (x + w > buf->dirty.q.x) buf->dirty.q.x = x + w;
-    if (y + h > buf->dirty.q.y) buf->dirty.q.y = y + h;
+    pdf14_buf_mark_dirty(buf, x, y, w, h);
     line = buf->data + (x - buf->rect.p.x)*2 + (y - buf->rect.p.y) * rowstride;
 
     planestride >>= 1;
@@ -3805,7 +4043,10 @@ pdf14_copy_alpha_color(gx_device * dev, const byte * data, int data_x,
                       int depth, bool devn)
 {
     bool deep = device_is_deep(dev);
+    int code = pdf14_text_group_settle((pdf14_device *)dev);
 
+    if (code < 0)
+        return code;
     if (deep)
         return do_pdf14_copy_alpha_color_16(dev, data, data_x, aa_raster,
                                             id, x, y, w, h,
@@ -3835,6 +4076,9 @@ pdf14_fill_mask(gx_device * orig_dev,
 
     if (pdcolor == NULL)
         return_error(gs_error_unknownerror);	/* color must be defined */
+    code = pdf14_text_group_settle(p14dev);
+    if (code < 0)
+        return code;
     /* If we are doing a fill with a pattern that has a transparency then
        go ahead and do a push and a pop of the transparency group */
     if (gx_dc_is_pattern1_color(pdcolor)) {
@@ -4295,8 +4539,10 @@ pdf14_begin_typed_image(gx_device * dev, const gs_gstate * pgs,
                            gx_image_enum_common_t ** pinfo)
 {
     const gs_image_t *pim = (const gs_image_t *)pic;
-    int code;
+    int code = pdf14_text_group_settle((pdf14_device *)dev);
 
+    if (code < 0)
+        return code;
     /* If we are filling an image mask with a pattern that has a transparency
        then we need to do some special handling */
     if (pim->ImageMask) {
@@ -4758,6 +5004,138 @@ pdf14_recreate_device(gs_memory_t *mem,	gs_gstate	* pgs,
     return dev_proc(pdev, open_device)(dev);
 }
 
+/*
+ * Consecutive text runs (BT/ET pairs) that each need a text group (see
+ * pdf14_text_begin) share a single group, rather than pushing and popping a
+ * page sized knockout group for every run.  At the ET the pop of the group
+ * is deferred, and if the next thing to happen is a text run that needs an
+ * identical group, it carries on with the same one; anything else pops it
+ * first.
+ *
+ * This is done at the entry to the device procedures rather than by the
+ * code that writes to the buffers: every procedure that draws, or that
+ * hands out or changes the stack, calls pdf14_text_group_settle before it
+ * looks at ctx->stack, as does every compositor other than the ones that
+ * open the next text run.  So nothing can be drawn into the parent while a
+ * pop is pending, and when the group is taken up again what the earlier
+ * runs drew can be composed into the parent and the group started afresh
+ * from the result (pdf14_text_group_rebase), just as popping and pushing
+ * it again would have done.
+ */
+
+/* Whether the pop of the text group on the top of the stack can wait. */
+static bool
+pdf14_text_group_can_defer(pdf14_device *pdev, const gs_gstate *pgs)
+{
+    pdf14_ctx *ctx = pdev->ctx;
+    pdf14_buf *tos = ctx->stack;
+    pdf14_buf *nos = tos->saved;
+    pdf14_parent_color_t *parent_color;
+
+    if (nos == NULL || tos->data == NULL || tos->dirty_tiles == NULL ||
+        tos->idle || tos->isolated || !tos->knockout ||
+        (tos->mask_stack != NULL && tos->mask_stack->rc_mask != NULL &&
+         tos->mask_stack->rc_mask->mask_buf != NULL) ||
+        ctx->mask_stack != NULL ||
+        nos->knockout || pdev->overprint)
+        return false;
+    /* The pop must leave the colour state as it is, so that nothing else
+       can tell that it hasn't happened yet. */
+    parent_color = nos->parent_color_info;
+    return parent_color->parent_color_mapping_procs ==
+               dev_proc(pdev, get_color_mapping_procs) &&
+           parent_color->parent_color_comp_index ==
+               dev_proc(pdev, get_color_comp_index) &&
+           parent_color->parent_blending_procs == pdev->blend_procs &&
+           parent_color->unpack_procs == pdev->pdf14_procs &&
+           parent_color->isadditive == ctx->additive &&
+           parent_color->polarity == pdev->color_info.polarity &&
+           parent_color->num_components == pdev->color_info.num_components &&
+           parent_color->depth == pdev->color_info.depth &&
+           parent_color->max_color == pdev->color_info.max_color &&
+           parent_color->max_gray == pdev->color_info.max_gray &&
+           !memcmp(parent_color->comp_bits, pdev->color_info.comp_bits,
+                   GX_DEVICE_COLOR_MAX_COMPONENTS) &&
+           !memcmp(parent_color->comp_shift, pdev->color_info.comp_shift,
+                   GX_DEVICE_COLOR_MAX_COMPONENTS) &&
+           parent_color->icc_profile == pdev->icc_struct->device_profile[0] &&
+           parent_color->get_cmap_procs == pgs->get_cmap_procs &&
+           pgs->cmap_procs == gx_get_cmap_procs(pgs, (gx_device *)pdev);
+}
+
+/*
+ * Whether a new text group would be the same as the deferred one.  The
+ * colour space is the same, as nothing has been pushed in the meantime.
+ */
+static bool
+pdf14_text_group_can_resume(pdf14_device *pdev,
+                            const gs_transparency_group_params_t *ptgp,
+                            const gs_gstate *pgs)
+{
+    pdf14_buf *tos = pdev->ctx->stack;
+    double alpha = pgs->opacity.alpha * pgs->shape.alpha;
+
+    return !ptgp->Isolated && ptgp->Knockout && !ptgp->idle &&
+           ptgp->group_color == UNKNOWN && ptgp->mask_id == tos->mask_id &&
+           pdev->ctx->mask_stack == NULL &&
+           tos->alpha == (uint16_t)floor(65535 * alpha + 0.5) &&
+           tos->shape == (uint16_t)floor(65535 * pgs->shape.alpha + 0.5) &&
+           tos->blend_mode == pgs->blend_mode;
+}
+
+/*
+ * Compose what the earlier runs drew into the parent, and start the group
+ * again from the result.  Those runs ended without overprint.
+ */
+static void
+pdf14_text_group_rebase(pdf14_device *pdev)
+{
+    pdf14_ctx *ctx = pdev->ctx;
+    pdf14_buf *tos = ctx->stack;
+    pdf14_buf *nos = tos->saved;
+    gx_color_index drawn_comps = pdev->drawn_comps_stroke | pdev->drawn_comps_fill;
+    gs_int_rect r = tos->dirty;
+    int tiles_high = (tos->rect.q.y - tos->rect.p.y +
+                      (1 << PDF14_DIRTY_TILE_SHIFT) - 1) >> PDF14_DIRTY_TILE_SHIFT;
+
+    rect_intersect(r, tos->rect);
+    rect_intersect(r, nos->rect);
+    if (r.p.x < r.q.x && r.p.y < r.q.y) {
+        pdf14_compose_group(tos, nos, NULL, r.p.x, r.q.x, r.p.y, r.q.y,
+                            nos->n_chan, ctx->additive, pdev->blend_procs,
+                            false, false, drawn_comps, ctx->memory,
+                            (gx_device *)pdev);
+        pdf14_preserve_backdrop_rect(tos, nos, &r);
+    }
+    /* Nothing has been drawn into the group since, as pdf14_buf_new has it. */
+    memset(tos->dirty_tiles, 0, tos->dirty_tiles_wide * tiles_high);
+    tos->dirty.p = tos->rect.q;
+    tos->dirty.q = tos->rect.p;
+}
+
+/* Pop a deferred text group, as it would have been at its ET. */
+static int
+pdf14_text_group_flush(pdf14_device *pdev)
+{
+    bool overprint = pdev->overprint;
+    int code;
+
+    pdev->text_group_deferred = false;
+    pdev->overprint = false;
+    code = pdf14_end_transparency_group((gx_device *)pdev, NULL);
+    pdev->overprint = overprint;
+    return code;
+}
+
+/* Pop the text group if its pop was deferred. */
+static int
+pdf14_text_group_settle(pdf14_device *pdev)
+{
+    if (pdev->text_group_deferred)
+        return pdf14_text_group_flush(pdev);
+    return 0;
+}
+
 /*
  * Implement the various operations that can be specified via the PDF 1.4
  * create compositor request.
@@ -4771,6 +5149,18 @@ gx_update_pdf14_compositor(gx_device * pdev, gs_gstate * pgs,
     int code = 0;
 
     params.idle = pdf14pct->idle;
+    /* Only the next text run can take over a text group whose pop was
+       deferred (see pdf14_begin_transparency_group), anything else needs
+       it out of the way first. */
+    if (params.pdf14_op != PDF14_SET_BLEND_PARAMS &&
+        params.pdf14_op != PDF14_BEGIN_TRANS_TEXT_GROUP &&
+        params.pdf14_op != PDF14_END_TRANS_TEXT_GROUP &&
+        !(params.pdf14_op == PDF14_BEGIN_TRANS_GROUP &&
+          params.text_group == PDF14_TEXTGROUP_BT_PUSHED)) {
+        code = pdf14_text_group_settle(p14dev);
+        if (code < 0)
+            return code;
+    }
     switch (params.pdf14_op) {
         default:			/* Should not occur. */
             break;
@@ -4839,8 +5229,12 @@ gx_update_pdf14_compositor(gx_device * pdev, gs_gstate * pgs,
                 p14dev->text_group = PDF14_TEXTGROUP_BT_NOT_PUSHED;
             break;
         case PDF14_END_TRANS_TEXT_GROUP:
-            if (p14dev->text_group == PDF14_TEXTGROUP_BT_PUSHED)
-                code = gx_end_transparency_group(pgs, pdev);
+            if (p14dev->text_group == PDF14_TEXTGROUP_BT_PUSHED) {
+                if (pdf14_text_group_can_defer(p14dev, pgs))
+                    p14dev->text_group_deferred = true;
+                else
+                    code = gx_end_transparency_group(pgs, pdev);
+            }
             p14dev->text_group = PDF14_TEXTGROUP_NO_BT; /* Hit ET */
             break;
         case PDF14_BEGIN_TRANS_MASK:
@@ -4939,7 +5333,10 @@ pdf14_create_compositor(gx_device * dev, gx_device * * pcdev,
                    See gx_spot_colors_set_overprint in gscspace for issues... */
                 const gs_overprint_t * op_pct = (const gs_overprint_t *) pct;
                 gx_color_index drawn_comps;
+                int code = pdf14_text_group_settle(p14dev);
 
+                if (code < 0)
+                    return code;
                 p14dev->op_state = op_pct->params.op_state;
 
                 if (!p14dev->op_state) {
@@ -5012,8 +5409,19 @@ pdf14_text_begin(gx_device * dev, gs_gstate * pgs,
     bool blend_issue = !(blend_mode == BLEND_MODE_Normal || blend_mode == BLEND_MODE_Compatible || blend_mode == BLEND_MODE_CompatibleOverprint);
     pdf14_device *pdev = (pdf14_device*)dev;
     bool draw = !(text->operation & TEXT_DO_NONE);
+    bool push = gs_currenttextknockout(pgs) && (blend_issue || opacity != 1.0) &&
+                gs_currenttextrenderingmode(pgs) != 3 && /* don't bother with invisible text */
+                (pdev->text_group == PDF14_TEXTGROUP_BT_NOT_PUSHED ||
+                 pdev->text_group == PDF14_TEXTGROUP_MISSING_ET) && draw;
 
     if_debug0m('v', memory, "[v]pdf14_text_begin\n");
+    /* A run that pushes a text group may take over a deferred one (see
+       pdf14_begin_transparency_group), any other needs it popped. */
+    if (!push) {
+        code = pdf14_text_group_settle(pdev);
+        if (code < 0)
+            return code;
+    }
     pdf14_set_marking_params(dev, pgs);
     code = gx_default_text_begin(dev, pgs, text, font, path, pdcolor, pcpath,
                                  memory, &penum);
@@ -5044,13 +5452,8 @@ pdf14_text_begin(gx_device * dev, gs_gstate * pgs,
         pdev->text_group = PDF14_TEXTGROUP_BT_NOT_PUSHED;
     }
 
-    if (gs_currenttextknockout(pgs) && (blend_issue || opacity != 1.0) &&
-        gs_currenttextrenderingmode(pgs) != 3 && /* don't bother with invisible text */
-        pdev->text_group == PDF14_TEXTGROUP_BT_NOT_PUSHED)
-        if (draw) {
-            code = pdf14_push_text_group(dev, pgs, blend_mode, opacity,
-                false);
-        }
+    if (push)
+        code = pdf14_push_text_group(dev, pgs, blend_mode, opacity, false);
     *ppenum = (gs_text_enum_t *)penum;
     return code;
 }
@@ -5154,15 +5557,20 @@ pdf14_copy_planes(gx_device * dev, const byte * data, int data_x, int raster,
 #if RAW_DUMP
     pdf14_ctx *ctx = pdev->ctx;
 #endif
-    pdf14_buf *buf = pdev->ctx->stack;
+    pdf14_buf *buf;
     int xo = x;
     int yo = y;
     pdf14_buf fake_tos;
     int deep = pdev->ctx->deep;
+    int code;
 
+    code = pdf14_text_group_settle(pdev);
+    if (code < 0)
+        return code;
     fit_fill_xywh(dev, x, y, w, h);
     if (w <= 0 || h <= 0)
         return 0;
+    buf = pdev->ctx->stack;
 
     fake_tos.deep = deep;
     fake_tos.alpha = (uint16_t)(0xffff * pdev->alpha + 0.5);
@@ -5174,6 +5582,8 @@ pdf14_copy_planes(gx_device * dev, const byte * data, int data_x, int raster,
     fake_tos.dirty.p.y = y;
     fake_tos.dirty.q.x = x + w;
     fake_tos.dirty.q.y = y + h;
+    fake_tos.dirty_tiles = NULL;
+    fake_tos.dirty_tiles_wide = 0;
     fake_tos.has_alpha_g = 0;
     fake_tos.has_shape = 0;
     fake_tos.has_tags = 0;
@@ -5210,15 +5620,20 @@ pdf14_fill_rectangle_hl_color(gx_device *dev, const gs_fixed_rect *rect,
     const gx_clip_path *pcpath)
 {
     pdf14_device *pdev = (pdf14_device *)dev;
-    pdf14_buf *buf = pdev->ctx->stack;
+    pdf14_buf *buf;
     int x = fixed2int(rect->p.x);
     int y = fixed2int(rect->p.y);
     int w = fixed2int(rect->q.x) - x;
     int h = fixed2int(rect->q.y) -y;
+    int code;
 
+    code = pdf14_text_group_settle(pdev);
+    if (code < 0)
+        return code;
     fit_fill_xywh(dev, x, y, w, h);
     if (w <= 0 || h <= 0)
         return 0;
+    buf = pdev->ctx->stack;
     if (buf->knockout)
         return pdf14_mark_fill_rectangle_ko_simple(dev, x, y, w, h, 0, pdcolor,
                                                    true);
@@ -5226,16 +5641,154 @@ pdf14_fill_rectangle_hl_color(gx_device *dev, const gs_fixed_rect *rect,
         return pdf14_mark_fill_rectangle(dev, x, y, w, h, 0, pdcolor, true);
 }
 
+/*
+ * Write one run of a smooth shading straight into the buffer.  This is
+ * only used (see below) when the mark is opaque and Normal, in which case
+ * the composition reduces to replacing the backdrop with the source, so
+ * the result is the same as pdf14_mark_fill_rectangle's.
+ */
+static int
+pdf14_fill_span(gx_device *dev, int x, int y, int w, int h,
+                gx_color_index color)
+{
+    pdf14_device *pdev = (pdf14_device *)dev;
+    pdf14_buf *buf = pdev->ctx->stack;
+    int num_chan = buf->n_chan;
+    int num_comp = num_chan - 1;
+    int num_process = pdev->ctx->additive ? num_comp - buf->num_spots : 0;
+    int rowstride = buf->rowstride;
+    int planestride = buf->planestride;
+    int extra_off = num_chan * planestride;
+    int i, j, k;
+
+    fit_fill_xywh(dev, x, y, w, h);
+    if (x < buf->rect.p.x) {
+        w += x - buf->rect.p.x;
+        x = buf->rect.p.x;
+    }
+    if (y < buf->rect.p.y) {
+        h += y - buf->rect.p.y;
+        y = buf->rect.p.y;
+    }
+    if (x + w > buf->rect.q.x) w = buf->rect.q.x - x;
+    if (y + h > buf->rect.q.y) h = buf->rect.q.y - y;
+    if (w <= 0 || h <= 0)
+        return 0;
+    pdf14_buf_mark_dirty(buf, x, y, w, h);
+
+    if (buf->deep) {
+        uint16_t src[PDF14_MAX_PLANES];
+        uint16_t tag = 0;
+        uint16_t *line = (uint16_t *)(buf->data + (x - buf->rect.p.x) * 2 +
+                                      (y - buf->rect.p.y) * rowstride);
+
+        pdev->pdf14_procs->unpack_color16(num_comp, color, pdev, src);
+        for (k = 0; k < num_comp; k++)
+            if (k >= num_process)
+                src[k] = 65535 - src[k];
+        src[num_comp] = 65535;
+        if (buf->has_tags)
+            tag = (color >> (num_comp*16)) & 0xff;
+        planestride >>= 1;
+        rowstride >>= 1;
+        for (j = 0; j < h; j++, line += rowstride) {
+            uint16_t *dst_ptr = line;
+
+            for (k = 0; k < num_chan; k++, dst_ptr += planestride)
+                for (i = 0; i < w; i++)
+                    dst_ptr[i] = src[k];
+            if (buf->has_shape) {
+                for (i = 0; i < w; i++)
+                    dst_ptr[i] = 65535;
+                dst_ptr += planestride;
+            }
+            if (buf->has_alpha_g) {
+                for (i = 0; i < w; i++)
+                    dst_ptr[i] = 65535;
+                dst_ptr += planestride;
+            }
+            if (buf->has_tags)
+                for (i = 0; i < w; i++)
+                    dst_ptr[i] = tag;
+        }
+    } else {
+        byte src[PDF14_MAX_PLANES];
+        byte *line = buf->data + (x - buf->rect.p.x) +
+                     (y - buf->rect.p.y) * rowstride;
+
+        pdev->pdf14_procs->unpack_color(num_comp, color, pdev, src);
+        for (k = 0; k < num_comp; k++)
+            if (k >= num_process)
+                src[k] = 255 - src[k];
+        src[num_comp] = 255;
+        for (j = 0; j < h; j++, line += rowstride) {
+            byte *dst_ptr = line + extra_off;
+
+            for (k = 0; k < num_chan; k++)
+                memset(line + k * planestride, src[k], w);
+            if (buf->has_shape) {
+                memset(dst_ptr, 255, w);
+                dst_ptr += planestride;
+            }
+            if (buf->has_alpha_g) {
+                memset(dst_ptr, 255, w);
+                dst_ptr += planestride;
+            }
+            if (buf->has_tags)
+                memset(dst_ptr, (color >> (num_comp*8)) & 0xff, w);
+        }
+    }
+    return 0;
+}
+
+/*
+ * The default fill_linear_color_scanline breaks a scanline of a smooth
+ * shading into runs of a single color and sends each through
+ * fill_rectangle, which for us means unpacking the color and going through
+ * the general compositing loop for every few pixels.  When the mark is
+ * opaque, Normal, not overprinted and not into a knockout group, we can
+ * write the runs into the buffer directly instead.  The runs (and so the
+ * output) are exactly those of the default.
+ */
+static int
+pdf14_fill_linear_color_scanline(gx_device *dev, const gs_fill_attributes *fa,
+        int i0, int j, int w, const frac31 *c0, const int32_t *c0f,
+        const int32_t *cg_num, int32_t cg_den)
+{
+    pdf14_device *pdev = (pdf14_device *)dev;
+    pdf14_buf *buf;
+    bool overprint = pdev->op_state == PDF14_OP_STATE_FILL ?
+                     pdev->overprint : pdev->stroke_overprint;
+    int code = pdf14_text_group_settle(pdev);
+
+    if (code < 0)
+        return code;
+    buf = pdev->ctx->stack;
+    if (buf == NULL || buf->data == NULL || buf->knockout || overprint ||
+        pdev->blend_mode != BLEND_MODE_Normal || pdev->alpha != 1.0 ||
+        (buf->has_shape && pdev->shape != 1.0) ||
+        dev_proc(dev, dev_spec_op)(dev, gxdso_supports_devn, NULL, 0))
+        return gx_default_fill_linear_color_scanline(dev, fa, i0, j, w, c0,
+                                                     c0f, cg_num, cg_den);
+    return gx_fill_linear_color_scanline_runs(dev, fa, i0, j, w, c0, c0f,
+                                              cg_num, cg_den, pdf14_fill_span);
+}
+
 static	int
 pdf14_fill_rectangle(gx_device * dev,
                     int x, int y, int w, int h, gx_color_index color)
 {
     pdf14_device *pdev = (pdf14_device *)dev;
-    pdf14_buf *buf = pdev->ctx->stack;
+    pdf14_buf *buf;
+    int code;
 
+    code = pdf14_text_group_settle(pdev);
+    if (code < 0)
+        return code;
     fit_fill_xywh(dev, x, y, w, h);
     if (w <= 0 || h <= 0)
         return 0;
+    buf = pdev->ctx->stack;
     if (buf->knockout)
         return pdf14_mark_fill_rectangle_ko_simple(dev, x, y, w, h, color, NULL,
                                                    false);
@@ -5301,6 +5854,18 @@ pdf14_begin_transparency_group(gx_device *dev,
         return code;
     gsicc_extract_profile(GS_UNKNOWN_TAG, dev_profile, &tos_profile, &render_cond);
 
+    if (ptgp->text_group == PDF14_TEXTGROUP_BT_PUSHED &&
+        pdev->text_group_deferred &&
+        pdf14_text_group_can_resume(pdev, ptgp, pgs)) {
+        /* Carry on with the group of the previous text run */
+        pdf14_text_group_rebase(pdev);
+        pdev->text_group_deferred = false;
+        pdev->text_group = PDF14_TEXTGROUP_BT_PUSHED;
+        return 0;
+    }
+    code = pdf14_text_group_settle(pdev);
+    if (code < 0)
+        return code;
     if (ptgp->text_group == PDF14_TEXTGROUP_BT_PUSHED) {
         rect = pdev->ctx->rect; /* Use parent group for text_group. */
         pdev->text_group = PDF14_TEXTGROUP_BT_PUSHED;  /* For immediate mode and clist reading */
@@ -5393,8 +5958,12 @@ pdf14_end_transparency_group(gx_device *dev,
     parent_color = pdev->ctx->stack->parent_color_info;
     if (!(parent_color->parent_color_mapping_procs == NULL &&
           parent_color->parent_color_comp_index == NULL)) {
-        pgs->get_cmap_procs = parent_color->get_cmap_procs;
-        gx_set_cmap_procs(pgs, dev);
+        /* pgs is NULL when a deferred text group is popped, which left
+           the gstate as it was (see pdf14_text_group_can_defer). */
+        if (pgs != NULL) {
+            pgs->get_cmap_procs = parent_color->get_cmap_procs;
+            gx_set_cmap_procs(pgs, dev);
+        }
         set_dev_proc(pdev, get_color_mapping_procs, parent_color->parent_color_mapping_procs);
         set_dev_proc(pdev, get_color_comp_index, parent_color->parent_color_comp_index);
         pdev->color_info.polarity = parent_color->polarity;
@@ -6046,6 +6615,9 @@ pdf14_begin_transparency_mask(gx_device	*dev,
     gs_transparency_color_t group_color;
     bool deep = device_is_deep(dev);
 
+    code = pdf14_text_group_settle(pdev);
+    if (code < 0)
+        return code;
     if (ptmp->subtype == TRANSPARENCY_MASK_None) {
         pdf14_ctx *ctx = pdev->ctx;
 
@@ -6132,6 +6704,9 @@ pdf14_end_transparency_mask(gx_device *dev, gs_gstate *pgs)
     pdf14_parent_color_t *parent_color;
     int ok;
 
+    ok = pdf14_text_group_settle(pdev);
+    if (ok < 0)
+        return ok;
     if_debug0m('v', dev->memory, "pdf14_end_transparency_mask\n");
     ok = pdf14_pop_transparency_mask(pdev->ctx, pgs, dev);
 #ifdef DEBUG
@@ -6193,6 +6768,9 @@ do_mark_fill_rectangle_ko_simple(gx_device *dev, int x, int y, int w, int h,
     byte src[PDF14_MAX_PLANES];
     byte dst[PDF14_MAX_PLANES] = { 0 };
     byte dst2[PDF14_MAX_PLANES] = { 0 };
+    byte bd[PDF14_MAX_PLANES] = { 0 };
+    byte out[PDF14_MAX_PLANES];
+    bool have_out = false, keep_out;
     int rowstride = buf->rowstride;
     int planestride = buf->planestride;
     int num_chan = buf->n_chan;
@@ -6275,10 +6853,7 @@ do_mark_fill_rectangle_ko_simple(gx_device *dev, int x, int y, int w, int h,
     if (x + w > buf->rect.q.x) w = buf->rect.q.x - x;
     if (y + h > buf->rect.q.y) h = buf->rect.q.y - y;
     /* Update the dirty rectangle with the mark. */
-    if (x < buf->dirty.p.x) buf->dirty.p.x = x;
-    if (y < buf->dirty.p.y) buf->dirty.p.y = y;
-    if (x + w > buf->dirty.q.x) buf->dirty.q.x = x + w;
-    if (y + h > buf->dirty.q.y) buf->dirty.q.y = y + h;
+    pdf14_buf_mark_dirty(buf, x, y, w, h);
 
     /* composite with backdrop only. */
     if (has_backdrop)
@@ -6288,20 +6863,37 @@ do_mark_fill_rectangle_ko_simple(gx_device *dev, int x, int y, int w, int h,
 
     line = buf->data + (x - buf->rect.p.x) + (y - buf->rect.p.y) * rowstride;
 
+    /* Within a mark the result only depends on the backdrop pixel, so it
+       is computed again only when that changes. Without a backdrop it is
+       constant, except for the compatible overprint blend of a subtractive
+       non-isolated group, which (as dst2 isn't reloaded) accumulates. */
+    keep_out = has_backdrop || additive || !overprint;
     for (j = 0; j < h; ++j) {
         bg_ptr = bline;
         dst_ptr = line;
         for (i = 0; i < w; ++i) {
+            bool same = have_out;
+
+            if (has_backdrop) {
+                for (k = 0; k < num_chan; ++k) {
+                    if (bd[k] != bg_ptr[k * planestride]) {
+                        bd[k] = bg_ptr[k * planestride];
+                        same = false;
+                    }
+                }
+            }
+            if (same)
+                goto store;
             /* Complement the components for subtractive color spaces */
             if (has_backdrop) {
                 if (additive) {
                     for (k = 0; k < num_chan; ++k)
-                        dst[k] = bg_ptr[k * planestride];
+                        dst[k] = bd[k];
                 } else {
                     for (k = 0; k < num_comp; ++k)
-                        dst2[k] = dst[k] = 255 - bg_ptr[k * planestride];
+                        dst2[k] = dst[k] = 255 - bd[k];
                 }
-                dst2[num_comp] = dst[num_comp] = bg_ptr[num_comp * planestride];	/* alpha doesn't invert */
+                dst2[num_comp] = dst[num_comp] = bd[num_comp];	/* alpha doesn't invert */
             }
             if (buf->isolated || !has_backdrop) {
                 art_pdf_knockoutisolated_group_8(dst, src, num_comp);
@@ -6312,7 +6904,7 @@ do_mark_fill_rectangle_ko_simple(gx_device *dev, int x, int y, int w, int h,
             /* Complement the results for subtractive color spaces */
             if (additive) {
                 for (k = 0; k < num_chan; ++k)
-                    dst_ptr[k * planestride] = dst[k];
+                    out[k] = dst[k];
             } else {
                 if (overprint) {
                     /* We may have to do the compatible overprint blending */
@@ -6322,18 +6914,22 @@ do_mark_fill_rectangle_ko_simple(gx_device *dev, int x, int y, int w, int h,
                     }
                     for (k = 0, comps = drawn_comps; k < num_comp; ++k, comps >>= 1) {
                         if ((comps & 0x1) != 0) {
-                            dst_ptr[k * planestride] = 255 - dst[k];
+                            out[k] = 255 - dst[k];
                         } else {
                             /* Compatible overprint blend result. */
-                            dst_ptr[k * planestride] = 255 - dst2[k];
+                            out[k] = 255 - dst2[k];
                         }
                     }
                 } else {
                     for (k = 0; k < num_comp; ++k)
-                        dst_ptr[k * planestride] = 255 - dst[k];
+                        out[k] = 255 - dst[k];
                 }
-                dst_ptr[num_comp * planestride] = dst[num_comp];
+                out[num_comp] = dst[num_comp];
             }
+            have_out = keep_out;
+store:
+            for (k = 0; k < num_chan; ++k)
+                dst_ptr[k * planestride] = out[k];
             if (tag_off) {
                 /* FIXME: As we are knocking out, possibly, we should be
                  * always overwriting tag values here? */
@@ -6388,6 +6984,9 @@ do_mark_fill_rectangle_ko_simple16(gx_device *dev, int x, int y, int w, int h,
     uint16_t src[PDF14_MAX_PLANES];
     uint16_t dst[PDF14_MAX_PLANES] = { 0 };
     uint16_t dst2[PDF14_MAX_PLANES] = { 0 };
+    uint16_t bd[PDF14_MAX_PLANES] = { 0 };
+    uint16_t out[PDF14_MAX_PLANES];
+    bool have_out = false, keep_out;
     int rowstride = buf->rowstride;
     int planestride = buf->planestride;
     int num_chan = buf->n_chan;
@@ -6468,10 +7067,7 @@ do_mark_fill_rectangle_ko_simple16(gx_device *dev, int x, int y, int w, int h,
     if (x + w > buf->rect.q.x) w = buf->rect.q.x - x;
     if (y + h > buf->rect.q.y) h = buf->rect.q.y - y;
     /* Update the dirty rectangle with the mark. */
-    if (x < buf->dirty.p.x) buf->dirty.p.x = x;
-    if (y < buf->dirty.p.y) buf->dirty.p.y = y;
-    if (x + w > buf->dirty.q.x) buf->dirty.q.x = x + w;
-    if (y + h > buf->dirty.q.y) buf->dirty.q.y = y + h;
+    pdf14_buf_mark_dirty(buf, x, y, w, h);
 
 
     /* composite with backdrop only. */
@@ -6487,20 +7083,37 @@ do_mark_fill_rectangle_ko_simple16(gx_device *dev, int x, int y, int w, int h,
     shape_off >>= 1;
     tag_off >>= 1;
 
+    /* Within a mark the result only depends on the backdrop pixel, so it
+       is computed again only when that changes. Without a backdrop it is
+       constant, except for the compatible overprint blend of a subtractive
+       non-isolated group, which (as dst2 isn't reloaded) accumulates. */
+    keep_out = has_backdrop || additive || !overprint;
     for (j = 0; j < h; ++j) {
         bg_ptr = bline;
         dst_ptr = line;
         for (i = 0; i < w; ++i) {
+            bool same = have_out;
+
+            if (has_backdrop) {
+                for (k = 0; k < num_chan; ++k) {
+                    if (bd[k] != bg_ptr[k * planestride]) {
+                        bd[k] = bg_ptr[k * planestride];
+                        same = false;
+                    }
+                }
+            }
+            if (same)
+                goto store;
             /* Complement the components for subtractive color spaces */
             if (has_backdrop) {
                 if (additive) {
                     for (k = 0; k < num_chan; ++k)
-                        dst[k] = bg_ptr[k * planestride];
+                        dst[k] = bd[k];
                 } else {
                     for (k = 0; k < num_comp; ++k)
-                        dst2[k] = dst[k] = 65535 - bg_ptr[k * planestride];
+                        dst2[k] = dst[k] = 65535 - bd[k];
                 }
-                dst2[num_comp] = dst[num_comp] = bg_ptr[num_comp * planestride];	/* alpha doesn't invert */
+                dst2[num_comp] = dst[num_comp] = bd[num_comp];	/* alpha doesn't invert */
             }
             if (buf->isolated || !has_backdrop) {
                 art_pdf_knockoutisolated_group_16(dst, src, num_comp);
@@ -6511,7 +7124,7 @@ do_mark_fill_rectangle_ko_simple16(gx_device *dev, int x, int y, int w, int h,
             /* Complement the results for subtractive color spaces */
             if (additive) {
                 for (k = 0; k < num_chan; ++k)
-                    dst_ptr[k * planestride] = dst[k];
+                    out[k] = dst[k];
             } else {
                 if (overprint) {
                     /* We may have to do the compatible overprint blending */
@@ -6521,18 +7134,22 @@ do_mark_fill_rectangle_ko_simple16(gx_device *dev, int x, int y, int w, int h,
                     }
                     for (k = 0, comps = drawn_comps; k < num_comp; ++k, comps >>= 1) {
                         if ((comps & 0x1) != 0) {
-                            dst_ptr[k * planestride] = 65535 - dst[k];
+                            out[k] = 65535 - dst[k];
                         } else {
                             /* Compatible overprint blend result. */
-                            dst_ptr[k * planestride] = 65535 - dst2[k];
+                            out[k] = 65535 - dst2[k];
                         }
                     }
                 } else {
                     for (k = 0; k < num_comp; ++k)
-                        dst_ptr[k * planestride] = 65535 - dst[k];
+                        out[k] = 65535 - dst[k];
                 }
-                dst_ptr[num_comp * planestride] = dst[num_comp];
+                out[num_comp] = dst[num_comp];
             }
+            have_out = keep_out;
+store:
+            for (k = 0; k < num_chan; ++k)
+                dst_ptr[k * planestride] = out[k];
             if (tag_off) {
                 /* FIXME: As we are knocking out, possibly, we should be
                  * always overwriting tag values here? */
@@ -7308,6 +7925,26 @@ c_pdf14trans_write_ctm(byte **ppbuf, const gs_pdf14trans_params_t *pparams)
     return 0;
 }
 
+/*
+ * A page group that is Normal, fully opaque, not knockout, without a soft mask
+ * and blending in the device color space leaves opaque marking alone, so bands
+ * that only get marked inside it can still be rendered without the compositor.
+ */
+static bool
+pdf14_page_group_is_trivial(const gs_pdf14trans_params_t *pparams,
+                            const cmm_profile_t *dev_icc_profile)
+{
+    if ((pparams->blend_mode != BLEND_MODE_Normal &&
+         pparams->blend_mode != BLEND_MODE_Compatible) ||
+        pparams->opacity.alpha != 1.0 || pparams->shape.alpha != 1.0 ||
+        pparams->Knockout || pparams->mask_id != 0)
+        return false;
+    if (pparams->group_color == UNKNOWN)
+        return true;
+    return pparams->group_color == ICC && pparams->iccprofile != NULL &&
+        pparams->iccprofile->hashcode == dev_icc_profile->hashcode;
+}
+
 /*
  * Convert a PDF 1.4 transparency compositor to string form for use by the command
  * list device. This is also where we update the pdf14_needed. When set the clist
@@ -7337,6 +7974,9 @@ c_pdf14trans_write(const gs_composite_t	* pct, byte * data, uint * psize,
     int pdf14_needed = cdev->pdf14_needed;
     int trans_group_level = cdev->pdf14_trans_group_level;
     int smask_level = cdev->pdf14_smask_level;
+    bool page_group_trivial = cdev->pdf14_page_group_trivial;
+    /* The group level that counts as page level (1 inside a trivial page group) */
+    int page_level = page_group_trivial ? 1 : 0;
     bool deep = device_is_deep((gx_device *)cdev);
 
     code = dev_proc((gx_device *) cdev, get_profile)((gx_device *) cdev,
@@ -7353,6 +7993,7 @@ c_pdf14trans_write(const gs_composite_t	* pct, byte * data, uint * psize,
             trans_group_level = 0;
             cdev->pdf14_smask_level = 0;
             cdev->page_pdf14_needed = false;
+            page_group_trivial = false;
             put_value(pbuf, pparams->num_spot_colors);
             put_value(pbuf, pparams->is_pattern);
             /* If we happen to be going to a color space like CIELAB then
@@ -7377,17 +8018,30 @@ c_pdf14trans_write(const gs_composite_t	* pct, byte * data, uint * psize,
             pdf14_needed = false;		/* reset pdf14_needed */
             trans_group_level = 0;
             smask_level = 0;
+            page_group_trivial = false;
             put_value(pbuf, pparams->is_pattern);
             break;
         case PDF14_END_TRANS_GROUP:
         case PDF14_END_TRANS_TEXT_GROUP:
             trans_group_level--;	/* if now at page level, pdf14_needed will be updated */
-            if (smask_level == 0 && trans_group_level == 0)
+            if (trans_group_level < page_level) {
+                /* End of a trivial page group */
+                page_group_trivial = false;
+                page_level = 0;
+            }
+            if (smask_level == 0 && trans_group_level == page_level)
                 pdf14_needed = cdev->page_pdf14_needed;
             break;			/* No data */
         case PDF14_BEGIN_TRANS_PAGE_GROUP:
         case PDF14_BEGIN_TRANS_GROUP:
-            pdf14_needed = true;		/* the compositor will be needed while reading */
+            if (opcode == PDF14_BEGIN_TRANS_PAGE_GROUP && smask_level == 0 &&
+                trans_group_level == 0 &&
+                pdf14_page_group_is_trivial(pparams, icc_profile)) {
+                /* Stay at page level, the compositor isn't needed yet */
+                page_group_trivial = true;
+                page_level = 1;
+            } else
+                pdf14_needed = true;		/* the compositor will be needed while reading */
             trans_group_level++;
             code = c_pdf14trans_write_ctm(&pbuf, pparams);
             if (code < 0)
@@ -7476,16 +8130,16 @@ c_pdf14trans_write(const gs_composite_t	* pct, byte * data, uint * psize,
             break;
         case PDF14_END_TRANS_MASK:
             smask_level--;
-            if (smask_level == 0 && trans_group_level == 0)
+            if (smask_level == 0 && trans_group_level == page_level)
                 pdf14_needed = cdev->page_pdf14_needed;
             break;
         case PDF14_SET_BLEND_PARAMS:
             if (pparams->blend_mode != BLEND_MODE_Normal || pparams->opacity.alpha != 1.0 ||
                 pparams->shape.alpha != 1.0)
                 pdf14_needed = true;		/* the compositor will be needed while reading */
-            else if (smask_level == 0 && trans_group_level == 0)
+            else if (smask_level == 0 && trans_group_level == page_level)
                 pdf14_needed = false;		/* At page level, set back to false */
-            if (smask_level == 0 && trans_group_level == 0)
+            if (smask_level == 0 && trans_group_level == page_level)
                 cdev->page_pdf14_needed = pdf14_needed;         /* save for after popping to page level */
             /* Changed is now two bytes due to overprint stroke fill. Write as int */
             put_value(pbuf, pparams->changed);
@@ -7547,6 +8201,7 @@ c_pdf14trans_write(const gs_composite_t	* pct, byte * data, uint * psize,
     cdev->pdf14_needed = pdf14_needed;          /* all OK to update */
     cdev->pdf14_trans_group_level = trans_group_level;
     cdev->pdf14_smask_level = smask_level;
+    cdev->pdf14_page_group_trivial = page_group_trivial;
     return 0;
 }
 
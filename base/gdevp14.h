@@ -131,6 +131,9 @@ struct pdf14_parent_color_s {
 
 typedef struct pdf14_ctx_s pdf14_ctx;
 
+/* The size of the tiles in which marking is tracked, as a power of 2. */
+#define PDF14_DIRTY_TILE_SHIFT 6
+
 struct pdf14_buf_s {
     pdf14_buf *saved;
     byte *backdrop;  /* This is needed for proper non-isolated knockout support */
@@ -152,7 +155,7 @@ struct pdf14_buf_s {
     /* Data is stored in planar format. Order of planes is: pixel values,
        alpha, shape if present, alpha_g if present. */
 
-    int rowstride;
+    int rowstride; /* 0 for a soft mask that is the same on every row */
     int planestride;
     int n_chan;   /* number of pixel planes including alpha */
     int n_planes; /* total number of planes including alpha, shape, alpha_g */
@@ -162,6 +165,13 @@ struct pdf14_buf_s {
     int matte_num_comps;
     uint16_t *matte;
     gs_int_rect dirty;
+    /* Within the dirty rectangle, a byte for each tile of rect (starting
+       from rect.p) that is non-zero if anything was marked in it, so that
+       compositing and put_image can skip the tiles that are untouched.
+       NULL if there is no data, in which case the whole of dirty counts
+       as marked. */
+    byte *dirty_tiles;
+    int dirty_tiles_wide;
     pdf14_mask_t *mask_stack;
     bool idle;
 
@@ -220,6 +230,7 @@ typedef struct pdf14_device_s {
     bool stroke_effective_op_mode;
     bool stroke_overprint;
     int text_group;
+    bool text_group_deferred;  /* The pop of the text group waits for the next text run */
     gx_color_index drawn_comps;		/* Used for overprinting.  Passed from overprint compositor */
     gx_color_index drawn_comps_fill;		/* selected by color_is_fill */
     gx_color_index drawn_comps_stroke;
@@ -308,6 +319,24 @@ int pdf14_get_buffer_information(const gx_device * dev,
 /* Not static due to call from pattern logic */
 int pdf14_disable_device(gx_device * dev);
 
+/* Note that the area x, y, w, h of buf has been marked. */
+void pdf14_buf_mark_dirty(pdf14_buf *buf, int x, int y, int w, int h);
+
+/*
+ * Find the marked parts of a buffer within the rectangle bounds, as a
+ * sequence of rectangles.  Initialize with pdf14_dirty_runs_init, then call
+ * pdf14_dirty_runs_next until it returns false.
+ */
+typedef struct pdf14_dirty_runs_s {
+    const pdf14_buf *buf;
+    gs_int_rect bounds;
+    int tx, ty;
+} pdf14_dirty_runs_t;
+
+void pdf14_dirty_runs_init(pdf14_dirty_runs_t *runs, const pdf14_buf *buf,
+                           const gs_int_rect *bounds);
+bool pdf14_dirty_runs_next(pdf14_dirty_runs_t *runs, gs_int_rect *r);
+
 /* Needed so that we can set the monitoring in the target device */
 int gs_pdf14_device_color_mon_set(gx_device *pdev, bool monitoring);
 
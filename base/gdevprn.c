@@ -24,6 +24,7 @@
 #include "gsfname.h"
 #include "gsparam.h"
 #include "gxclio.h"
+#include "gxclprof.h"
 #include "gxgetbit.h"
 #include "gdevplnx.h"
 #include "gstrans.h"
@@ -80,7 +81,7 @@ extern dev_proc_open_device(clist_open);
 /* The function run in a background thread */
 static void prn_print_page_in_background(void *data);
 
-/* wait for a background thread to finish and clean up background printing */
+/* wait for the background printing threads to finish and clean up after them */
 static void prn_finish_bg_print(gx_device_printer *ppdev);
 
 /* ------ Open/close ------ */
@@ -116,50 +117,161 @@ gdev_prn_open(gx_device * pdev)
     return code;
 }
 
-/* This is called various places to wait for any pending bg print thread and */
-/* perform its cleanup                                                       */
+/* Wait for the oldest page in the background printing queue and perform  */
+/* its cleanup.                                                            */
+static void
+prn_finish_bg_print_page(gx_device_printer *ppdev)
+{
+    bg_print_t *bg_print = &ppdev->bg_print;
+    bg_print_page_t *page = &bg_print->pages[bg_print->first];
+    int closecode = 0;
+
+    /* wait for the page's semaphore (it may already have been signalled,   */
+    /* but that's OK.) then close and unlink the files and free the device  */
+    /* and its private allocator                                            */
+    gx_semaphore_wait(page->sema);
+    /* If numcopies > 1, then the page's device will have closed and reopened
+     * a file per page, so close the one it ended with. A single output file
+     * is shared with the foreground device and stays open.
+     */
+    if (page->owns_file)
+        closecode = gdev_prn_close_printer(page->device);
+    if (page->return_code == 0)
+        page->return_code = closecode;	/* return code here iff there wasn't another error */
+    teardown_device_and_mem_for_thread(page->device, page->thread_id, true);
+    page->device = NULL;
+    if (page->ocfile) {
+        closecode = page->oio_procs->fclose(page->ocfile, page->ocfname, true);
+        if (page->return_code == 0)
+           page->return_code = closecode;
+    }
+    if (page->ocfname) {
+        gs_free_object(ppdev->memory->non_gc_memory, page->ocfname, "prn_finish_bg_print(ocfname)");
+    }
+    if (page->obfile) {
+        closecode = page->oio_procs->fclose(page->obfile, page->obfname, true);
+        if (page->return_code == 0)
+           page->return_code = closecode;
+    }
+    if (page->obfname) {
+        gs_free_object(ppdev->memory->non_gc_memory, page->obfname, "prn_finish_bg_print(obfname)");
+    }
+    page->ocfile = page->obfile = page->ocfname = page->obfname = NULL;
+    if (bg_print->return_code == 0)
+        bg_print->return_code = page->return_code;
+    bg_print->first = (bg_print->first + 1) % bg_print->size;
+    bg_print->count--;
+}
+
+/* This is called various places to wait for all pending bg print pages and */
+/* perform their cleanup. The queue itself is freed, so that a later page   */
+/* allocates it with the current BGPrintQueueDepth.                         */
 static void
 prn_finish_bg_print(gx_device_printer *ppdev)
 {
-    /* if we have a a bg printing device that was created, then wait for its	*/
-    /* semaphore (it may already have been signalled, but that's OK.) then	*/
-    /* close and unlink the files and free the device and its private allocator	*/
-    if (ppdev->bg_print.device != NULL) {
-        int closecode;
-        gx_device_printer *bgppdev = (gx_device_printer *)ppdev->bg_print.device;
-        gx_semaphore_wait(ppdev->bg_print.sema);
-        /* If numcopies > 1, then the bg_print->device will have closed and reopened
-         * the output file, so the pointer in the original device is now stale,
-         * so copy it back.
-         * If numcopies == 1, this is pointless, but benign.
-         */
-        ppdev->file = bgppdev->file;
-        closecode = gdev_prn_close_printer((gx_device *)ppdev);
-        if (ppdev->bg_print.return_code == 0)
-            ppdev->bg_print.return_code = closecode;	/* return code here iff there wasn't another error */
-        teardown_device_and_mem_for_thread(ppdev->bg_print.device,
-                                           ppdev->bg_print.thread_id, true);
-        ppdev->bg_print.device = NULL;
-        if (ppdev->bg_print.ocfile) {
-            closecode = ppdev->bg_print.oio_procs->fclose(ppdev->bg_print.ocfile, ppdev->bg_print.ocfname, true);
-            if (ppdev->bg_print.return_code == 0)
-               ppdev->bg_print.return_code = closecode;
-        }
-        if (ppdev->bg_print.ocfname) {
-            gs_free_object(ppdev->memory->non_gc_memory, ppdev->bg_print.ocfname, "prn_finish_bg_print(ocfname)");
-        }
-        if (ppdev->bg_print.obfile) {
-            closecode = ppdev->bg_print.oio_procs->fclose(ppdev->bg_print.obfile, ppdev->bg_print.obfname, true);
-            if (ppdev->bg_print.return_code == 0)
-               ppdev->bg_print.return_code = closecode;
-        }
-        if (ppdev->bg_print.obfname) {
-            gs_free_object(ppdev->memory->non_gc_memory, ppdev->bg_print.obfname, "prn_finish_bg_print(obfname)");
-        }
-        ppdev->bg_print.ocfile = ppdev->bg_print.obfile =
-          ppdev->bg_print.ocfname = ppdev->bg_print.obfname = NULL;
+    bg_print_t *bg_print = &ppdev->bg_print;
+    gs_memory_t *mem = ppdev->memory->non_gc_memory;
+    int i;
+
+    if (bg_print->pages == NULL)
+        return;
+    while (bg_print->count > 0)
+        prn_finish_bg_print_page(ppdev);
+    for (i = 0; i < bg_print->size; i++) {
+        if (bg_print->pages[i].sema != NULL)
+            gx_semaphore_free(bg_print->pages[i].sema);
+        if (bg_print->pages[i].sema_turn != NULL)
+            gx_semaphore_free(bg_print->pages[i].sema_turn);
     }
+    if (bg_print->lock != NULL)
+        gx_monitor_free(bg_print->lock);
+    gs_free_object(mem, bg_print->pages, "prn_finish_bg_print(pages)");
+    bg_print->pages = NULL;
+    bg_print->lock = NULL;
+    bg_print->size = bg_print->first = bg_print->count = 0;
 }
+
+/* Allocate the background printing queue if it isn't there yet. */
+static int
+prn_alloc_bg_print(gx_device_printer *ppdev, int depth)
+{
+    bg_print_t *bg_print = &ppdev->bg_print;
+    gs_memory_t *mem = ppdev->memory->non_gc_memory;
+    int i;
+
+    if (bg_print->pages != NULL)
+        return 0;
+    bg_print->pages = (bg_print_page_t *)gs_alloc_byte_array(mem, depth,
+                                sizeof(bg_print_page_t), "prn_alloc_bg_print");
+    if (bg_print->pages == NULL)
+        return_error(gs_error_VMerror);
+    memset(bg_print->pages, 0, depth * sizeof(bg_print_page_t));
+    bg_print->size = depth;
+    bg_print->first = bg_print->count = 0;
+    bg_print->lock = gx_monitor_label(gx_monitor_alloc(mem), "BGPrint queue");
+    if (bg_print->lock == NULL)
+        goto fail;
+    for (i = 0; i < depth; i++) {
+        bg_print_page_t *page = &bg_print->pages[i];
+
+        page->lock = bg_print->lock;
+        page->sema = gx_semaphore_label(gx_semaphore_alloc(mem), "BGPrint");
+        page->sema_turn = gx_semaphore_label(gx_semaphore_alloc(mem), "BGPrint turn");
+        if (page->sema == NULL || page->sema_turn == NULL)
+            goto fail;
+    }
+    return 0;
+
+fail:
+    prn_finish_bg_print(ppdev);		/* nothing is queued, this just frees */
+    return_error(gs_error_VMerror);
+}
+
+/* Return true if the output file name has a format for the page number. */
+static bool
+prn_file_name_has_format(const gx_device_printer *ppdev)
+{
+    gs_parsed_file_name_t parsed;
+    const char *fmt;
+    int code = gx_parse_output_file_name(&parsed, &fmt, ppdev->fname,
+                                         strlen(ppdev->fname), ppdev->memory);
+
+    return code >= 0 && fmt;
+}
+
+/* Return true if gdev_prn_close_printer closes the output file after each page. */
+static bool
+prn_output_file_per_page(const gx_device_printer *ppdev)
+{
+    return prn_file_name_has_format(ppdev) || ppdev->ReopenPerPage;
+}
+
+/* Return the number of pages that may be queued for background printing. */
+static int
+prn_bg_print_queue_depth(const gx_device_printer *ppdev)
+{
+    if (ppdev->bg_print_queue_depth <= 1)
+        return 1;
+    /* A file that is reopened under the same name for each page would be */
+    /* truncated by the next page while the previous one is being printed. */
+    if (ppdev->ReopenPerPage && !prn_file_name_has_format(ppdev))
+        return 1;
+    return ppdev->bg_print_queue_depth;
+}
+
+/* Return the memory held by the pages in the queue. */
+static size_t
+prn_bg_print_queued_size(const gx_device_printer *ppdev)
+{
+    const bg_print_t *bg_print = &ppdev->bg_print;
+    size_t size = 0;
+    int i;
+
+    for (i = 0; i < bg_print->count; i++)
+        size += bg_print->pages[(bg_print->first + i) % bg_print->size].size;
+    return size;
+}
+
 /* Generic closing for the printer device. */
 /* Specific devices may wish to extend this. */
 int
@@ -169,10 +281,6 @@ gdev_prn_close(gx_device * pdev)
     int code = 0;
 
     prn_finish_bg_print(ppdev);
-    if (ppdev->bg_print.sema != NULL) {
-        gx_semaphore_free(ppdev->bg_print.sema);
-        ppdev->bg_print.sema = NULL;		/* prevent double free */
-    }
     gdev_prn_free_memory(pdev);
     if (ppdev->file != NULL) {
         code = gx_device_close_output_file(pdev, ppdev->fname, ppdev->file);
@@ -273,6 +381,8 @@ open_c:
     ppdev->buffer_space = space;
     pclist_dev->common.is_printer = 1;
     clist_init_io_procs(pclist_dev, ppdev->BLS_force_memory);
+    pclist_dev->common.compression = ppdev->clist_compression;
+    pclist_dev->common.profile = ppdev->clist_profile;
     clist_init_params(pclist_dev, base, space, target,
                       ppdev->printer_procs.buf_procs,
                       space_params->band,
@@ -511,9 +621,6 @@ gdev_prn_allocate(gx_device *pdev, gdev_prn_space_params *new_space_params,
                 ecode = gs_note_error(gs_error_VMerror);
                 continue;
             }
-            ppdev->bg_print.ocfname = ppdev->bg_print.obfname =
-                ppdev->bg_print.obfile = ppdev->bg_print.ocfile = NULL;
-
             code = gdev_prn_setup_as_command_list(pdev, buffer_memory,
                                                   &the_memory, &space_params,
                                                   !bufferSpace_is_default);
@@ -527,7 +634,7 @@ gdev_prn_allocate(gx_device *pdev, gdev_prn_space_params *new_space_params,
                  * Now the device is a clist device, we enable multi-threaded rendering.
                  * It will remain enabled, but that doesn't really cause any problems.
                  */
-                clist_enable_multi_thread_render(pdev);
+                clist_enable_multi_thread_render(pdev, ppdev->num_render_threads_requested);
             }
         } else {
             /* Render entirely in memory. */
@@ -630,7 +737,8 @@ gdev_prn_free_memory(gx_device *pdev)
     return 0;
 }
 
-/* for saved pages, we need to make sure and free up the saved_pages_list */
+/* for saved pages, we need to make sure and free up the saved_pages_list, */
+/* and the BandListProfile needs to be finished */
 void
 gdev_prn_finalize(gx_device *pdev)
 {
@@ -640,6 +748,8 @@ gdev_prn_finalize(gx_device *pdev)
         gx_saved_pages_list_free(ppdev->saved_pages_list);
         ppdev->saved_pages_list = NULL;
     }
+    clist_profile_release(ppdev->clist_profile);
+    ppdev->clist_profile = NULL;
 }
 
 
@@ -669,6 +779,12 @@ gdev_prn_get_param(gx_device *dev, char *Param, void *list)
     if (strcmp(Param, "BGPrint") == 0) {
         return param_write_bool(plist, "BGPrint", &ppdev->bg_print_requested);
     }
+    if (strcmp(Param, "BGPrintQueueDepth") == 0) {
+        return param_write_int(plist, "BGPrintQueueDepth", &ppdev->bg_print_queue_depth);
+    }
+    if (strcmp(Param, "BGPrintMaxMemory") == 0) {
+        return param_write_size_t(plist, "BGPrintMaxMemory", &ppdev->bg_print_max_memory);
+    }
     if (strcmp(Param, "ReopenPerPage") == 0) {
         return param_write_bool(plist, "ReopenPerPage", &ppdev->ReopenPerPage);
     }
@@ -688,6 +804,19 @@ gdev_prn_get_param(gx_device *dev, char *Param, void *list)
         }
         return param_write_string(plist, "BandListStorage", &bls);
     }
+    if (strcmp(Param, "BandListCompression") == 0) {
+        gs_param_string blc;
+
+        param_string_from_string(blc, (ppdev->clist_compression == clist_compress_fast ?
+                                       "fast" : "default"));
+        return param_write_string(plist, "BandListCompression", &blc);
+    }
+    if (strcmp(Param, "BandListProfile") == 0) {
+        gs_param_string blp;
+
+        param_string_from_transient_string(blp, clist_profile_fname(ppdev->clist_profile));
+        return param_write_string(plist, "BandListProfile", &blp);
+    }
     if (strcmp(Param, "OutputFile") == 0) {
         gs_param_string ofns;
 
@@ -721,6 +850,8 @@ gdev_prn_get_params(gx_device * pdev, gs_param_list * plist)
     int code = gx_default_get_params(pdev, plist);
     gs_param_string ofns;
     gs_param_string bls;
+    gs_param_string blc;
+    gs_param_string blp;
     gs_param_string saved_pages;
     bool pageneutralcolor = false;
 
@@ -734,6 +865,8 @@ gdev_prn_get_params(gx_device * pdev, gs_param_list * plist)
         (code = param_write_int(plist, "NumRenderingThreads", &ppdev->num_render_threads_requested)) < 0 ||
         (code = param_write_bool(plist, "OpenOutputFile", &ppdev->OpenOutputFile)) < 0 ||
         (code = param_write_bool(plist, "BGPrint", &ppdev->bg_print_requested)) < 0 ||
+        (code = param_write_int(plist, "BGPrintQueueDepth", &ppdev->bg_print_queue_depth)) < 0 ||
+        (code = param_write_size_t(plist, "BGPrintMaxMemory", &ppdev->bg_print_max_memory)) < 0 ||
         (code = param_write_bool(plist, "ReopenPerPage", &ppdev->ReopenPerPage)) < 0 ||
         (code = param_write_bool(plist, "pageneutralcolor", &pageneutralcolor)) < 0
         )
@@ -753,6 +886,13 @@ gdev_prn_get_params(gx_device * pdev, gs_param_list * plist)
     }
     if( (code = param_write_string(plist, "BandListStorage", &bls)) < 0 )
         return code;
+    param_string_from_string(blc, (ppdev->clist_compression == clist_compress_fast ?
+                                   "fast" : "default"));
+    if( (code = param_write_string(plist, "BandListCompression", &blc)) < 0 )
+        return code;
+    param_string_from_transient_string(blp, clist_profile_fname(ppdev->clist_profile));
+    if( (code = param_write_string(plist, "BandListProfile", &blp)) < 0 )
+        return code;
 
     ofns.data = (const byte *)ppdev->fname,
         ofns.size = strlen(ppdev->fname),
@@ -792,6 +932,8 @@ gdev_prn_put_params(gx_device * pdev, gs_param_list * plist)
     bool rpp = ppdev->ReopenPerPage;
     bool old_page_uses_transparency = ppdev->page_uses_transparency;
     bool bg_print_requested = ppdev->bg_print_requested;
+    int bg_print_queue_depth = ppdev->bg_print_queue_depth;
+    size_t bg_print_max_memory = ppdev->bg_print_max_memory;
     bool duplex;
     int duplex_set = -1;
     int width = pdev->width;
@@ -800,6 +942,8 @@ gdev_prn_put_params(gx_device * pdev, gs_param_list * plist)
     gdev_prn_space_params save_sp;
     gs_param_string ofs;
     gs_param_string bls;
+    gs_param_string blc;
+    gs_param_string blp;
     gs_param_dict mdict;
     gs_param_string saved_pages;
     bool pageneutralcolor = false;
@@ -856,6 +1000,41 @@ gdev_prn_put_params(gx_device * pdev, gs_param_list * plist)
             bls.data = 0;
             break;
     }
+    switch (code = param_read_string(plist, (param_name = "BandListCompression"), &blc)) {
+        case 0:
+            if (!bytes_compare(blc.data, blc.size, (const byte *)"default", 7) ||
+                !bytes_compare(blc.data, blc.size, (const byte *)"fast", 4))
+                break;
+            code = gs_note_error(gs_error_rangecheck);
+            /* fall through */
+        default:
+            ecode = code;
+            param_signal_error(plist, param_name, ecode);
+            /* fall through */
+        case 1:
+            blc.data = 0;
+            break;
+    }
+    switch (code = param_read_string(plist, (param_name = "BandListProfile"), &blp)) {
+        case 0:
+            if (pdev->LockSafetyParams &&
+                    bytes_compare(blp.data, blp.size,
+                        (const byte *)clist_profile_fname(ppdev->clist_profile),
+                        strlen(clist_profile_fname(ppdev->clist_profile))))
+                code = gs_note_error(gs_error_invalidaccess);
+            else if (blp.size >= gp_file_name_sizeof)
+                code = gs_note_error(gs_error_limitcheck);
+            if (code >= 0)
+                break;
+            /* fall through */
+        default:
+            ecode = code;
+            param_signal_error(plist, param_name, ecode);
+            /* fall through */
+        case 1:
+            blp.data = 0;
+            break;
+    }
 
     switch (code = param_read_string(plist, (param_name = "OutputFile"), &ofs)) {
         case 0:
@@ -914,6 +1093,27 @@ gdev_prn_put_params(gx_device * pdev, gs_param_list * plist)
         case 1:
             break;
     }
+    switch (code = param_read_int(plist, (param_name = "BGPrintQueueDepth"),
+                                                        &bg_print_queue_depth)) {
+        case 0:
+            if (bg_print_queue_depth >= 1)
+                break;
+            code = gs_note_error(gs_error_rangecheck);
+        default:
+            ecode = code;
+            param_signal_error(plist, param_name, ecode);
+        case 1:
+            break;
+    }
+    switch (code = param_read_size_t(plist, (param_name = "BGPrintMaxMemory"),
+                                                        &bg_print_max_memory)) {
+        default:
+            ecode = code;
+            param_signal_error(plist, param_name, ecode);
+        case 0:
+        case 1:
+            break;
+    }
 
     switch (code = param_read_string(plist, (param_name = "saved-pages"),
                                                         &saved_pages)) {
@@ -947,11 +1147,14 @@ gdev_prn_put_params(gx_device * pdev, gs_param_list * plist)
     ppdev->OpenOutputFile = oof;
     ppdev->ReopenPerPage = rpp;
 
-    if (ppdev->bg_print_requested && !bg_print_requested) {
-        prn_finish_bg_print(ppdev);
+    if ((ppdev->bg_print_requested && !bg_print_requested) ||
+        ppdev->bg_print_queue_depth != bg_print_queue_depth) {
+        prn_finish_bg_print(ppdev);	/* the queue is reallocated for the new depth */
     }
 
     ppdev->bg_print_requested = bg_print_requested;
+    ppdev->bg_print_queue_depth = bg_print_queue_depth;
+    ppdev->bg_print_max_memory = bg_print_max_memory;
     if (duplex_set >= 0) {
         ppdev->Duplex = duplex;
         ppdev->Duplex_set = duplex_set;
@@ -960,6 +1163,10 @@ gdev_prn_put_params(gx_device * pdev, gs_param_list * plist)
     if (bls.data != 0) {
         ppdev->BLS_force_memory = (bls.data[0] == 'm');
     }
+    if (blc.data != 0) {
+        ppdev->clist_compression =
+            (blc.data[0] == 'f' ? clist_compress_fast : clist_compress_default);
+    }
 
     /* If necessary, free and reallocate the printer memory. */
     /* Formerly, would not reallocate if device is not open: */
@@ -969,12 +1176,41 @@ gdev_prn_put_params(gx_device * pdev, gs_param_list * plist)
     if (code < 0)
         return code;
 
+    /* The band rendering reads the number of threads from the clist (see
+       clist_enable_multi_thread_render), so keep it up to date, also when
+       it goes back to 0. */
+    if (PRINTER_IS_CLIST(ppdev))
+        ((gx_device_clist *)ppdev)->common.render_threads_requested =
+            ppdev->num_render_threads_requested;
+
+    /* If the profile file changed, finish the old profile and start the new one. */
+    if (blp.data != 0 &&
+        bytes_compare(blp.data, blp.size,
+                      (const byte *)clist_profile_fname(ppdev->clist_profile),
+                      strlen(clist_profile_fname(ppdev->clist_profile)))
+        ) {
+        clist_profile_t *prof = NULL;
+
+        prn_finish_bg_print(ppdev);
+        if (blp.size != 0) {
+            code = clist_profile_new(pdev->memory, blp.data, blp.size, &prof);
+            if (code < 0)
+                return code;
+        }
+        clist_profile_release(ppdev->clist_profile);
+        ppdev->clist_profile = prof;
+        if (PRINTER_IS_CLIST(ppdev))
+            ((gx_device_clist *)ppdev)->common.profile = prof;
+        pdev->finalize = gdev_prn_finalize;	/* to release the profile */
+    }
+
     /* If filename changed, close file. */
     if (ofs.data != 0 &&
         bytes_compare(ofs.data, ofs.size,
                       (const byte *)ppdev->fname, strlen(ppdev->fname))
         ) {
-        /* Close the file if it's open. */
+        /* Close the file if it's open, after the queued pages are done with it. */
+        prn_finish_bg_print(ppdev);
         if (ppdev->file != NULL) {
             gx_device_close_output_file(pdev, ppdev->fname, ppdev->file);
         }
@@ -1022,11 +1258,19 @@ static int	/* 0 ok, -ve error                                               */
 gdev_prn_output_page_aux(gx_device * pdev, int num_copies, int flush, bool seekable, bool bg_print_ok)
 {
     gx_device_printer * const ppdev = (gx_device_printer *)pdev;
+    bg_print_t *bg_print = &ppdev->bg_print;
     gs_devn_params *pdevn_params;
     int outcode = 0, errcode = 0, endcode, closecode = 0;
     int code;
 
-    prn_finish_bg_print(ppdev);		/* finish any previous background printing */
+    if (ppdev->bg_print_requested && num_copies > 0 && ppdev->saved_pages_list == NULL) {
+        /* make room for this page in the background printing queue */
+        while (bg_print->count > 0 &&
+               (bg_print->count >= bg_print->size ||
+                bg_print->count >= prn_bg_print_queue_depth(ppdev)))
+            prn_finish_bg_print_page(ppdev);
+    } else
+        prn_finish_bg_print(ppdev);		/* finish any previous background printing */
 
     if (num_copies > 0 && ppdev->saved_pages_list != NULL) {
         /* We are putting pages on a list */
@@ -1040,17 +1284,19 @@ gdev_prn_output_page_aux(gx_device * pdev, int num_copies, int flush, bool seeka
         if (num_copies > 0) {
             int threads_enabled = 0;
             int print_foreground = 1;		/* default to foreground printing */
+            bg_print_page_t *page = NULL;
 
             if (bg_print_ok && PRINTER_IS_CLIST(ppdev) &&
                 (ppdev->bg_print_requested || ppdev->num_render_threads_requested > 0)) {
-                threads_enabled = clist_enable_multi_thread_render(pdev);
+                threads_enabled = clist_enable_multi_thread_render(pdev, ppdev->num_render_threads_requested);
             }
-            /* NB: we leave the semaphore allocated until foreground printing or close */
+            /* NB: we leave the queue allocated until foreground printing or close */
             /* If there was an error, abort on this page -- no good way to handle this */
             /* but it means that the error will be reported AFTER another page was     */
             /* interpreted and written to clist files. FIXME: ???                      */
-            if (ppdev->bg_print.return_code < 0) {
-                outcode = ppdev->bg_print.return_code;
+            if (bg_print->return_code < 0) {
+                outcode = bg_print->return_code;
+                bg_print->return_code = 0;
                 threads_enabled = 0;	/* and allow current page to try foreground */
             }
             /* Use 'while' instead of 'if' to avoid nesting */
@@ -1058,56 +1304,86 @@ gdev_prn_output_page_aux(gx_device * pdev, int num_copies, int flush, bool seeka
                 gx_device *ndev;
                 gx_device_printer *npdev;
                 gx_device_clist_reader *crdev = (gx_device_clist_reader *)ppdev;
+                bg_print_page_t *prev;
+                size_t size;
 
                 if ((code = clist_close_writer_and_init_reader((gx_device_clist *)ppdev)) < 0)
                     /* should not happen -- do foreground print */
                     break;
 
+                /* The page holds on to its band list until it is printed, and */
+                /* its device allocates a rendering buffer of its own.         */
+                size = (size_t)crdev->page_info.bfile_end_pos + ppdev->buffer_space;
+                if (crdev->page_info.cfile != NULL)
+                    size += (size_t)crdev->page_info.io_procs->ftell(crdev->page_info.cfile);
+                /* Back-pressure: let earlier pages finish until this one fits */
+                while (bg_print->count > 0 && ppdev->bg_print_max_memory > 0 &&
+                       prn_bg_print_queued_size(ppdev) + size > ppdev->bg_print_max_memory)
+                    prn_finish_bg_print_page(ppdev);
+
+                if (prn_alloc_bg_print(ppdev, prn_bg_print_queue_depth(ppdev)) < 0)
+                    break;
+                page = &bg_print->pages[(bg_print->first + bg_print->count) % bg_print->size];
+
                 /* We need to hang onto references to these files, so we can ensure the main file data
                  * gets freed with the correct allocator.
                  */
-                ppdev->bg_print.ocfname =
+                page->ocfname =
                      (char *)gs_alloc_bytes(ppdev->memory->non_gc_memory,
                            strnlen(crdev->page_info.cfname, gp_file_name_sizeof - 1) + 1, "gdev_prn_output_page_aux(ocfname)");
-                ppdev->bg_print.obfname =
+                page->obfname =
                      (char *)gs_alloc_bytes(ppdev->memory->non_gc_memory,
                            strnlen(crdev->page_info.bfname, gp_file_name_sizeof - 1) + 1,"gdev_prn_output_page_aux(ocfname)");
 
-                if (!ppdev->bg_print.ocfname || !ppdev->bg_print.obfname)
+                if (!page->ocfname || !page->obfname)
                     break;
 
-                strncpy(ppdev->bg_print.ocfname, crdev->page_info.cfname, strnlen(crdev->page_info.cfname, gp_file_name_sizeof - 1) + 1);
-                strncpy(ppdev->bg_print.obfname, crdev->page_info.bfname, strnlen(crdev->page_info.bfname, gp_file_name_sizeof - 1) + 1);
-                ppdev->bg_print.obfile = crdev->page_info.bfile;
-                ppdev->bg_print.ocfile = crdev->page_info.cfile;
-                ppdev->bg_print.oio_procs = crdev->page_info.io_procs;
+                strncpy(page->ocfname, crdev->page_info.cfname, strnlen(crdev->page_info.cfname, gp_file_name_sizeof - 1) + 1);
+                strncpy(page->obfname, crdev->page_info.bfname, strnlen(crdev->page_info.bfname, gp_file_name_sizeof - 1) + 1);
+                page->obfile = crdev->page_info.bfile;
+                page->ocfile = crdev->page_info.cfile;
+                page->oio_procs = crdev->page_info.io_procs;
                 crdev->page_info.cfile = crdev->page_info.bfile = NULL;
 
-                if (ppdev->bg_print.sema == NULL)
-                {
-                    ppdev->bg_print.sema = gx_semaphore_label(gx_semaphore_alloc(ppdev->memory->non_gc_memory), "BGPrint");
-                    if (ppdev->bg_print.sema == NULL)
-                        break;			/* couldn't create the semaphore */
-                }
-
                 ndev = setup_device_and_mem_for_thread(pdev->memory->thread_safe_memory, pdev, true, NULL);
                 if (ndev == NULL) {
                     break;
                 }
-                ppdev->bg_print.device = ndev;
-                ppdev->bg_print.num_copies = num_copies;
+                page->device = ndev;
+                page->num_copies = num_copies;
+                page->return_code = 0;
+                page->owns_file = prn_output_file_per_page(ppdev);
+                page->printed = false;
+                page->next = NULL;
+                page->size = size;
                 npdev = (gx_device_printer *)ndev;
                 npdev->bg_print_requested = 0;
                 npdev->num_render_threads_requested = ppdev->num_render_threads_requested;
+                /* The page's own device renders its bands with the threads */
+                if (npdev->num_render_threads_requested > 0)
+                    clist_enable_multi_thread_render(ndev, npdev->num_render_threads_requested);
 
                 /* Now start the thread to print the page */
                 if ((code = gp_thread_start(prn_print_page_in_background,
-                                            (void *)&(ppdev->bg_print),
-                                            &(ppdev->bg_print.thread_id))) < 0) {
+                                            (void *)page, &(page->thread_id))) < 0) {
                     /* Did not start cleanly - clean up is in print_foreground block below */
                     break;
                 }
-                gp_thread_label(ppdev->bg_print.thread_id, "BG print thread");
+                gp_thread_label(page->thread_id, "BG print thread");
+                /* The pages share the output file, so this one may only print */
+                /* once the page queued before it has been printed.            */
+                prev = bg_print->count == 0 ? NULL :
+                    &bg_print->pages[(bg_print->first + bg_print->count - 1) % bg_print->size];
+                gx_monitor_enter(bg_print->lock);
+                if (prev != NULL && !prev->printed)
+                    prev->next = page;
+                else
+                    gx_semaphore_signal(page->sema_turn);
+                gx_monitor_leave(bg_print->lock);
+                bg_print->count++;
+                /* A file per page is closed by the queued page when it is finished */
+                if (page->owns_file)
+                    ppdev->file = NULL;
                 /* Page was succesfully started in bg_print mode */
                 print_foreground = 0;
                 /* Now we need to set up the next page so it will use new clist files */
@@ -1117,19 +1393,28 @@ gdev_prn_output_page_aux(gx_device * pdev, int num_copies, int flush, bool seeka
                 break;				/* exit the while loop */
             }
             if (print_foreground) {
-
-                 gs_free_object(ppdev->memory->non_gc_memory, ppdev->bg_print.ocfname, "gdev_prn_output_page_aux(ocfname)");
-                 gs_free_object(ppdev->memory->non_gc_memory, ppdev->bg_print.obfname, "gdev_prn_output_page_aux(obfname)");
-                 ppdev->bg_print.ocfname = ppdev->bg_print.obfname = NULL;
-
-                /* either bg_print was not requested or was not able to start */
-                if (ppdev->bg_print.sema != NULL && ppdev->bg_print.device != NULL) {
-                    /* There was a problem. Teardown the device and its allocator, but */
-                    /* leave the semaphore for possible later use.                     */
-                    teardown_device_and_mem_for_thread(ppdev->bg_print.device,
-                                                       ppdev->bg_print.thread_id, true);
-                    ppdev->bg_print.device = NULL;
+                if (page != NULL) {
+                    /* The page could not be queued, give the clist files back */
+                    gx_device_clist_reader *crdev = (gx_device_clist_reader *)ppdev;
+
+                    gs_free_object(ppdev->memory->non_gc_memory, page->ocfname, "gdev_prn_output_page_aux(ocfname)");
+                    gs_free_object(ppdev->memory->non_gc_memory, page->obfname, "gdev_prn_output_page_aux(obfname)");
+                    page->ocfname = page->obfname = NULL;
+                    if (page->ocfile != NULL || page->obfile != NULL) {
+                        crdev->page_info.cfile = page->ocfile;
+                        crdev->page_info.bfile = page->obfile;
+                        page->ocfile = page->obfile = NULL;
+                    }
+                    if (page->device != NULL) {
+                        /* There was a problem. Teardown the device and its allocator, but */
+                        /* leave the queue for possible later use.                         */
+                        teardown_device_and_mem_for_thread(page->device,
+                                                           page->thread_id, true);
+                        page->device = NULL;
+                    }
                 }
+                /* Pages queued earlier go to the output file first */
+                prn_finish_bg_print(ppdev);
                 /* Here's where we actually let the device's print_page_copies work */
                 /* Print the accumulated page description. */
                 outcode = (*ppdev->printer_procs.print_page_copies)(ppdev, ppdev->file,
@@ -1234,27 +1519,39 @@ gx_default_print_page_copies(gx_device_printer * pdev, gp_file * prn_stream,
 }
 
 /*
- * Print a page in the background. When printing is complete,
- * post the return code and signal the foreground (semaphore).
+ * Print a page in the background, once the page queued before it has been
+ * printed. When printing is complete, post the return code, let the next
+ * page go, and signal the foreground (semaphore).
  * This is the procedure that is run in the background thread.
  */
 static void
 prn_print_page_in_background(void *data)
 {
-    bg_print_t *bg_print = (bg_print_t *)data;
+    bg_print_page_t *page = (bg_print_page_t *)data;
+    bg_print_page_t *next;
     int code, errcode = 0;
-    int num_copies = bg_print->num_copies;
-    gx_device_printer *ppdev = (gx_device_printer *)bg_print->device;
+    int num_copies = page->num_copies;
+    gx_device_printer *ppdev = (gx_device_printer *)page->device;
 
+    /* Wait for the previous page, the output file is shared */
+    gx_semaphore_wait(page->sema_turn);
     code = (*ppdev->printer_procs.print_page_copies)(ppdev, ppdev->file,
                                                           num_copies);
     gp_fflush(ppdev->file);
 
     errcode = (gp_ferror(ppdev->file) ? gs_note_error(gs_error_ioerror) : 0);
-    bg_print->return_code = code < 0 ? code : errcode;
+    page->return_code = code < 0 ? code : errcode;
+
+    /* Let the next page print, if it has been queued yet */
+    gx_monitor_enter(page->lock);
+    page->printed = true;
+    next = page->next;
+    gx_monitor_leave(page->lock);
+    if (next != NULL)
+        gx_semaphore_signal(next->sema_turn);
 
     /* Finally, release the foreground that may be waiting */
-    gx_semaphore_signal(bg_print->sema);
+    gx_semaphore_signal(page->sema);
 }
 /* ---------------- Driver services ---------------- */
 
@@ -113,17 +113,39 @@ typedef struct gx_printer_device_procs_s {
 
 #define prn_fname_sizeof gp_file_name_sizeof
 
-typedef struct bg_print_s {
+/*
+ * Background printing keeps a short queue of pages whose band lists have
+ * been written, so that the interpreter can go on with the next pages while
+ * the queued ones are rendered. Each page has its own device and thread;
+ * the threads print in page order since they share the output file.
+ */
+typedef struct bg_print_page_s bg_print_page_t;
+struct bg_print_page_s {
     gx_semaphore_t *sema;		/* used by foreground to wait */
+    gx_semaphore_t *sema_turn;		/* signalled when the previous page is printed */
+    gx_monitor_t *lock;			/* the queue lock, protects printed and next */
     gx_device *device;			/* printer/clist device for bg printing */
     gp_thread_id thread_id;
     int num_copies;
     int return_code;			/* result from background print thread */
+    bool owns_file;			/* output file is closed when the page is finished */
+    bool printed;			/* print_page_copies has returned */
+    bg_print_page_t *next;		/* page waiting for its turn after this one */
+    size_t size;			/* memory held by the page, for BGPrintMaxMemory */
     char *ocfname;	                /* command file name */
     clist_file_ptr ocfile;	        /* command file, normally 0 */
     char *obfname;	                /* block file name */
     clist_file_ptr obfile;	/* block file, normally 0 */
     const clist_io_procs_t *oio_procs;
+};
+
+typedef struct bg_print_s {
+    bg_print_page_t *pages;		/* ring of pages, NULL when nothing is queued */
+    gx_monitor_t *lock;
+    int size;				/* number of entries in pages */
+    int first;				/* oldest queued page */
+    int count;				/* number of queued pages */
+    int return_code;			/* first error from a finished page */
 } bg_print_t;
 
 #define gx_prn_device_common\
@@ -147,8 +169,12 @@ typedef struct bg_print_s {
         gs_memory_t *buffer_memory;	/* allocator for command list */\
         gs_memory_t *bandlist_memory;	/* allocator for bandlist files */\
         uint clist_disable_mask;	/* mask of clist options to disable */\
+        clist_compress_t clist_compression;	/* BandListCompression */\
+        clist_profile_t *clist_profile;	/* BandListProfile, see gxclprof.h */\
         bool bg_print_requested;	/* request background printing of page from clist */\
-        bg_print_t bg_print;            /* background printing data shared with thread */\
+        int bg_print_queue_depth;	/* max pages queued for background printing */\
+        size_t bg_print_max_memory;	/* max memory held by queued pages, 0 = no limit */\
+        bg_print_t bg_print;            /* pages queued for background printing */\
         int num_render_threads_requested;	/* for multiple band rendering threads */\
         gx_saved_pages_list *saved_pages_list;	/* list when we are saving pages instead of printing */\
         gx_device_procs save_procs_while_delaying_erasepage;	/* save device procs while delaying erasepage. */\
@@ -321,8 +347,12 @@ extern const gx_device_procs prn_bg_procs;
         0,		/* *buffer_memory */\
         0,		/* *bandlist_memory */\
         0,		/* clist_disable_mask */\
+        clist_compress_default,	/* clist_compression */\
+        0,		/* clist_profile */\
         0/*false*/,	/* bg_print_requested */\
-        {  0/*sema*/, 0/*device*/, 0/*thread_id*/, 0/*num_copies*/, 0/*return_code*/ }, /* bg_print */\
+        1,		/* bg_print_queue_depth */\
+        0,		/* bg_print_max_memory */\
+        {  0/*pages*/, 0/*lock*/, 0/*size*/, 0/*first*/, 0/*count*/, 0/*return_code*/ }, /* bg_print */\
         0, 		/* num_render_threads_requested */\
         0,              /* saved_pages_list */\
         { 0 },	/* save_procs_while_delaying_erasepage */\
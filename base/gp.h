@@ -340,6 +340,15 @@ int gp_fprintf(gp_file *f, const char *fmt, ...)
 #endif
     ;
 
+/* Map the first size bytes of a file into memory, read only, so that they
+ * can be used without reading them. Returns NULL if this isn't possible
+ * for the file or on this platform, in which case the caller must read the
+ * file as usual. Data written beyond size after mapping is not visible. */
+void *gp_fmap(gp_file *f, gs_offset_t size);
+
+/* Release a mapping made by gp_fmap. */
+void gp_funmap(void *addr, gs_offset_t size);
+
 /* ------ Reading from stdin, unbuffered if possible ------ */
 
 /* Read bytes from stdin, using unbuffered if possible.
@@ -625,6 +634,11 @@ int gp_pread_impl(char *buf, size_t count, gs_offset_t offset, FILE *f);
 
 int gp_pwrite_impl(const char *buf, size_t count, gs_offset_t offset, FILE *f);
 
+/* Map a FILE into memory for reading (see gp_fmap), or return NULL. */
+void *gp_fmap_impl(FILE *f, gs_offset_t size);
+
+void gp_funmap_impl(void *addr, gs_offset_t size);
+
 gs_offset_t gp_ftell_impl(FILE *f);
 
 int gp_fseek_impl(FILE *strm, gs_offset_t offset, int origin);
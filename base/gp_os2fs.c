@@ -293,6 +293,15 @@ int gp_pwrite_impl(char *buf, size_t count, gs_offset_t offset, FILE *f)
     return -1;
 }
 
+void *gp_fmap_impl(FILE *f, gs_offset_t size)
+{
+    return NULL;
+}
+
+void gp_funmap_impl(void *addr, gs_offset_t size)
+{
+}
+
 /* -------------- Helpers for gp_file_name_combine_generic ------------- */
 
 uint gp_file_name_root(const char *fname, uint len)
@@ -32,6 +32,9 @@
 #include "dirent_.h"
 #include "unistd_.h"
 #include <stdlib.h>             /* for mkstemp/mktemp */
+#ifndef GS_NO_FILESYSTEM
+#include <sys/mman.h>           /* for mmap */
+#endif
 
 #if !defined(HAVE_FSEEKO)
 #define ftello ftell
@@ -233,6 +236,28 @@ int gp_pwrite_impl(const char *buf, size_t count, gs_offset_t offset, FILE *f)
 #endif
 }
 
+void *gp_fmap_impl(FILE *f, gs_offset_t size)
+{
+#ifdef GS_NO_FILESYSTEM
+    return NULL;
+#else
+    int fd = fileno(f);
+    void *addr;
+
+    if (fd < 0)
+        return NULL;
+    addr = mmap(NULL, (size_t)size, PROT_READ, MAP_SHARED, fd, 0);
+    return (addr == MAP_FAILED ? NULL : addr);
+#endif
+}
+
+void gp_funmap_impl(void *addr, gs_offset_t size)
+{
+#ifndef GS_NO_FILESYSTEM
+    munmap(addr, (size_t)size);
+#endif
+}
+
 /* Set a file into binary or text mode. */
 int
 gp_setmode_binary_impl(FILE * pfile, bool mode)
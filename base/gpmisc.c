@@ -714,6 +714,24 @@ char *gp_fgets(char *buffer, size_t n, gp_file *f)
     return buffer;
 }
 
+void *
+gp_fmap(gp_file *f, gs_offset_t size)
+{
+    FILE *file = gp_get_file(f);
+
+    /* Only plain FILEs can be mapped, and only if the size fits a size_t. */
+    if (file == NULL || size <= 0 || (gs_offset_t)(size_t)size != size)
+        return NULL;
+    return gp_fmap_impl(file, size);
+}
+
+void
+gp_funmap(void *addr, gs_offset_t size)
+{
+    if (addr != NULL)
+        gp_funmap_impl(addr, size);
+}
+
 gp_file *
 gp_fopen(const gs_memory_t *mem, const char *fname, const char *mode)
 {
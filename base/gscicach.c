@@ -23,8 +23,16 @@
 #include "gscicach.h"
 #include "memory_.h"
 
+/*
+ * The cache starts at COLOR_INDEX_CACHE_SIZE elements.  Smooth shadings
+ * with many distinct colours would thrash it, so while the elements are
+ * being replaced faster than they are reused, its size is doubled, up to
+ * COLOR_INDEX_CACHE_MAX_SIZE.  There is a hash chain for each
+ * COLOR_INDEX_CACHE_CHAIN_LENGTH elements.
+ */
 #define COLOR_INDEX_CACHE_SIZE 256
-#define COLOR_INDEX_CACHE_CHAINS (COLOR_INDEX_CACHE_SIZE / 16)
+#define COLOR_INDEX_CACHE_MAX_SIZE 4096
+#define COLOR_INDEX_CACHE_CHAIN_LENGTH 4
 
 typedef struct gs_color_index_cache_elem_s gs_color_index_cache_elem_t;
 
@@ -53,16 +61,26 @@ struct gs_color_index_cache_s {
     uint recent_touch;
     float *paint_values;
     frac31 *frac_values;
-    int chains[COLOR_INDEX_CACHE_CHAINS];
+    int size;                   /* elements in buf */
+    int max_size;               /* the most we may grow to */
+    uint num_chains;            /* a power of 2 */
+    int *chains;
+    /* Statistics, reported when the cache is destroyed. */
+    long lookups;
+    long hits;
+    long evictions;
+    long recent_lookups;        /* ... since the last resize */
+    long recent_evictions;      /* ... since the last resize */
     /* Note : the 0th element of buf, paint_values, frac_values is never used,
        because we consider the index 0 as NULL
        just for a faster initialization. */
 #   define MYNULL 0
 };
 
-gs_private_st_ptrs6(st_color_index_cache, gs_color_index_cache_t, "gs_color_index_cache_t",
+gs_private_st_ptrs7(st_color_index_cache, gs_color_index_cache_t, "gs_color_index_cache_t",
                     gs_color_index_cache_elem_ptrs, gs_color_index_cache_reloc_ptrs,
-                    direct_space, memory, buf, paint_values, frac_values, trans_dev);
+                    direct_space, memory, buf, paint_values, frac_values, trans_dev,
+                    chains);
 
 gs_color_index_cache_t *
 gs_color_index_cache_create(gs_memory_t *memory, const gs_color_space *direct_space, gx_device *dev,
@@ -70,23 +88,29 @@ gs_color_index_cache_create(gs_memory_t *memory, const gs_color_space *direct_sp
 {
     int client_num_components = cs_num_components(direct_space);
     int device_num_components = trans_dev->color_info.num_components;
+    uint num_chains = COLOR_INDEX_CACHE_SIZE / COLOR_INDEX_CACHE_CHAIN_LENGTH;
     gs_color_index_cache_elem_t *buf = ( gs_color_index_cache_elem_t *)gs_alloc_byte_array(memory, COLOR_INDEX_CACHE_SIZE,
                     sizeof(gs_color_index_cache_elem_t), "gs_color_index_cache_create");
     float *paint_values = (float *)gs_alloc_byte_array(memory, COLOR_INDEX_CACHE_SIZE * client_num_components,
                     sizeof(float), "gs_color_index_cache_create");
     frac31 *frac_values = (need_frac ? (frac31 *)gs_alloc_byte_array(memory, COLOR_INDEX_CACHE_SIZE * device_num_components,
                                             sizeof(frac31), "gs_color_index_cache_create") : NULL);
+    int *chains = (int *)gs_alloc_byte_array(memory, num_chains, sizeof(int),
+                    "gs_color_index_cache_create");
     gs_color_index_cache_t *pcic = gs_alloc_struct(memory, gs_color_index_cache_t, &st_color_index_cache, "gs_color_index_cache_create");
 
-    if (buf == NULL || paint_values == NULL || (need_frac && frac_values == NULL) || pcic == NULL) {
+    if (buf == NULL || paint_values == NULL || (need_frac && frac_values == NULL) ||
+        chains == NULL || pcic == NULL) {
         gs_free_object(memory, buf, "gs_color_index_cache_create");
         gs_free_object(memory, paint_values, "gs_color_index_cache_create");
         gs_free_object(memory, frac_values, "gs_color_index_cache_create");
+        gs_free_object(memory, chains, "gs_color_index_cache_create");
         gs_free_object(memory, pcic, "gs_color_index_cache_create");
         return NULL;
     }
     memset(pcic, 0, sizeof(*pcic));
     memset(buf, 0, COLOR_INDEX_CACHE_SIZE * sizeof(gs_color_index_cache_elem_t));
+    memset(chains, 0, num_chains * sizeof(int));
     pcic->direct_space = direct_space;
     pcic->pgs = pgs;
     pcic->dev = dev;
@@ -99,35 +123,65 @@ gs_color_index_cache_create(gs_memory_t *memory, const gs_color_space *direct_sp
     pcic->recent_touch = MYNULL;
     pcic->paint_values = paint_values;
     pcic->frac_values = frac_values;
+    pcic->size = COLOR_INDEX_CACHE_SIZE;
+    pcic->max_size = COLOR_INDEX_CACHE_MAX_SIZE;
+    pcic->num_chains = num_chains;
+    pcic->chains = chains;
     return pcic;
 }
 
 void
 gs_color_index_cache_destroy(gs_color_index_cache_t *pcic)
 {
+    if_debug6m('c', pcic->memory,
+               "[c]color index cache: %ld lookups, %ld hits (%d%%), %ld evictions, size %d of %d\n",
+               pcic->lookups, pcic->hits,
+               pcic->lookups == 0 ? 0 : (int)(pcic->hits * 100.0 / pcic->lookups),
+               pcic->evictions, pcic->size, pcic->max_size);
     gs_free_object(pcic->memory, pcic->buf, "gs_color_index_cache_create");
     gs_free_object(pcic->memory, pcic->paint_values, "gs_color_index_cache_create");
     gs_free_object(pcic->memory, pcic->frac_values, "gs_color_index_cache_create");
+    gs_free_object(pcic->memory, pcic->chains, "gs_color_index_cache_create");
     pcic->buf = NULL;
     pcic->paint_values = NULL;
     pcic->frac_values = NULL;
+    pcic->chains = NULL;
     gs_free_object(pcic->memory, pcic, "gs_color_index_cache_create");
 }
 
-static inline int
+/* The bits of a paint value : the cache compares them exactly. */
+typedef union color_index_cache_value_s {
+    float f;
+    bits32 u;
+} color_index_cache_value_t;
+
+static inline uint
 hash_paint_values(const gs_color_index_cache_t *self, const float *paint_values)
 {
     int i;
-    float v = 0;
-    uint k = 0;
-    const uint a_prime = 79;
-
-    for (i = 0; i < self->client_num_components; i++)
-        v = v * a_prime + paint_values[i];
-    /* Don't know the range of v, so hash its bytes : */
-    for(i = 0; i < sizeof(v); i++)
-        k = k * a_prime + ((byte *)&v)[i];
-    return k % COLOR_INDEX_CACHE_CHAINS;
+    bits32 k = 0;
+    color_index_cache_value_t v;
+
+    for (i = 0; i < self->client_num_components; i++) {
+        v.f = paint_values[i];
+        k = (k ^ v.u) * 0x9e3779b1;
+    }
+    return (uint)((k ^ (k >> 16)) & (self->num_chains - 1));
+}
+
+static inline bool
+paint_values_equal(const float *a, const float *b, int n)
+{
+    color_index_cache_value_t va, vb;
+    int i;
+
+    for (i = 0; i < n; i++) {
+        va.f = a[i];
+        vb.f = b[i];
+        if (va.u != vb.u)
+            return false;
+    }
+    return true;
 }
 
 static inline void
@@ -188,41 +242,108 @@ include_into_touch_list(gs_color_index_cache_t *self, uint i)
     self->recent_touch = i;
 }
 
+/* Double the size of the cache, keeping its contents.  The elements keep
+   their indices, so only the hash chains need rebuilding.  If there isn't
+   enough memory the cache just stays at its current size. */
+static void
+grow_color_index_cache(gs_color_index_cache_t *self)
+{
+    gs_memory_t *memory = self->memory;
+    int client_num_components = self->client_num_components;
+    int device_num_components = self->device_num_components;
+    int size = self->size * 2;
+    uint num_chains = size / COLOR_INDEX_CACHE_CHAIN_LENGTH;
+    gs_color_index_cache_elem_t *buf = (gs_color_index_cache_elem_t *)gs_alloc_byte_array(memory, size,
+                    sizeof(gs_color_index_cache_elem_t), "grow_color_index_cache");
+    float *paint_values = (float *)gs_alloc_byte_array(memory, size * client_num_components,
+                    sizeof(float), "grow_color_index_cache");
+    frac31 *frac_values = (self->frac_values != NULL ? (frac31 *)gs_alloc_byte_array(memory, size * device_num_components,
+                    sizeof(frac31), "grow_color_index_cache") : NULL);
+    int *chains = (int *)gs_alloc_byte_array(memory, num_chains, sizeof(int),
+                    "grow_color_index_cache");
+    uint i;
+
+    if (buf == NULL || paint_values == NULL ||
+        (self->frac_values != NULL && frac_values == NULL) || chains == NULL) {
+        gs_free_object(memory, buf, "grow_color_index_cache");
+        gs_free_object(memory, paint_values, "grow_color_index_cache");
+        gs_free_object(memory, frac_values, "grow_color_index_cache");
+        gs_free_object(memory, chains, "grow_color_index_cache");
+        self->max_size = self->size;
+        return;
+    }
+    memcpy(buf, self->buf, self->size * sizeof(gs_color_index_cache_elem_t));
+    memset(buf + self->size, 0, (size - self->size) * sizeof(gs_color_index_cache_elem_t));
+    memcpy(paint_values, self->paint_values,
+           self->size * client_num_components * sizeof(float));
+    if (frac_values != NULL)
+        memcpy(frac_values, self->frac_values,
+               self->size * device_num_components * sizeof(frac31));
+    memset(chains, 0, num_chains * sizeof(int));
+    gs_free_object(memory, self->buf, "grow_color_index_cache");
+    gs_free_object(memory, self->paint_values, "grow_color_index_cache");
+    gs_free_object(memory, self->frac_values, "grow_color_index_cache");
+    gs_free_object(memory, self->chains, "grow_color_index_cache");
+    self->buf = buf;
+    self->paint_values = paint_values;
+    self->frac_values = frac_values;
+    self->chains = chains;
+    self->size = size;
+    self->num_chains = num_chains;
+    for (i = 1; i < self->used; i++)
+        include_into_chain(self, i,
+                hash_paint_values(self, paint_values + i * client_num_components));
+    self->recent_lookups = 0;
+    self->recent_evictions = 0;
+}
+
 static int
-get_color_index_cache_elem(gs_color_index_cache_t *self, 
+get_color_index_cache_elem(gs_color_index_cache_t *self,
                            const float *paint_values, uint *pi)
 {
     int client_num_components = self->client_num_components;
     uint c = hash_paint_values(self, paint_values);
     uint i = self->chains[c], j;
 
+    self->lookups++;
+    self->recent_lookups++;
     if (i != MYNULL) {
         uint tries = 16; /* Arbitrary. */
 
-        if (!memcmp(paint_values, self->paint_values + i * client_num_components, 
-                    sizeof(*paint_values) * client_num_components)) {
+        if (paint_values_equal(paint_values, self->paint_values + i * client_num_components,
+                               client_num_components)) {
             if (self->recent_touch != i) {
                 exclude_from_touch_list(self, i);
                 include_into_touch_list(self, i);
             }
+            self->hits++;
             *pi = i;
             return 1;
         }
         for (j = self->buf[i].next; tries -- && j != i; j = self->buf[j].next) {
-            if (!memcmp(paint_values, self->paint_values + j * client_num_components, 
-                        sizeof(*paint_values) * client_num_components)) {
+            if (paint_values_equal(paint_values, self->paint_values + j * client_num_components,
+                                   client_num_components)) {
                 exclude_from_chain(self, j);
                 include_into_chain(self, j, c);
                 if (self->recent_touch != j) {
                     exclude_from_touch_list(self, j);
                     include_into_touch_list(self, j);
                 }
+                self->hits++;
                 *pi = j;
                 return 1;
             }
         }
     }
-    if (self->used < COLOR_INDEX_CACHE_SIZE) {
+    if (self->used == self->size && self->size < self->max_size &&
+        self->recent_evictions >= self->size &&
+        self->recent_evictions * 4 > self->recent_lookups) {
+        /* Since the last resize, as many elements have been replaced as
+           the cache holds, and more than 1 lookup in 4 has missed. */
+        grow_color_index_cache(self);
+        c = hash_paint_values(self, paint_values);
+    }
+    if (self->used < self->size) {
         /* Use a new one */
         i = self->used++;
         include_into_touch_list(self, i);
@@ -231,6 +352,8 @@ get_color_index_cache_elem(gs_color_index_cache_t *self,
         self->recent_touch = self->buf[i].touch_prev; /* Assuming the cyclic list,
                                                       just move the head pointer to the last element. */
         exclude_from_chain(self, i);
+        self->evictions++;
+        self->recent_evictions++;
     }
     include_into_chain(self, i, c);
     *pi = i;
@@ -283,16 +406,16 @@ gs_cached_color_index(gs_color_index_cache_t *self, const float *paint_values,
             if (self->buf[i].color_type == &gx_dc_type_data_pure) {
                 pdevc->colors.pure = self->buf[i].color.cindex;
                 pdevc->type = &gx_dc_type_data_pure;
-                memcpy(pdevc->ccolor.paint.values, paint_values, 
-                       sizeof(*paint_values) * client_num_components);
+                for (j = 0; j < client_num_components; j++)
+                    pdevc->ccolor.paint.values[j] = paint_values[j];
             } else {
                 /* devn case */
                 for (j = 0; j < device_num_components; j++) {
                     pdevc->colors.devn.values[j] = self->buf[i].color.devn[j];
                 }
                 pdevc->type = &gx_dc_type_data_devn;
-                memcpy(pdevc->ccolor.paint.values, paint_values, 
-                       sizeof(*paint_values) * client_num_components);
+                for (j = 0; j < client_num_components; j++)
+                    pdevc->ccolor.paint.values[j] = paint_values[j];
             }
             pdevc->ccolor_valid = true;
         }
@@ -304,10 +427,10 @@ gs_cached_color_index(gs_color_index_cache_t *self, const float *paint_values,
 
         if (pdevc == NULL)
             pdevc = &devc_local;
-        memcpy(self->paint_values + i * client_num_components, paint_values, 
-               sizeof(*paint_values) * client_num_components);
-        memcpy(fcc.paint.values, paint_values, 
-               sizeof(*paint_values) * client_num_components);
+        for (j = 0; j < client_num_components; j++) {
+            self->paint_values[i * client_num_components + j] = paint_values[j];
+            fcc.paint.values[j] = paint_values[j];
+        }
         code = pcs->type->remap_color(&fcc, pcs, pdevc, self->pgs, 
                                       self->trans_dev, gs_color_select_texture);
         if (code < 0)
@@ -327,8 +450,9 @@ gs_cached_color_index(gs_color_index_cache_t *self, const float *paint_values,
         else
             self->buf[i].frac_values_done = false;
     }
-    if (frac_values != NULL)
-        memcpy(frac_values, self->frac_values + i * device_num_components, 
-               sizeof(*frac_values) * device_num_components);
+    if (frac_values != NULL) {
+        for (j = 0; j < device_num_components; j++)
+            frac_values[j] = self->frac_values[i * device_num_components + j];
+    }
     return 0;
 }
@@ -434,6 +434,7 @@ struct gsicc_link_s {
     bool includes_devlink;
     bool is_identity;  /* Used for noting that this is an identity profile */
     bool valid;		/* true once link is completely built and usable */
+    bool failed;	/* the build failed, the link is no longer in the cache */
     bool is_monitored;
     gscms_procs_t orig_procs;  /* procs to use after monitoring */
     gsicc_colorbuffer_t data_cs; /* needed for begin_monitor after end_monitor */
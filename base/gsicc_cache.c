@@ -35,6 +35,8 @@
 #include "gxsync.h"
 #include "gzstate.h"
 #include "stdint_.h"
+#include "gp.h"
+#include "gxiodev.h"
         /*
          *  Note that the the external memory used to maintain
          *  links in the CMS is generally not visible to GS.
@@ -62,6 +64,7 @@ static int gsicc_compute_linkhash(gsicc_manager_t *icc_manager, gx_device *dev,
                                   gsicc_hashlink_t *hash);
 
 static void gsicc_remove_link(gsicc_link_t *link, const gs_memory_t *memory);
+static void gsicc_link_failed(gsicc_link_t *link, const gs_memory_t *memory);
 
 static void gsicc_get_buff_hash(unsigned char *data, int64_t *hash, unsigned int num_bytes);
 
@@ -294,6 +297,7 @@ gsicc_alloc_link(gs_memory_t *memory, gsicc_hashlink_t hashcode)
     result->includes_devlink = 0;
     result->is_identity = false;
     result->valid = false;		/* not yet complete */
+    result->failed = false;
     result->memory = memory->stable_memory;
 
     result->lock = gx_monitor_label(gx_monitor_alloc(memory->stable_memory),
@@ -458,6 +462,128 @@ gsicc_compute_linkhash(gsicc_manager_t *icc_manager, gx_device *dev,
     return 0;
 }
 
+/*
+ * The link store.  When the ICCLinkCacheDir user parameter names a
+ * directory, each link that is built is also written there, as a device
+ * link profile (which the CMS holds as a precomputed table), and a later
+ * run that needs the same link reads it back rather than building it
+ * again.  The file name is a hash of everything that goes into building
+ * the link: the source and destination profiles, the rendering parameters,
+ * any proof or device link profile, the CMM flags and the color accuracy.
+ * A file that can't be read or used is simply ignored, and the link is
+ * built (and the file written again) as usual.
+ */
+static bool
+gsicc_link_store_name(char *fname, gs_memory_t *memory,
+                      const gsicc_hashlink_t *hash,
+                      const gsicc_rendering_param_t *rendering_params,
+                      cmm_profile_t *proof_profile,
+                      cmm_profile_t *devlink_profile,
+                      bool src_dev_link, bool graytok, int cms_flags)
+{
+    gs_lib_ctx_t *ctx = memory->gs_lib_ctx;
+    int64_t key[11];
+    byte data[sizeof(key) / sizeof(key[0]) * 8];
+    int64_t key_hash;
+    int i, k;
+
+    if (ctx->linkcachedir == NULL ||
+        ctx->linkcachedir_len + 24 >= gp_file_name_sizeof)
+        return false;
+    if ((proof_profile != NULL && !proof_profile->hash_is_valid &&
+         proof_profile->buffer == NULL) ||
+        (devlink_profile != NULL && !devlink_profile->hash_is_valid &&
+         devlink_profile->buffer == NULL))
+        return false;
+    key[0] = hash->src_hash;
+    key[1] = hash->des_hash;
+    key[2] = rendering_params->black_point_comp;
+    key[3] = rendering_params->rendering_intent;
+    key[4] = rendering_params->preserve_black;
+    key[5] = (proof_profile == NULL ? 0 : gsicc_get_hash(proof_profile));
+    key[6] = (devlink_profile == NULL ? 0 : gsicc_get_hash(devlink_profile));
+    key[7] = src_dev_link;
+    key[8] = graytok;
+    key[9] = cms_flags;
+    key[10] = gs_lib_ctx_get_interp_instance(memory)->icc_color_accuracy;
+    /* Byte order independent, so that the names are the same everywhere. */
+    for (i = 0; i < sizeof(key) / sizeof(key[0]); i++)
+        for (k = 0; k < 8; k++)
+            data[i * 8 + k] = (byte)(key[i] >> (k * 8));
+    gsicc_get_buff_hash(data, &key_hash, sizeof(data));
+    memcpy(fname, ctx->linkcachedir, ctx->linkcachedir_len);
+    gs_sprintf(fname + ctx->linkcachedir_len, "gslink_%08x%08x.icc",
+               (unsigned int)((uint64_t)key_hash >> 32),
+               (unsigned int)key_hash);
+    return true;
+}
+
+static gcmmhlink_t
+gsicc_link_store_read(const char *fname, gs_memory_t *memory)
+{
+    gp_file *fid;
+    gs_offset_t size;
+    unsigned char *buffer;
+    gcmmhlink_t link_handle = NULL;
+
+    fid = gp_fopen(memory, fname, "rb");
+    if (fid == NULL)
+        return NULL;
+    if (gp_fseek(fid, 0, SEEK_END) == 0 && (size = gp_ftell(fid)) > 0 &&
+        size < max_uint && gp_fseek(fid, 0, SEEK_SET) == 0) {
+        buffer = gs_alloc_bytes(memory, size, "gsicc_link_store_read");
+        if (buffer != NULL) {
+            if (gp_fread(buffer, 1, size, fid) == size)
+                link_handle = gscms_get_link_from_devicelink(buffer, size,
+                                                             memory);
+            gs_free_object(memory, buffer, "gsicc_link_store_read");
+        }
+    }
+    gp_fclose(fid);
+    return link_handle;
+}
+
+/*
+ * Write a link to the store.  The device link profile holds the link as a
+ * table sampled from it, which can differ very slightly from the link
+ * itself, so this also returns the link made from the device link: using
+ * that rather than the original gives the same results whether or not the
+ * link was already in the store.  The file is written under a temporary
+ * name and then renamed, so that another process reading the store never
+ * sees it half written.  Both names are checked against the file
+ * permissions (with -dSAFER, PermitFileWriting), as the rename doesn't.
+ */
+static gcmmhlink_t
+gsicc_link_store_write(const char *fname, gcmmhlink_t link_handle,
+                       gs_memory_t *memory)
+{
+    gx_io_device *iodev = iodev_default(memory);
+    char tmpname[gp_file_name_sizeof];
+    gp_file *fid;
+    unsigned char *buffer;
+    unsigned int size;
+    gcmmhlink_t stored_handle;
+    bool ok;
+
+    if (gp_validate_path(memory, fname, "w") != 0)
+        return NULL;
+    if (gscms_get_devicelink_buffer(link_handle, &buffer, &size, memory) < 0)
+        return NULL;
+    stored_handle = gscms_get_link_from_devicelink(buffer, size, memory);
+    if (stored_handle != NULL) {
+        fid = gp_open_scratch_file(memory, fname, tmpname, "wb");
+        if (fid != NULL) {
+            ok = gp_fwrite(buffer, 1, size, fid) == size;
+            ok = gp_fclose(fid) == 0 && ok;
+            if (!ok || gp_validate_path(memory, tmpname, "w") != 0 ||
+                iodev->procs.rename_file(iodev, tmpname, fname) < 0)
+                iodev->procs.delete_file(iodev, tmpname);
+        }
+    }
+    gs_free_object(memory, buffer, "gsicc_link_store_write");
+    return stored_handle;
+}
+
 static int
 gsicc_get_cspace_hash(gsicc_manager_t *icc_manager, gx_device *dev,
                       cmm_profile_t *cmm_icc_profile_data, int64_t *hash)
@@ -491,16 +617,16 @@ gsicc_get_cspace_hash(gsicc_manager_t *icc_manager, gx_device *dev,
     return 0;
 }
 
-gsicc_link_t*
-gsicc_findcachelink(gsicc_hashlink_t hash, gsicc_link_cache_t *icc_link_cache,
-                    bool includes_proof, bool includes_devlink)
+/* Look for the link in the cache and, if it is there, bump its ref_count
+   so that it can't be removed.  The cache lock must be held by the caller.
+   The link returned may still be being built by another thread. */
+static gsicc_link_t*
+gsicc_findcachelink_locked(gsicc_hashlink_t hash, gsicc_link_cache_t *icc_link_cache,
+                           bool includes_proof, bool includes_devlink)
 {
     gsicc_link_t *curr, *prev;
     int64_t hashcode = hash.link_hashcode;
 
-    /* Look through the cache for the hashcode */
-    gx_monitor_enter(icc_link_cache->lock);
-
     /* List scanning is fast, so we scan the entire list, this includes   */
     /* links that are currently unused, but still in the cache (zero_ref) */
     curr = icc_link_cache->head;
@@ -522,28 +648,69 @@ gsicc_findcachelink(gsicc_hashlink_t hash, gsicc_link_cache_t *icc_link_cache,
             curr->ref_count++;
             if_debug3m('^', curr->memory, "[^]%s "PRI_INTPTR" ++ => %d\n",
                        "icclink", (intptr_t)curr, curr->ref_count);
-            while (curr->valid == false) {
-                gx_monitor_leave(icc_link_cache->lock); /* exit to let other threads run briefly */
-                gx_monitor_enter(curr->lock);			/* wait until we can acquire the lock */
-                gx_monitor_leave(curr->lock);			/* it _should be valid now */
-                /* If it is still not valid, but we were able to lock, it means that the thread	*/
-                /* that was building it failed to be able to complete building it		*/
-                /* this is probably a fatal error. MV ???					*/
-                if (curr->valid == false) {
-		  emprintf1(curr->memory, "link "PRI_INTPTR" lock released, but still not valid.\n", (intptr_t)curr);	/* Breakpoint here */
-                }
-                gx_monitor_enter(icc_link_cache->lock);	/* re-enter to loop and check */
-            }
-            gx_monitor_leave(icc_link_cache->lock);
-            return(curr);	/* success */
+            return curr;
         }
         prev = curr;
         curr = curr->next;
     }
-    gx_monitor_leave(icc_link_cache->lock);
     return NULL;
 }
 
+/* Wait until a link found by gsicc_findcachelink_locked is valid.  Called
+   with the cache lock held, which is released on return.  The thread that
+   is building the link owns the link's lock until the link is valid, so
+   waiting on that lock doesn't hold up lookups of other links.  If the
+   build fails (see gsicc_link_failed) our reference to the link is dropped
+   and an error returned. */
+static int
+gsicc_wait_link_valid(gsicc_link_t *curr, gsicc_link_cache_t *icc_link_cache)
+{
+    bool last;
+
+    while (curr->valid == false) {
+        gx_monitor_leave(icc_link_cache->lock); /* exit to let other threads run briefly */
+        gx_monitor_enter(curr->lock);			/* wait until we can acquire the lock */
+        gx_monitor_leave(curr->lock);			/* it _should be valid now */
+        gx_monitor_enter(icc_link_cache->lock);	/* re-enter to loop and check */
+        if (curr->failed) {
+            last = --curr->ref_count == 0;
+            if_debug2m('^', curr->memory, "[^]icclink "PRI_INTPTR" -- => %d\n",
+                       (intptr_t)curr, curr->ref_count);
+            gx_monitor_leave(icc_link_cache->lock);
+            if (last)
+                gsicc_link_free(curr, curr->memory);
+            return_error(gs_error_unknownerror);
+        }
+        /* If it is still not valid, but we were able to lock, it means that the thread	*/
+        /* that was building it failed to be able to complete building it		*/
+        /* this is probably a fatal error. MV ???					*/
+        if (curr->valid == false) {
+          emprintf1(curr->memory, "link "PRI_INTPTR" lock released, but still not valid.\n", (intptr_t)curr);	/* Breakpoint here */
+        }
+    }
+    gx_monitor_leave(icc_link_cache->lock);
+    return 0;
+}
+
+gsicc_link_t*
+gsicc_findcachelink(gsicc_hashlink_t hash, gsicc_link_cache_t *icc_link_cache,
+                    bool includes_proof, bool includes_devlink)
+{
+    gsicc_link_t *curr;
+
+    /* Look through the cache for the hashcode */
+    gx_monitor_enter(icc_link_cache->lock);
+    curr = gsicc_findcachelink_locked(hash, icc_link_cache, includes_proof,
+                                      includes_devlink);
+    if (curr == NULL) {
+        gx_monitor_leave(icc_link_cache->lock);
+        return NULL;
+    }
+    if (gsicc_wait_link_valid(curr, icc_link_cache) < 0)
+        return NULL;
+    return(curr);	/* success */
+}
+
 /* Remove link from cache.  Notify CMS and free */
 static void
 gsicc_remove_link(gsicc_link_t *link, const gs_memory_t *memory)
@@ -591,6 +758,50 @@ gsicc_remove_link(gsicc_link_t *link, const gs_memory_t *memory)
     }
 }
 
+/* The build of a link reserved by gsicc_alloc_link_entry failed.  Take the
+   link out of the cache, so that nobody else finds it, and release its lock
+   to wake any threads waiting for it to become valid; they see that it
+   failed and drop their references (see gsicc_wait_link_valid).  Whoever
+   drops the last reference frees it. */
+static void
+gsicc_link_failed(gsicc_link_t *link, const gs_memory_t *memory)
+{
+    gsicc_link_t *curr, *prev;
+    gsicc_link_cache_t *icc_link_cache = link->icc_link_cache;
+    bool last;
+
+    if_debug2m(gs_debug_flag_icc, memory,
+               "[icc] Failed link = "PRI_INTPTR" memory = "PRI_INTPTR"\n",
+               (intptr_t)link, (intptr_t)memory->stable_memory);
+    gx_monitor_enter(icc_link_cache->lock);
+    link->failed = true;
+    curr = icc_link_cache->head;
+    prev = NULL;
+    while (curr != NULL && curr != link) {
+        prev = curr;
+        curr = curr->next;
+    }
+    if (curr == link) {
+        if (prev == NULL)
+            icc_link_cache->head = link->next;
+        else
+            prev->next = link->next;
+        link->next = NULL;
+        icc_link_cache->num_links--;	/* no longer in the cache */
+        if (icc_link_cache->cache_full) {
+            icc_link_cache->cache_full = false;
+            gx_semaphore_signal(icc_link_cache->full_wait);	/* let a waiting thread run */
+        }
+    }
+    last = --link->ref_count == 0;	/* this thread no longer using this link entry */
+    if_debug2m('^', link->memory, "[^]icclink "PRI_INTPTR" -- => %d\n",
+               (intptr_t)link, link->ref_count);
+    gx_monitor_leave(icc_link_cache->lock);
+    gx_monitor_leave(link->lock);
+    if (last)
+        gsicc_link_free(link, memory);
+}
+
 static void
 gsicc_get_srcprofile(gsicc_colorbuffer_t data_cs,
     gs_graphics_type_tag_t graphics_type_tag,
@@ -833,6 +1044,7 @@ gsicc_get_link(const gs_gstate *pgs1, gx_device *dev_in,
    come from the CMM or they may come from the non color managed approach
    (i.e. gsicc_nocm_get_link)
    Returns true if link was found with that has, false if alloc fails.
+   A link that was found but whose build failed is returned as NULL.
 */
 bool
 gsicc_alloc_link_entry(gsicc_link_cache_t *icc_link_cache,
@@ -846,6 +1058,18 @@ gsicc_alloc_link_entry(gsicc_link_cache_t *icc_link_cache,
     /* First see if we can add a link */
     /* TODO: this should be based on memory usage, not just num_links */
     gx_monitor_enter(icc_link_cache->lock);
+    /* The link cache is shared by the rendering threads, so another thread
+       may have started on this link since our gsicc_findcachelink missed.
+       Looking again while we hold the lock, and reserving the entry before
+       we release it, means that each link is only built once however many
+       threads ask for it; the others wait for it to become valid. */
+    *ret_link = gsicc_findcachelink_locked(hash, icc_link_cache,
+                                           include_softproof, include_devlink);
+    if (*ret_link != NULL) {
+        if (gsicc_wait_link_valid(*ret_link, icc_link_cache) < 0)
+            *ret_link = NULL;
+        return true;
+    }
     while (icc_link_cache->num_links >= ICC_CACHE_MAXLINKS) {
         /* Look through the cache for first zero ref count to re-use that entry.
            When ref counts go to zero, the icc_link will have been moved to
@@ -870,15 +1094,17 @@ gsicc_alloc_link_entry(gsicc_link_cache_t *icc_link_cache,
             /* unlock while waiting for a link to come available */
             gx_monitor_leave(icc_link_cache->lock);
             gx_semaphore_wait(icc_link_cache->full_wait);
-            /* repeat the findcachelink to see if some other thread has	*/
+            gx_monitor_enter(icc_link_cache->lock);	    /* restore the lock */
+            /* repeat the lookup to see if some other thread has	*/
             /* already started building the link we need		*/
-            *ret_link = gsicc_findcachelink(hash, icc_link_cache,
-                                            include_softproof, include_devlink);
+            *ret_link = gsicc_findcachelink_locked(hash, icc_link_cache,
+                                                   include_softproof, include_devlink);
             /* Got a hit, return link. ref_count for the link was already bumped */
-            if (*ret_link != NULL)
+            if (*ret_link != NULL) {
+                if (gsicc_wait_link_valid(*ret_link, icc_link_cache) < 0)
+                    *ret_link = NULL;
                 return true;
-
-            gx_monitor_enter(icc_link_cache->lock);	    /* restore the lock */
+            }
         } else {
             /* Remove the zero ref_count link profile we found.		*/
             /* Even if we remove this link, we may still be maxed out so*/
@@ -937,6 +1163,9 @@ gsicc_get_link_profile(const gs_gstate *pgs, gx_device *dev,
     bool src_dev_link = gs_input_profile->isdevlink;
     bool pageneutralcolor = false;
     int cms_flags = 0;
+    bool graytok = false;
+    bool use_store, from_store = false;
+    char store_fname[gp_file_name_sizeof];
 
     /* Determine if we are using a soft proof or device link profile */
     if (dev != NULL ) {
@@ -1059,19 +1288,24 @@ gsicc_get_link_profile(const gs_gstate *pgs, gx_device *dev,
                 gsicc_get_profile_handle_buffer(gs_input_profile->buffer,
                                                 gs_input_profile->buffer_size,
                                                 memory);
-            if (cms_input_profile == NULL)
+            if (cms_input_profile == NULL) {
+                gsicc_link_failed(link, cache_mem);
                 return NULL;
+            }
             gs_input_profile->profile_handle = cms_input_profile;
             /* This *must* be a default profile that was not set up at start-up/
                However it could be one from the icc creator code which does not
                do an initialization at the time of creation from CalRGB etc. */
             code = gsicc_initialize_default_profile(gs_input_profile);
-            if (code < 0) return NULL;
+            if (code < 0) {
+                gsicc_link_failed(link, cache_mem);
+                return NULL;
+            }
         } else {
             /* Cant create the link.  No profile present,
                nor any defaults to use for this.  Really
                need to throw an error for this case. */
-            gsicc_remove_link(link, cache_mem);
+            gsicc_link_failed(link, cache_mem);
             return NULL;
         }
     }
@@ -1089,7 +1323,10 @@ gsicc_get_link_profile(const gs_gstate *pgs, gx_device *dev,
             gs_output_profile->profile_handle = cms_output_profile;
             /* This *must* be a default profile that was not set up at start-up */
             code = gsicc_initialize_default_profile(gs_output_profile);
-            if (code < 0) return NULL;
+            if (code < 0) {
+                gsicc_link_failed(link, cache_mem);
+                return NULL;
+            }
         } else {
               /* See if we have a clist device pointer. */
             if ( gs_output_profile->dev != NULL ) {
@@ -1103,7 +1340,7 @@ gsicc_get_link_profile(const gs_gstate *pgs, gx_device *dev,
                 /* Cant create the link.  No profile present,
                    nor any defaults to use for this.  Really
                    need to throw an error for this case. */
-                gsicc_remove_link(link, cache_mem);
+                gsicc_link_failed(link, cache_mem);
                 return NULL;
             }
         }
@@ -1121,7 +1358,7 @@ gsicc_get_link_profile(const gs_gstate *pgs, gx_device *dev,
                     gx_monitor_enter(proof_profile->lock);
             } else {
                 /* Cant create the link */
-                gsicc_remove_link(link, cache_mem);
+                gsicc_link_failed(link, cache_mem);
                 return NULL;
             }
         }
@@ -1139,7 +1376,7 @@ gsicc_get_link_profile(const gs_gstate *pgs, gx_device *dev,
                     gx_monitor_enter(devlink_profile->lock);
             } else {
                 /* Cant create the link */
-                gsicc_remove_link(link, cache_mem);
+                gsicc_link_failed(link, cache_mem);
                 return NULL;
             }
         }
@@ -1168,7 +1405,7 @@ gsicc_get_link_profile(const gs_gstate *pgs, gx_device *dev,
                                           pgs->icc_manager->memory->stable_memory);
             if (icc_manager->graytok_profile == NULL) {
                 /* Cant create the link */	/* FIXME: clean up allocations and locksso far ??? */
-                gsicc_remove_link(link, cache_mem);
+                gsicc_link_failed(link, cache_mem);
                 return NULL;
             }
         }
@@ -1182,9 +1419,28 @@ gsicc_get_link_profile(const gs_gstate *pgs, gx_device *dev,
         /* Turn off bp compensation in this case as there is a bug in lcms */
         rendering_params->black_point_comp = false;
         cms_flags = 0;  /* Turn off any flag setting */
+        graytok = true;
+    }
+    /* See if the link is in the link store.  This has to be looked up
+       before the CMS gets the rendering parameters, which it may change. */
+    use_store = gsicc_link_store_name(store_fname, cache_mem,
+                                      &hash, rendering_params,
+                                      include_softproof ? proof_profile : NULL,
+                                      include_devicelink ? devlink_profile : NULL,
+                                      src_dev_link, graytok, cms_flags);
+    if (use_store) {
+        link_handle = gsicc_link_store_read(store_fname,
+                                            cache_mem->non_gc_memory);
+        if (link_handle != NULL) {
+            from_store = true;
+            if_debug1m(gs_debug_flag_icc, cache_mem,
+                       "[icc] Link read from %s\n", store_fname);
+        }
     }
     /* Get the link with the proof and or device link profile */
-    if (include_softproof || include_devicelink || src_dev_link) {
+    if (link_handle != NULL) {
+        /* Already got it from the store */
+    } else if (include_softproof || include_devicelink || src_dev_link) {
         link_handle = gscms_get_link_proof_devlink(cms_input_profile,
                                                    cms_proof_profile,
                                                    cms_output_profile,
@@ -1192,6 +1448,11 @@ gsicc_get_link_profile(const gs_gstate *pgs, gx_device *dev,
                                                    rendering_params,
                                                    src_dev_link, cms_flags,
                                                    cache_mem->non_gc_memory);
+    } else {
+        link_handle = gscms_get_link(cms_input_profile, cms_output_profile,
+                                     rendering_params, cms_flags,
+                                     cache_mem->non_gc_memory);
+    }
     if (!gscms_is_threadsafe()) {
         if (include_softproof) {
             gx_monitor_leave(proof_profile->lock);
@@ -1200,11 +1461,6 @@ gsicc_get_link_profile(const gs_gstate *pgs, gx_device *dev,
             gx_monitor_leave(devlink_profile->lock);
         }
     }
-    } else {
-        link_handle = gscms_get_link(cms_input_profile, cms_output_profile,
-                                     rendering_params, cms_flags,
-                                     cache_mem->non_gc_memory);
-    }
     if (!gscms_is_threadsafe()) {
         if (!src_dev_link) {
             gx_monitor_leave(gs_output_profile->lock);
@@ -1212,6 +1468,19 @@ gsicc_get_link_profile(const gs_gstate *pgs, gx_device *dev,
         gx_monitor_leave(gs_input_profile->lock);
     }
     if (link_handle != NULL) {
+        if (use_store && !from_store) {
+            gcmmhlink_t stored_handle =
+                gsicc_link_store_write(store_fname, link_handle,
+                                       cache_mem->non_gc_memory);
+
+            if (stored_handle != NULL) {
+                /* Release the link that was built in favour of the stored
+                   one, see gsicc_link_store_write. */
+                link->link_handle = link_handle;
+                gscms_release_link(link);
+                link_handle = stored_handle;
+            }
+        }
         if (gs_input_profile->data_cs == gsGRAY)
             pageneutralcolor = false;
 
@@ -1230,19 +1499,9 @@ gsicc_get_link_profile(const gs_gstate *pgs, gx_device *dev,
                    gs_output_profile->num_comps,
                    (long long)gs_output_profile->hashcode);
     } else {
-        /* If other threads are waiting, we won't have set link->valid true.	*/
-        /* This could result in an infinite loop if other threads are waiting	*/
-        /* for it to be made valid. (see gsicc_findcachelink).			*/
-        link->ref_count--;	/* this thread no longer using this link entry	*/
-        if_debug2m('^', link->memory, "[^]icclink "PRI_INTPTR" -- => %d\n",
-                   (intptr_t)link, link->ref_count);
-
-        if (icc_link_cache->cache_full) {
-            icc_link_cache->cache_full = false;
-            gx_semaphore_signal(icc_link_cache->full_wait);	/* let a waiting thread run */
-        }
-        gx_monitor_leave(link->lock);
-        gsicc_remove_link(link, cache_mem);
+        /* Other threads may be waiting for the link to be made valid, so	*/
+        /* tell them that it won't be (see gsicc_wait_link_valid).		*/
+        gsicc_link_failed(link, cache_mem);
         return NULL;
     }
     return link;
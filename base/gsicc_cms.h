@@ -67,6 +67,11 @@ gcmmhlink_t gscms_get_link(gcmmhprofile_t lcms_srchandle,
                            gsicc_rendering_param_t *rendering_params,
                            int cmm_flags,
                            gs_memory_t *memory);
+int gscms_get_devicelink_buffer(gcmmhlink_t link, unsigned char **buffer,
+                                unsigned int *size, gs_memory_t *memory);
+gcmmhlink_t gscms_get_link_from_devicelink(unsigned char *buffer,
+                                           unsigned int size,
+                                           gs_memory_t *memory);
 gcmmhlink_t gscms_get_link_proof_devlink(gcmmhprofile_t lcms_srchandle,
                                          gcmmhprofile_t lcms_proofhandle,
                                          gcmmhprofile_t lcms_deshandle,
@@ -586,6 +586,84 @@ gscms_get_link(gcmmhprofile_t  lcms_srchandle,
     /* cmsFLAGS_HIGHRESPRECALC)  cmsFLAGS_NOTPRECALC  cmsFLAGS_LOWRESPRECALC*/
 }
 
+/* Write a link out as a device link profile, so that it can be kept and
+   used again by gscms_get_link_from_devicelink.  The buffer is allocated
+   in memory and belongs to the caller */
+int
+gscms_get_devicelink_buffer(gcmmhlink_t link, unsigned char **buffer,
+                            unsigned int *size, gs_memory_t *memory)
+{
+    cmsHPROFILE hProfile;
+    cmsUInt32Number num_bytes = 0;
+    unsigned char *buf;
+
+    *buffer = NULL;
+    *size = 0;
+    hProfile = cmsTransform2DeviceLink(link, 4.3, 0);
+    if (hProfile == NULL)
+        return_error(gs_error_unknownerror);
+    if (!cmsSaveProfileToMem(hProfile, NULL, &num_bytes) || num_bytes == 0) {
+        cmsCloseProfile(hProfile);
+        return_error(gs_error_unknownerror);
+    }
+    buf = gs_alloc_bytes(memory, num_bytes, "gscms_get_devicelink_buffer");
+    if (buf == NULL) {
+        cmsCloseProfile(hProfile);
+        return_error(gs_error_VMerror);
+    }
+    if (!cmsSaveProfileToMem(hProfile, buf, &num_bytes)) {
+        cmsCloseProfile(hProfile);
+        gs_free_object(memory, buf, "gscms_get_devicelink_buffer");
+        return_error(gs_error_unknownerror);
+    }
+    cmsCloseProfile(hProfile);
+    *buffer = buf;
+    *size = num_bytes;
+    return 0;
+}
+
+/* Get a link back from a device link profile written by
+   gscms_get_devicelink_buffer.  The rendering parameters and the flags
+   were applied when the device link was made, and the white point fix up
+   too if it was wanted, so none of them are used again here. */
+gcmmhlink_t
+gscms_get_link_from_devicelink(unsigned char *buffer, unsigned int size,
+                               gs_memory_t *memory)
+{
+    cmsContext ctx = gs_lib_ctx_get_cms_context(memory);
+    cmsHPROFILE hProfile;
+    cmsColorSpaceSignature src_color_space, des_color_space;
+    int lcms_src_color_space, lcms_des_color_space;
+    cmsUInt32Number src_data_type, des_data_type;
+    cmsHTRANSFORM hTransform;
+
+    hProfile = cmsOpenProfileFromMemTHR(ctx, buffer, size);
+    if (hProfile == NULL)
+        return NULL;
+    if (cmsGetDeviceClass(hProfile) != cmsSigLinkClass) {
+        cmsCloseProfile(hProfile);
+        return NULL;
+    }
+    src_color_space = cmsGetColorSpace(hProfile);
+    lcms_src_color_space = _cmsLCMScolorSpace(src_color_space);
+    if (lcms_src_color_space < 0)
+        lcms_src_color_space = 0;
+    src_data_type = (COLORSPACE_SH(lcms_src_color_space)|
+                        CHANNELS_SH(cmsChannelsOf(src_color_space))|BYTES_SH(2));
+    des_color_space = cmsGetPCS(hProfile);
+    lcms_des_color_space = _cmsLCMScolorSpace(des_color_space);
+    if (lcms_des_color_space < 0)
+        lcms_des_color_space = 0;
+    des_data_type = (COLORSPACE_SH(lcms_des_color_space)|
+                        CHANNELS_SH(cmsChannelsOf(des_color_space))|BYTES_SH(2));
+    hTransform = cmsCreateTransformTHR(ctx, hProfile, src_data_type,
+                                       NULL, des_data_type, INTENT_PERCEPTUAL,
+                                       cmsFLAGS_HIGHRESPRECALC |
+                                       cmsFLAGS_NOWHITEONWHITEFIXUP);
+    cmsCloseProfile(hProfile);
+    return hTransform;
+}
+
 /* Get the link from the CMS, but include proofing and/or a device link
    profile.  Note also, that the source may be a device link profile, in
    which case we will not have a destination profile but could still have
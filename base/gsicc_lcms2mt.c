@@ -35,6 +35,10 @@
 #include "gxsync.h"
 #endif
 
+#ifdef HAVE_SSE2
+#include <emmintrin.h>
+#endif
+
 #define DUMP_CMS_BUFFER 0
 #define DEBUG_LCMS_MEM 0
 #define LCMS_BYTES_MASK T_BYTES(-1)	/* leaves only mask for the BYTES (currently 7) */
@@ -183,6 +187,483 @@ static cmsPluginMutex gs_cms_mutexhandler =
 
 #endif
 
+/*
+ * Nearly all the links that gscms_get_link makes are optimised by lcms into
+ * a single 16 bit CLUT with 3 (RGB, Lab) or 4 (CMYK) inputs.  lcms then
+ * evaluates it a pixel at a time, through the formatters of the transform
+ * and an interpolator that loops over the outputs.  For the usual 3 and 4
+ * outputs this transform plugin evaluates the CLUT instead, from a copy of
+ * the table in which each node is padded to 4 values.  With SSE2 a node is
+ * then a single 64 bit load, and all the outputs of a pixel are
+ * interpolated at once.  The arithmetic is that of TetrahedralInterp16 (3
+ * inputs) and Eval4Inputs (4 inputs), so the results are the same as those
+ * of lcms.
+ *
+ * Only transforms created with 16 bit formats (as gscms_get_link does) are
+ * taken over, since lcms may choose an 8 bit evaluator for the pipeline
+ * otherwise.  The 8 bit and planar variants that
+ * gscms_transform_color_buffer clones from them come back through the
+ * factory, and share the copy of the table.
+ */
+
+#ifndef cmsFLAGS_CAN_CHANGE_FORMATTER
+#define cmsFLAGS_CAN_CHANGE_FORMATTER 0x02000000	/* from lcms2_internal.h */
+#endif
+
+#define GSICC_CLUT_FROM_8_TO_16(v) ((cmsUInt16Number)(((v) << 8) | (v)))
+#define GSICC_CLUT_FROM_16_TO_8(v) ((byte)((((cmsUInt32Number)(v) * 65281U + 8388608U) >> 24) & 0xff))
+#define GSICC_CLUT_SWAP16(v) ((cmsUInt16Number)(((v) << 8) | ((v) >> 8)))
+
+typedef struct gsicc_clut_in8_s {
+    int base;			/* offset of the node below, in the table */
+    int frac;			/* fraction of the way to the node above */
+    int step;			/* offset from the node below to the one above */
+} gsicc_clut_in8_t;
+
+typedef struct gsicc_clut_s {
+    cmsUInt16Number *table;	/* 4 values per node */
+    int num_in;
+    int num_out;
+    cmsUInt32Number domain[4];	/* per input, as the lcms Domain */
+    int step[4];		/* per input, table values to the next node */
+    gsicc_clut_in8_t in8[4][256];	/* per input, for the 8 bit values */
+} gsicc_clut_t;
+
+/* The memory layout of one side of a transform */
+typedef struct gsicc_clut_layout_s {
+    int num_chan;
+    int bytes;			/* 1 or 2 */
+    bool swap;			/* 16 bit values are of the other endianness */
+    int chan_step;		/* bytes between the channels of a pixel */
+    int pixel_step;		/* bytes between pixels */
+} gsicc_clut_layout_t;
+
+static bool
+gsicc_clut_format_ok(cmsUInt32Number format)
+{
+    return !T_FLOAT(format) && (T_BYTES(format) == 1 || T_BYTES(format) == 2) &&
+        !T_FLAVOR(format) && !T_DOSWAP(format) && !T_SWAPFIRST(format) &&
+        !T_OPTIMIZED(format) && T_COLORSPACE(format) != PT_LabV2;
+}
+
+static void
+gsicc_clut_layout(gsicc_clut_layout_t *layout, cmsUInt32Number format,
+                  cmsUInt32Number plane_stride)
+{
+    layout->num_chan = T_CHANNELS(format);
+    layout->bytes = T_BYTES(format);
+    layout->swap = layout->bytes == 2 && T_ENDIAN16(format);
+    if (T_PLANAR(format)) {
+        layout->chan_step = plane_stride;
+        layout->pixel_step = layout->bytes;
+    } else {
+        layout->chan_step = layout->bytes;
+        layout->pixel_step = (layout->num_chan + T_EXTRA(format)) * layout->bytes;
+    }
+}
+
+/* The same as _cmsToFixedDomain */
+static forceinline int
+gsicc_clut_fixed(int a)
+{
+    return a + ((a + 0x7fff) / 0xffff);
+}
+
+/* Sort the fractions m in decreasing order, along with the offsets o of the
+   next node in each input, and turn the offsets into those of the vertices
+   of the simplex from the first node.  Ties are kept in input order.  This
+   is done without branches, as the order is all but random from one pixel
+   to the next: the place of each input is the number of inputs before it. */
+static forceinline void
+gsicc_clut_sort3(int m[4], int o[4])
+{
+    int sm[3], so[3];
+    int a01 = m[0] >= m[1], a02 = m[0] >= m[2], a12 = m[1] >= m[2];
+
+    sm[2 - a01 - a02] = m[0]; so[2 - a01 - a02] = o[0];
+    sm[1 + a01 - a12] = m[1]; so[1 + a01 - a12] = o[1];
+    sm[a02 + a12] = m[2]; so[a02 + a12] = o[2];
+    m[0] = sm[0]; m[1] = sm[1]; m[2] = sm[2];
+    o[0] = so[0]; o[1] = o[0] + so[1]; o[2] = o[1] + so[2];
+}
+
+static forceinline void
+gsicc_clut_sort4(int m[4], int o[4])
+{
+    int sm[4], so[4];
+    int a01 = m[0] >= m[1], a02 = m[0] >= m[2], a03 = m[0] >= m[3];
+    int a12 = m[1] >= m[2], a13 = m[1] >= m[3], a23 = m[2] >= m[3];
+
+    sm[3 - a01 - a02 - a03] = m[0]; so[3 - a01 - a02 - a03] = o[0];
+    sm[2 + a01 - a12 - a13] = m[1]; so[2 + a01 - a12 - a13] = o[1];
+    sm[1 + a02 + a12 - a23] = m[2]; so[1 + a02 + a12 - a23] = o[2];
+    sm[a03 + a13 + a23] = m[3]; so[a03 + a13 + a23] = o[3];
+    m[0] = sm[0]; m[1] = sm[1]; m[2] = sm[2]; m[3] = sm[3];
+    o[0] = so[0]; o[1] = o[0] + so[1]; o[2] = o[1] + so[2]; o[3] = o[2] + so[3];
+}
+
+/* Find the first node of the cell of a pixel, and the simplex in it. */
+static forceinline const cmsUInt16Number *
+gsicc_clut_cell(const gsicc_clut_t *clut, const cmsUInt16Number in[],
+                int m[4], int o[4], const int num_in)
+{
+    int i, f;
+    const cmsUInt16Number *t = clut->table;
+
+    for (i = 0; i < num_in; i++) {
+        f = gsicc_clut_fixed((int)in[i] * clut->domain[i]);
+        t += clut->step[i] * (f >> 16);
+        m[i] = f & 0xffff;
+        o[i] = (in[i] == 0xffff ? 0 : clut->step[i]);
+    }
+    if (num_in == 3)
+        gsicc_clut_sort3(m, o);
+    else
+        gsicc_clut_sort4(m, o);
+    return t;
+}
+
+static forceinline const cmsUInt16Number *
+gsicc_clut_cell8(const gsicc_clut_t *clut, const byte in[],
+                 int m[4], int o[4], const int num_in)
+{
+    int i;
+    const cmsUInt16Number *t = clut->table;
+    const gsicc_clut_in8_t *e;
+
+    for (i = 0; i < num_in; i++) {
+        e = &clut->in8[i][in[i]];
+        t += e->base;
+        m[i] = e->frac;
+        o[i] = e->step;
+    }
+    if (num_in == 3)
+        gsicc_clut_sort3(m, o);
+    else
+        gsicc_clut_sort4(m, o);
+    return t;
+}
+
+#ifdef HAVE_SSE2
+/* The products of the 4 values of each of two nodes with a weight for
+   each node, as 32 bit values. */
+static forceinline void
+sse2_clut_mul(__m128i nodes, int w0, int w1, __m128i *p0, __m128i *p1)
+{
+    __m128i w = _mm_cvtsi32_si128((int)((unsigned int)w0 | ((unsigned int)w1 << 16)));
+    __m128i lo, hi;
+
+    w = _mm_unpacklo_epi16(w, w);
+    w = _mm_unpacklo_epi32(w, w);
+    lo = _mm_mullo_epi16(nodes, w);
+    hi = _mm_mulhi_epu16(nodes, w);
+    *p0 = _mm_unpacklo_epi16(lo, hi);
+    *p1 = _mm_unpackhi_epi16(lo, hi);
+}
+
+#define sse2_clut_node(t) _mm_loadl_epi64((const __m128i *)(t))
+
+/* Interpolate in the simplex found by gsicc_clut_cell.  The outputs are in
+   the low 16 bits of the 4 32 bit values of the result. */
+static forceinline __m128i
+sse2_clut_lerp(const cmsUInt16Number *t, const int m[4], const int o[4],
+               const int num_in)
+{
+    __m128i c0 = sse2_clut_node(t);
+    __m128i p0, p1, p2, p3, p4, rest, x, s, q;
+
+    sse2_clut_mul(_mm_unpacklo_epi64(c0, sse2_clut_node(t + o[0])),
+                  m[0], m[0] - m[1], &p0, &p1);
+    if (num_in == 3) {
+        sse2_clut_mul(_mm_unpacklo_epi64(sse2_clut_node(t + o[1]),
+                                         sse2_clut_node(t + o[2])),
+                      m[1] - m[2], m[2], &p2, &p3);
+        /* rest = (c1 - c0) * m0 + (c2 - c1) * m1 + (c3 - c2) * m2 + 0x8001 */
+        rest = _mm_add_epi32(_mm_sub_epi32(p1, p0), _mm_add_epi32(p2, p3));
+        rest = _mm_add_epi32(rest, _mm_set1_epi32(0x8001));
+        rest = _mm_srai_epi32(_mm_add_epi32(rest, _mm_srai_epi32(rest, 16)), 16);
+    } else {
+        sse2_clut_mul(_mm_unpacklo_epi64(sse2_clut_node(t + o[1]),
+                                         sse2_clut_node(t + o[2])),
+                      m[1] - m[2], m[2] - m[3], &p2, &p3);
+        sse2_clut_mul(sse2_clut_node(t + o[3]), m[3], 0, &p4, &x);
+        rest = _mm_add_epi32(_mm_sub_epi32(p1, p0), _mm_add_epi32(p2, p3));
+        rest = _mm_add_epi32(rest, p4);
+        /* rest += (rest + 0x7fff) / 0xffff, the division truncating */
+        x = _mm_add_epi32(rest, _mm_set1_epi32(0x7fff));
+        s = _mm_srai_epi32(x, 31);
+        x = _mm_sub_epi32(_mm_xor_si128(x, s), s);
+        q = _mm_add_epi32(x, _mm_srli_epi32(x, 16));
+        q = _mm_srli_epi32(_mm_add_epi32(q, _mm_set1_epi32(1)), 16);
+        q = _mm_sub_epi32(_mm_xor_si128(q, s), s);
+        rest = _mm_add_epi32(rest, q);
+        rest = _mm_srai_epi32(_mm_add_epi32(rest, _mm_set1_epi32(0x8000)), 16);
+    }
+    return _mm_add_epi32(_mm_unpacklo_epi16(c0, _mm_setzero_si128()), rest);
+}
+
+/* GSICC_CLUT_FROM_16_TO_8 of the low 16 bits of each value */
+static forceinline __m128i
+sse2_clut_to8(__m128i v)
+{
+    v = _mm_and_si128(v, _mm_set1_epi32(0xffff));
+    v = _mm_add_epi32(_mm_sub_epi32(_mm_slli_epi32(v, 16), _mm_slli_epi32(v, 8)), v);
+    return _mm_srli_epi32(_mm_add_epi32(v, _mm_set1_epi32(0x800000)), 24);
+}
+#else
+/* Interpolate in the simplex found by gsicc_clut_cell. */
+static forceinline void
+gsicc_clut_lerp(const cmsUInt16Number *t, const int m[4], const int o[4],
+                int out[4], const int num_in, const int num_out)
+{
+    int k, c0, c1, c2, c3, c4, rest;
+
+    for (k = 0; k < num_out; k++) {
+        c0 = t[k];
+        c1 = t[o[0] + k];
+        c2 = t[o[1] + k];
+        c3 = t[o[2] + k];
+        rest = (c1 - c0) * m[0] + (c2 - c1) * m[1] + (c3 - c2) * m[2];
+        if (num_in == 3) {
+            rest += 0x8001;
+            out[k] = c0 + ((rest + (rest >> 16)) >> 16);
+        } else {
+            c4 = t[o[3] + k];
+            rest += (c4 - c3) * m[3];
+            out[k] = c0 + ((gsicc_clut_fixed(rest) + 0x8000) >> 16);
+        }
+    }
+}
+#endif
+
+static forceinline void
+gsicc_clut_run(const gsicc_clut_t *clut, const gsicc_clut_layout_t *lin,
+               const gsicc_clut_layout_t *lout, const byte *src, byte *des,
+               cmsUInt32Number num_pixels, const int num_in, const int num_out,
+               const int bytes_in, const int bytes_out)
+{
+    /* Local copies, which the stores to des can't change */
+    const int in_chan_step = lin->chan_step, in_pixel_step = lin->pixel_step;
+    const int out_chan_step = lout->chan_step, out_pixel_step = lout->pixel_step;
+    const bool in_swap = lin->swap, out_swap = lout->swap;
+    cmsUInt16Number win[4];
+    byte win8[4];
+    int wprev[4];
+    int wout[4];
+    unsigned int packed = 0;
+    const cmsUInt16Number *t;
+    int m[4], o[4];
+    int i, v;
+    bool same;
+
+    for (i = 0; i < num_in; i++)
+        wprev[i] = -1;		/* not a value, so the first pixel is done */
+    for (; num_pixels > 0; num_pixels--) {
+        same = true;
+        for (i = 0; i < num_in; i++) {
+            if (bytes_in == 1) {
+                v = win8[i] = src[i * in_chan_step];
+            } else {
+                v = *(const cmsUInt16Number *)(src + i * in_chan_step);
+                if (in_swap)
+                    v = GSICC_CLUT_SWAP16(v);
+                win[i] = v;
+            }
+            same &= (v == wprev[i]);
+            wprev[i] = v;
+        }
+        src += in_pixel_step;
+        if (!same) {
+            if (bytes_in == 1)
+                t = gsicc_clut_cell8(clut, win8, m, o, num_in);
+            else
+                t = gsicc_clut_cell(clut, win, m, o, num_in);
+#ifdef HAVE_SSE2
+            {
+                __m128i vout = sse2_clut_lerp(t, m, o, num_in);
+
+                if (bytes_out == 1) {
+                    vout = sse2_clut_to8(vout);
+                    vout = _mm_packs_epi32(vout, vout);
+                    packed = _mm_cvtsi128_si32(_mm_packus_epi16(vout, vout));
+                } else
+                    _mm_storeu_si128((__m128i *)wout, vout);
+            }
+#else
+            gsicc_clut_lerp(t, m, o, wout, num_in, num_out);
+            if (bytes_out == 1) {
+                packed = 0;
+                for (i = num_out - 1; i >= 0; i--)
+                    packed = (packed << 8) | GSICC_CLUT_FROM_16_TO_8(wout[i]);
+            }
+#endif
+        }
+        for (i = 0; i < num_out; i++) {
+            if (bytes_out == 1)
+                des[i * out_chan_step] = (byte)(packed >> (8 * i));
+            else if (out_swap)
+                *(cmsUInt16Number *)(des + i * out_chan_step) =
+                    GSICC_CLUT_SWAP16((cmsUInt16Number)wout[i]);
+            else
+                *(cmsUInt16Number *)(des + i * out_chan_step) =
+                    (cmsUInt16Number)wout[i];
+        }
+        des += out_pixel_step;
+    }
+}
+
+static void
+gsicc_clut_xform(cmsContext ContextID, struct _cmstransform_struct *CMMcargo,
+                 const void *InputBuffer, void *OutputBuffer,
+                 cmsUInt32Number PixelsPerLine, cmsUInt32Number LineCount,
+                 const cmsStride *Stride)
+{
+    const gsicc_clut_t *clut = (const gsicc_clut_t *)_cmsGetTransformUserData(CMMcargo);
+    gsicc_clut_layout_t lin, lout;
+    cmsUInt32Number y;
+    int kind;
+
+    gsicc_clut_layout(&lin, cmsGetTransformInputFormat(ContextID, (cmsHTRANSFORM)CMMcargo),
+                      Stride->BytesPerPlaneIn);
+    gsicc_clut_layout(&lout, cmsGetTransformOutputFormat(ContextID, (cmsHTRANSFORM)CMMcargo),
+                      Stride->BytesPerPlaneOut);
+    kind = (clut->num_in << 12) | (clut->num_out << 8) | (lin.bytes << 4) | lout.bytes;
+
+    for (y = 0; y < LineCount; y++) {
+        const byte *src = (const byte *)InputBuffer + y * Stride->BytesPerLineIn;
+        byte *des = (byte *)OutputBuffer + y * Stride->BytesPerLineOut;
+
+        /* Specialise the loop for the usual cases */
+        switch (kind) {
+            case 0x3311:
+                gsicc_clut_run(clut, &lin, &lout, src, des, PixelsPerLine, 3, 3, 1, 1);
+                break;
+            case 0x3411:
+                gsicc_clut_run(clut, &lin, &lout, src, des, PixelsPerLine, 3, 4, 1, 1);
+                break;
+            case 0x4311:
+                gsicc_clut_run(clut, &lin, &lout, src, des, PixelsPerLine, 4, 3, 1, 1);
+                break;
+            case 0x4411:
+                gsicc_clut_run(clut, &lin, &lout, src, des, PixelsPerLine, 4, 4, 1, 1);
+                break;
+            case 0x3322:
+                gsicc_clut_run(clut, &lin, &lout, src, des, PixelsPerLine, 3, 3, 2, 2);
+                break;
+            case 0x3422:
+                gsicc_clut_run(clut, &lin, &lout, src, des, PixelsPerLine, 3, 4, 2, 2);
+                break;
+            case 0x4322:
+                gsicc_clut_run(clut, &lin, &lout, src, des, PixelsPerLine, 4, 3, 2, 2);
+                break;
+            case 0x4422:
+                gsicc_clut_run(clut, &lin, &lout, src, des, PixelsPerLine, 4, 4, 2, 2);
+                break;
+            default:
+                gsicc_clut_run(clut, &lin, &lout, src, des, PixelsPerLine,
+                               clut->num_in, clut->num_out, lin.bytes, lout.bytes);
+                break;
+        }
+    }
+}
+
+static void
+gsicc_clut_free(cmsContext ContextID, void *data)
+{
+    gsicc_clut_t *clut = (gsicc_clut_t *)data;
+
+    _cmsFree(ContextID, clut->table);
+    _cmsFree(ContextID, clut);
+}
+
+static cmsBool
+gsicc_clut_factory(cmsContext ContextID, _cmsTransform2Fn *xform,
+                   void **UserData, _cmsFreeUserDataFn *FreePrivateDataFn,
+                   cmsPipeline **Lut, cmsUInt32Number *InputFormat,
+                   cmsUInt32Number *OutputFormat, cmsUInt32Number *dwFlags)
+{
+    gsicc_clut_t *clut = (gsicc_clut_t *)*UserData;
+    cmsStage *stage;
+    _cmsStageCLutData *data;
+    int i, k, n, num_nodes, w, f;
+
+    if (!gsicc_clut_format_ok(*InputFormat) || !gsicc_clut_format_ok(*OutputFormat))
+        return FALSE;
+    if (dwFlags == NULL) {
+        /* A transform being cloned, which is only ours if its CLUT is set up */
+        if (clut == NULL || *FreePrivateDataFn != gsicc_clut_free ||
+            T_CHANNELS(*InputFormat) != clut->num_in ||
+            T_CHANNELS(*OutputFormat) != clut->num_out)
+            return FALSE;
+    } else {
+        /* A new transform */
+        if (*dwFlags & (cmsFLAGS_NULLTRANSFORM | cmsFLAGS_GAMUTCHECK | cmsFLAGS_COPY_ALPHA))
+            return FALSE;
+        if (T_BYTES(*InputFormat) != 2 || T_BYTES(*OutputFormat) != 2)
+            return FALSE;
+        if (cmsPipelineStageCount(ContextID, *Lut) != 1)
+            return FALSE;
+        stage = cmsPipelineGetPtrToFirstStage(ContextID, *Lut);
+        if (cmsStageType(ContextID, stage) != cmsSigCLutElemType)
+            return FALSE;
+        data = (_cmsStageCLutData *)cmsStageData(ContextID, stage);
+        if (data == NULL || data->HasFloatValues || data->Tab.T == NULL ||
+            (data->Params->dwFlags & (CMS_LERP_FLAGS_FLOAT | CMS_LERP_FLAGS_TRILINEAR)) ||
+            (data->Params->nInputs != 3 && data->Params->nInputs != 4) ||
+            (data->Params->nOutputs != 3 && data->Params->nOutputs != 4) ||
+            T_CHANNELS(*InputFormat) != data->Params->nInputs ||
+            T_CHANNELS(*OutputFormat) != data->Params->nOutputs)
+            return FALSE;
+        clut = (gsicc_clut_t *)_cmsMalloc(ContextID, sizeof(gsicc_clut_t));
+        if (clut == NULL)
+            return FALSE;
+        clut->num_in = data->Params->nInputs;
+        clut->num_out = data->Params->nOutputs;
+        num_nodes = data->nEntries / clut->num_out;
+        clut->table = (cmsUInt16Number *)_cmsMalloc(ContextID,
+                                        num_nodes * 4 * sizeof(cmsUInt16Number));
+        if (clut->table == NULL) {
+            _cmsFree(ContextID, clut);
+            return FALSE;
+        }
+        for (n = 0; n < num_nodes; n++) {
+            for (k = 0; k < clut->num_out; k++)
+                clut->table[n * 4 + k] = data->Tab.T[n * clut->num_out + k];
+            for (; k < 4; k++)
+                clut->table[n * 4 + k] = 0;
+        }
+        /* lcms numbers the strides from the last input */
+        for (i = 0; i < clut->num_in; i++) {
+            clut->domain[i] = data->Params->Domain[i];
+            clut->step[i] = 4 * (data->Params->opta[clut->num_in - 1 - i] / clut->num_out);
+            for (k = 0; k < 256; k++) {
+                w = GSICC_CLUT_FROM_8_TO_16(k);
+                f = gsicc_clut_fixed(w * (int)clut->domain[i]);
+                clut->in8[i][k].base = clut->step[i] * (f >> 16);
+                clut->in8[i][k].frac = f & 0xffff;
+                clut->in8[i][k].step = (w == 0xffff ? 0 : clut->step[i]);
+            }
+        }
+        *UserData = clut;
+        *FreePrivateDataFn = gsicc_clut_free;
+        *dwFlags |= cmsFLAGS_CAN_CHANGE_FORMATTER;
+    }
+    *xform = gsicc_clut_xform;
+    return TRUE;
+}
+
+static cmsPluginTransform gs_cms_clut_transform =
+{
+    {
+        cmsPluginMagicNumber,
+        LCMS_VERSION,
+        cmsPluginTransformSig,
+        NULL
+    },
+    /* The union is initialised through its first member */
+    { (_cmsTransformFactory)gsicc_clut_factory }
+};
+
 static int
 gscms_get_accuracy(gs_memory_t *mem)
 {
@@ -685,6 +1166,102 @@ gscms_get_link(gcmmhprofile_t  lcms_srchandle, gcmmhprofile_t lcms_deshandle,
     /* cmsFLAGS_HIGHRESPRECALC)  cmsFLAGS_NOTPRECALC  cmsFLAGS_LOWRESPRECALC*/
 }
 
+/* Write a link out as a device link profile, so that it can be kept and
+   used again by gscms_get_link_from_devicelink.  The buffer is allocated
+   in memory and belongs to the caller */
+int
+gscms_get_devicelink_buffer(gcmmhlink_t link, unsigned char **buffer,
+                            unsigned int *size, gs_memory_t *memory)
+{
+    cmsContext ctx = gs_lib_ctx_get_cms_context(memory);
+    gsicc_lcms2mt_link_list_t *link_handle = (gsicc_lcms2mt_link_list_t *)(link);
+    cmsHPROFILE hProfile;
+    cmsUInt32Number num_bytes = 0;
+    unsigned char *buf;
+
+    *buffer = NULL;
+    *size = 0;
+    hProfile = cmsTransform2DeviceLink(ctx, link_handle->hTransform, 4.3, 0);
+    if (hProfile == NULL)
+        return_error(gs_error_unknownerror);
+    if (!cmsSaveProfileToMem(ctx, hProfile, NULL, &num_bytes) ||
+        num_bytes == 0) {
+        cmsCloseProfile(ctx, hProfile);
+        return_error(gs_error_unknownerror);
+    }
+    buf = gs_alloc_bytes(memory, num_bytes, "gscms_get_devicelink_buffer");
+    if (buf == NULL) {
+        cmsCloseProfile(ctx, hProfile);
+        return_error(gs_error_VMerror);
+    }
+    if (!cmsSaveProfileToMem(ctx, hProfile, buf, &num_bytes)) {
+        cmsCloseProfile(ctx, hProfile);
+        gs_free_object(memory, buf, "gscms_get_devicelink_buffer");
+        return_error(gs_error_unknownerror);
+    }
+    cmsCloseProfile(ctx, hProfile);
+    *buffer = buf;
+    *size = num_bytes;
+    return 0;
+}
+
+/* Get a link back from a device link profile written by
+   gscms_get_devicelink_buffer.  The rendering parameters and the flags
+   were applied when the device link was made, and the white point fix up
+   too if it was wanted, so none of them are used again here. */
+gcmmhlink_t
+gscms_get_link_from_devicelink(unsigned char *buffer, unsigned int size,
+                               gs_memory_t *memory)
+{
+    cmsContext ctx = gs_lib_ctx_get_cms_context(memory);
+    cmsHPROFILE hProfile;
+    cmsColorSpaceSignature src_color_space, des_color_space;
+    int lcms_src_color_space, lcms_des_color_space;
+    cmsUInt32Number src_data_type, des_data_type;
+    gsicc_lcms2mt_link_list_t *link_handle;
+
+    hProfile = cmsOpenProfileFromMem(ctx, buffer, size);
+    if (hProfile == NULL)
+        return NULL;
+    if (cmsGetDeviceClass(ctx, hProfile) != cmsSigLinkClass) {
+        cmsCloseProfile(ctx, hProfile);
+        return NULL;
+    }
+    src_color_space = cmsGetColorSpace(ctx, hProfile);
+    lcms_src_color_space = _cmsLCMScolorSpace(ctx, src_color_space);
+    if (lcms_src_color_space < 0)
+        lcms_src_color_space = 0;
+    src_data_type = (COLORSPACE_SH(lcms_src_color_space)|
+                        CHANNELS_SH(cmsChannelsOf(ctx, src_color_space))|BYTES_SH(2));
+    des_color_space = cmsGetPCS(ctx, hProfile);
+    lcms_des_color_space = _cmsLCMScolorSpace(ctx, des_color_space);
+    if (lcms_des_color_space < 0)
+        lcms_des_color_space = 0;
+    des_data_type = (COLORSPACE_SH(lcms_des_color_space)|
+                        CHANNELS_SH(cmsChannelsOf(ctx, des_color_space))|BYTES_SH(2));
+    link_handle = (gsicc_lcms2mt_link_list_t *)gs_alloc_bytes(memory->non_gc_memory,
+                                                         sizeof(gsicc_lcms2mt_link_list_t),
+                                                         "gscms_get_link_from_devicelink");
+    if (link_handle == NULL) {
+        cmsCloseProfile(ctx, hProfile);
+        return NULL;
+    }
+    link_handle->hTransform = cmsCreateTransform(ctx, hProfile, src_data_type,
+                                                 NULL, des_data_type,
+                                                 INTENT_PERCEPTUAL,
+                                                 gscms_get_accuracy(memory) |
+                                                 cmsFLAGS_NOWHITEONWHITEFIXUP);
+    cmsCloseProfile(ctx, hProfile);
+    if (link_handle->hTransform == NULL) {
+        gs_free_object(memory->non_gc_memory, link_handle, "gscms_get_link_from_devicelink");
+        return NULL;
+    }
+    link_handle->next = NULL;
+    link_handle->flags = gsicc_link_flags(0, 0, 0, 0, 0,    /* no alpha, not planar, little-endian */
+                                          sizeof(gx_color_value), sizeof(gx_color_value));
+    return link_handle;
+}
+
 /* Get the link from the CMS, but include proofing and/or a device link
    profile.  Note also, that the source may be a device link profile, in
    which case we will not have a destination profile but could still have
@@ -873,6 +1450,10 @@ gscms_create(gs_memory_t *memory)
     cmsPlugin(ctx, (void *)&gs_cms_mutexhandler);
 #endif
 
+    /* lcms tries the transform plugins last registered first, so the CAL
+       ones still come before this one */
+    cmsPlugin(ctx, (void *)&gs_cms_clut_transform);
+
 #ifdef WITH_CAL
     cmsPlugin(ctx, cal_cms_extensions());
     cmsPlugin(ctx, cal_cms_extensions2());
@@ -3022,6 +3022,42 @@ gs_seticcdirectory(const gs_gstate * pgs, gs_param_string * pval)
     return 0;
 }
 
+void
+gs_currenticclinkcachedirectory(const gs_gstate * pgs, gs_param_string * pval)
+{
+    const gs_lib_ctx_t *lib_ctx = pgs->memory->gs_lib_ctx;
+
+    if (lib_ctx->linkcachedir == NULL) {
+        pval->data = (const byte *)"";
+        pval->size = 0;
+        pval->persistent = true;
+    } else {
+        pval->data = (const byte *)(lib_ctx->linkcachedir);
+        pval->size = lib_ctx->linkcachedir_len;
+        pval->persistent = false;
+    }
+}
+
+int
+gs_seticclinkcachedirectory(const gs_gstate * pgs, gs_param_string * pval)
+{
+    char *pname;
+    int namelen = (pval->size)+1;
+    gs_memory_t *mem = (gs_memory_t *)pgs->memory;
+    int code;
+
+    pname = (char *)gs_alloc_bytes(mem, namelen,
+                                   "gs_seticclinkcachedirectory");
+    if (pname == NULL)
+        return gs_rethrow(gs_error_VMerror, "cannot allocate directory name");
+    memcpy(pname,pval->data,namelen-1);
+    pname[namelen-1] = 0;
+    code = gs_lib_ctx_set_icc_link_cache_directory(mem, (const char*) pname,
+                                                   namelen-1);
+    gs_free_object(mem, pname, "gs_seticclinkcachedirectory");
+    return code;
+}
+
 void
 gs_currentsrcgtagicc(const gs_gstate * pgs, gs_param_string * pval)
 {
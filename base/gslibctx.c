@@ -94,6 +94,39 @@ gs_lib_ctx_set_icc_directory(const gs_memory_t *mem_gc, const char* pname,
     return 0;
 }
 
+/*  This sets the directory in which ICC links are kept between runs */
+int
+gs_lib_ctx_set_icc_link_cache_directory(const gs_memory_t *mem_gc,
+                                        const char* pname, int dir_namelen)
+{
+    char *result = NULL;
+    gs_lib_ctx_t *p_ctx = mem_gc->gs_lib_ctx;
+    gs_memory_t *p_ctx_mem = p_ctx->memory;
+
+    if (p_ctx->linkcachedir != NULL &&
+        strncmp(pname, p_ctx->linkcachedir, p_ctx->linkcachedir_len) == 0 &&
+        pname[p_ctx->linkcachedir_len] == 0)
+        return 0;
+    /* A relative path would be taken from the temporary directory by
+       gp_open_scratch_file, but from the current one by everything else
+       (see gsicc_link_store_write). */
+    if (pname[0] != 0 && !gp_file_name_is_absolute(pname, dir_namelen))
+        return_error(gs_error_rangecheck);
+    if (pname[0] != 0) {
+        /* User param string.  Must allocate in non-gc memory */
+        result = (char*) gs_alloc_bytes(p_ctx_mem, dir_namelen+1,
+                                        "gs_lib_ctx_set_icc_link_cache_directory");
+        if (result == NULL)
+            return gs_error_VMerror;
+        strcpy(result, pname);
+    }
+    gs_free_object(p_ctx_mem, p_ctx->linkcachedir,
+                   "gs_lib_ctx_set_icc_link_cache_directory");
+    p_ctx->linkcachedir = result;
+    p_ctx->linkcachedir_len = result == NULL ? 0 : strlen(result);
+    return 0;
+}
+
 /* Sets/Gets the string containing the list of default devices we should try */
 int
 gs_lib_ctx_set_default_device_list(const gs_memory_t *mem, const char* dev_list_str,
@@ -334,6 +367,8 @@ int gs_lib_ctx_init(gs_lib_ctx_t *ctx, gs_memory_t *mem)
     /* Initialize our default ICCProfilesDir */
     pio->profiledir = NULL;
     pio->profiledir_len = 0;
+    pio->linkcachedir = NULL;
+    pio->linkcachedir_len = 0;
     pio->icc_color_accuracy = MAX_COLOR_ACCURACY;
     if (gs_lib_ctx_set_icc_directory(mem, DEFAULT_DIR_ICC, strlen(DEFAULT_DIR_ICC)) < 0)
       goto Failure;
@@ -399,6 +434,8 @@ void gs_lib_ctx_fin(gs_memory_t *mem)
     gscms_destroy(ctx_mem);
     gs_free_object(ctx_mem, ctx->profiledir,
         "gs_lib_ctx_fin");
+    gs_free_object(ctx_mem, ctx->linkcachedir,
+        "gs_lib_ctx_fin");
 
     gs_free_object(ctx_mem, ctx->default_device_list,
                 "gs_lib_ctx_fin");
@@ -159,6 +159,10 @@ typedef struct gs_lib_ctx_s
      * and one in the device */
     char *profiledir;               /* Directory used in searching for ICC profiles */
     int profiledir_len;             /* length of directory name (allows for Unicode) */
+    /* Directory in which ICC links are kept from one run to the next, as
+     * device link profiles (see gsicc_cache.c).  NULL if not in use. */
+    char *linkcachedir;
+    int linkcachedir_len;           /* length of directory name */
     void *cms_context;  /* Opaque context pointer from underlying CMS in use */
     gs_fapi_server **fapi_servers;
     char *default_device_list;
@@ -201,6 +205,9 @@ gs_memory_t * gs_lib_ctx_get_non_gc_memory_t(void);
 
 int gs_lib_ctx_set_icc_directory(const gs_memory_t *mem_gc, const char* pname,
                                  int dir_namelen);
+/* An empty name turns the ICC link cache directory off. */
+int gs_lib_ctx_set_icc_link_cache_directory(const gs_memory_t *mem_gc,
+                                            const char* pname, int dir_namelen);
 
 
 /* Sets/Gets the string containing the list of device names we should search
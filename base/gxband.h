@@ -41,6 +41,12 @@ typedef struct gx_colors_usage_s {
                                 /* executed plane-by-plane on CMYK devices */
     gs_int_rect trans_bbox;	/* transparency bbox allows skipping the pdf14 compositor for some bands */
                                 /* coordinates are band relative, 0 <= p.y < page_band_height */
+    /* Statistics for estimating the cost of rendering the band, so that */
+    /* multiple rendering threads can start the expensive bands first.   */
+    ulong cmd_bytes;		/* bytes of commands for this band alone */
+    ulong image_area;		/* source image pixels sent to the band */
+    uint trans_groups;		/* transparency groups and soft masks */
+    uint path_segments;		/* path segments written for the band */
 } gx_color_usage_t;
 
 /*
@@ -29,6 +29,9 @@
 #ifdef WITH_CAL
 #include "cal.h"
 #endif
+#ifdef HAVE_SSE2
+#include <emmintrin.h>
+#endif
 
 typedef int art_s32;
 
@@ -3362,6 +3365,280 @@ compose_group_nonknockout_noblend_general(byte *tos_ptr, bool tos_isolated, int
         backdrop_ptr, has_matte, n_chan, additive, num_spots, overprint, drawn_comps, x0, y0, x1, y1, pblend_procs, pdev, 1);
 }
 
+#ifdef HAVE_SSE2
+/*
+ * SSE2 versions of the commonest compose cases: Normal blend mode with no
+ * soft mask, shape, tags, spots, alpha_g or backdrop. They do 4 pixels at
+ * a time in 32 bit lanes and give exactly the same results as the scalar
+ * code, whose integer arithmetic they follow step by step (the divisions
+ * are done in double precision, which is exact for the ranges involved).
+ * Any columns left over at the right are done by the scalar code.
+ */
+
+/* The low 32 bits of the products of 4 pairs of 32 bit values. */
+static inline __m128i
+sse2_mullo_epi32(__m128i a, __m128i b)
+{
+    __m128i even = _mm_mul_epu32(a, b);
+    __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+
+    return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                              _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+/* n / d, rounded down, for unsigned 32 bit n and 0 < d <= 0xffff. */
+static inline __m128i
+sse2_div_epu32(__m128i n, __m128i d)
+{
+    const __m128i bias = _mm_set1_epi32((int)0x80000000);
+    const __m128d dbias = _mm_set1_pd(2147483648.0);
+    __m128i ns = _mm_xor_si128(n, bias);
+    __m128d nlo = _mm_add_pd(_mm_cvtepi32_pd(ns), dbias);
+    __m128d nhi = _mm_add_pd(_mm_cvtepi32_pd(_mm_shuffle_epi32(ns, _MM_SHUFFLE(1, 0, 3, 2))), dbias);
+    __m128d dlo = _mm_cvtepi32_pd(d);
+    __m128d dhi = _mm_cvtepi32_pd(_mm_shuffle_epi32(d, _MM_SHUFFLE(1, 0, 3, 2)));
+
+    return _mm_unpacklo_epi64(_mm_cvttpd_epi32(_mm_div_pd(nlo, dlo)),
+                              _mm_cvttpd_epi32(_mm_div_pd(nhi, dhi)));
+}
+
+/* Replace 0 by 1, to keep divisors whose result isn't used nonzero. */
+static inline __m128i
+sse2_nonzero_epi32(__m128i d)
+{
+    return _mm_or_si128(d, _mm_and_si128(_mm_cmpeq_epi32(d, _mm_setzero_si128()),
+                                         _mm_set1_epi32(1)));
+}
+
+/* mask ? a : b */
+static inline __m128i
+sse2_select(__m128i mask, __m128i a, __m128i b)
+{
+    return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+static inline bool
+sse2_all_zero_epi32(__m128i v)
+{
+    return _mm_movemask_epi8(_mm_cmpeq_epi32(v, _mm_setzero_si128())) == 0xffff;
+}
+
+static inline __m128i
+sse2_load4_u8(const byte *p)
+{
+    int v;
+
+    memcpy(&v, p, 4);
+    return _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(v), _mm_setzero_si128()),
+                              _mm_setzero_si128());
+}
+
+/* Clamp to 0..255, packing into the low 4 bytes. */
+static inline __m128i
+sse2_pack_u8(__m128i v)
+{
+    v = _mm_packs_epi32(v, v);
+    return _mm_packus_epi16(v, v);
+}
+
+static inline void
+sse2_store4_u8(byte *p, __m128i v)
+{
+    int r = _mm_cvtsi128_si32(sse2_pack_u8(v));
+
+    memcpy(p, &r, 4);
+}
+
+static inline __m128i
+sse2_clamp_u8(__m128i v)
+{
+    return _mm_unpacklo_epi16(_mm_unpacklo_epi8(sse2_pack_u8(v), _mm_setzero_si128()),
+                              _mm_setzero_si128());
+}
+
+static inline __m128i
+sse2_load4_u16(const uint16_t *p)
+{
+    return _mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i *)p), _mm_setzero_si128());
+}
+
+/* v must be in 0..0xffff. */
+static inline void
+sse2_store4_u16(uint16_t *p, __m128i v)
+{
+    v = _mm_sub_epi32(v, _mm_set1_epi32(0x8000));
+    v = _mm_add_epi16(_mm_packs_epi32(v, v), _mm_set1_epi16((short)0x8000));
+    _mm_storel_epi64((__m128i *)p, v);
+}
+
+/* (a * b) / 255, rounded as art_pdf does, for a, b in 0..255. */
+static inline __m128i
+sse2_mul8(__m128i a, __m128i b)
+{
+    __m128i tmp = _mm_add_epi32(_mm_mullo_epi16(a, b), _mm_set1_epi32(0x80));
+
+    return _mm_srli_epi32(_mm_add_epi32(tmp, _mm_srli_epi32(tmp, 8)), 8);
+}
+
+/*
+ * Composite the source colour (c_s) over the backdrop (c_b) where comp is
+ * set, with the scale computed by sse2_composite_scale, copy the source
+ * where copy is set, and leave the backdrop elsewhere.
+ */
+static inline __m128i
+sse2_composite8(__m128i c_s, __m128i c_b, __m128i scale, __m128i comp, __m128i copy)
+{
+    __m128i tmp = _mm_add_epi32(_mm_slli_epi32(c_b, 16),
+                                sse2_mullo_epi32(scale, _mm_sub_epi32(c_s, c_b)));
+
+    tmp = _mm_srai_epi32(_mm_add_epi32(tmp, _mm_set1_epi32(0x8000)), 16);
+    return sse2_select(comp, tmp, sse2_select(copy, c_s, c_b));
+}
+
+/*
+ * Work out how art_pdf_composite_pixel_alpha_8 treats source alpha a_s over
+ * backdrop alpha a_b: the result alpha, the source scale, and which pixels
+ * are composited (comp) and which are simply copied (copy).
+ */
+static inline __m128i
+sse2_composite_alpha8(__m128i a_s, __m128i a_b, __m128i *scale, __m128i *comp, __m128i *copy)
+{
+    const __m128i c255 = _mm_set1_epi32(255);
+    __m128i s_zero = _mm_cmpeq_epi32(a_s, _mm_setzero_si128());
+    __m128i b_zero = _mm_cmpeq_epi32(a_b, _mm_setzero_si128());
+    /* Result alpha is Union of backdrop and source alpha */
+    __m128i a_r = _mm_sub_epi32(c255, sse2_mul8(_mm_sub_epi32(c255, a_b),
+                                                _mm_sub_epi32(c255, a_s)));
+
+    *copy = _mm_andnot_si128(s_zero, b_zero);
+    *comp = _mm_xor_si128(_mm_or_si128(s_zero, b_zero), _mm_cmpeq_epi32(a_s, a_s));
+    /* Compute a_s / a_r in 16.16 format */
+    *scale = sse2_div_epu32(_mm_add_epi32(_mm_slli_epi32(a_s, 16), _mm_srli_epi32(a_r, 1)),
+                            sse2_nonzero_epi32(a_r));
+    return sse2_select(*comp, a_r, sse2_select(*copy, a_s, a_b));
+}
+
+static void
+compose_group_nonknockout_nonblend_isolated_nomask_sse2(byte *tos_ptr, bool tos_isolated, int tos_planestride, int tos_rowstride, byte alpha, byte shape, gs_blend_mode_t blend_mode, bool tos_has_shape,
+              int tos_shape_offset, int tos_alpha_g_offset, int tos_tag_offset, bool tos_has_tag, byte *tos_alpha_g_ptr,
+              byte *nos_ptr, bool nos_isolated, int nos_planestride, int nos_rowstride, byte *nos_alpha_g_ptr, bool nos_knockout,
+              int nos_shape_offset, int nos_tag_offset,
+              byte *mask_row_ptr, int has_mask, pdf14_buf *maskbuf, byte mask_bg_alpha, const byte *mask_tr_fn,
+              byte *backdrop_ptr,
+              bool has_matte, int n_chan, bool additive, int num_spots, bool overprint, gx_color_index drawn_comps, int x0, int y0, int x1, int y1,
+              const pdf14_nonseparable_blending_procs_t *pblend_procs, pdf14_device *pdev)
+{
+    int width = (x1 - x0) & ~3;
+    const __m128i valpha = _mm_set1_epi32(alpha);
+    byte *tos_row = tos_ptr;
+    byte *nos_row = nos_ptr;
+    int x, y, i;
+
+    for (y = y1 - y0; y > 0; --y) {
+        for (x = 0; x < width; x += 4) {
+            byte *tp = tos_row + x;
+            byte *np = nos_row + x;
+            __m128i a_s = sse2_load4_u8(tp + n_chan * tos_planestride);
+            __m128i a_b, a_r, scale, comp, copy;
+
+            if (sse2_all_zero_epi32(a_s))
+                continue;
+            if (alpha != 255)
+                a_s = sse2_mul8(a_s, valpha);
+            a_b = sse2_load4_u8(np + n_chan * nos_planestride);
+            a_r = sse2_composite_alpha8(a_s, a_b, &scale, &comp, &copy);
+            for (i = 0; i < n_chan; i++)
+                sse2_store4_u8(np + i * nos_planestride,
+                               sse2_composite8(sse2_load4_u8(tp + i * tos_planestride),
+                                               sse2_load4_u8(np + i * nos_planestride),
+                                               scale, comp, copy));
+            sse2_store4_u8(np + n_chan * nos_planestride, a_r);
+        }
+        tos_row += tos_rowstride;
+        nos_row += nos_rowstride;
+    }
+    if (x0 + width < x1)
+        compose_group_nonknockout_nonblend_isolated_nomask_common(tos_ptr + width, tos_isolated, tos_planestride, tos_rowstride, alpha, shape, blend_mode, tos_has_shape,
+            tos_shape_offset, tos_alpha_g_offset, tos_tag_offset, tos_has_tag, tos_alpha_g_ptr,
+            nos_ptr + width, nos_isolated, nos_planestride, nos_rowstride, nos_alpha_g_ptr, nos_knockout,
+            nos_shape_offset, nos_tag_offset, mask_row_ptr, has_mask, maskbuf, mask_bg_alpha, mask_tr_fn,
+            backdrop_ptr, has_matte, n_chan, additive, num_spots, overprint, drawn_comps, x0 + width, y0, x1, y1, pblend_procs, pdev);
+}
+
+static void
+compose_group_nonknockout_nonblend_nonisolated_nomask_sse2(byte *tos_ptr, bool tos_isolated, int tos_planestride, int tos_rowstride, byte alpha, byte shape, gs_blend_mode_t blend_mode, bool tos_has_shape,
+              int tos_shape_offset, int tos_alpha_g_offset, int tos_tag_offset, bool tos_has_tag, byte *tos_alpha_g_ptr,
+              byte *nos_ptr, bool nos_isolated, int nos_planestride, int nos_rowstride, byte *nos_alpha_g_ptr, bool nos_knockout,
+              int nos_shape_offset, int nos_tag_offset,
+              byte *mask_row_ptr, int has_mask, pdf14_buf *maskbuf, byte mask_bg_alpha, const byte *mask_tr_fn,
+              byte *backdrop_ptr,
+              bool has_matte, int n_chan, bool additive, int num_spots, bool overprint, gx_color_index drawn_comps, int x0, int y0, int x1, int y1,
+              const pdf14_nonseparable_blending_procs_t *pblend_procs, pdf14_device *pdev)
+{
+    int width = (x1 - x0) & ~3;
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i c255 = _mm_set1_epi32(255);
+    const __m128i c80 = _mm_set1_epi32(0x80);
+    const __m128i valpha = _mm_set1_epi32(alpha);
+    byte *tos_row = tos_ptr;
+    byte *nos_row = nos_ptr;
+    int x, y, i;
+
+    for (y = y1 - y0; y > 0; --y) {
+        for (x = 0; x < width; x += 4) {
+            byte *tp = tos_row + x;
+            byte *np = nos_row + x;
+            /* The alpha_g of the group is its alpha (it has no shape). */
+            __m128i a_g = sse2_load4_u8(tp + n_chan * tos_planestride);
+            __m128i active = _mm_xor_si128(_mm_cmpeq_epi32(a_g, zero), _mm_cmpeq_epi32(zero, zero));
+            __m128i a_b, a_s, a_r, uncomp, uscale, scale, comp, copy;
+
+            if (sse2_all_zero_epi32(a_g))
+                continue;
+            if (alpha == 255) {
+                /* Uncompositing and recompositing cancel each other out. */
+                for (i = 0; i <= n_chan; i++)
+                    sse2_store4_u8(np + i * nos_planestride,
+                                   sse2_select(active, sse2_load4_u8(tp + i * tos_planestride),
+                                               sse2_load4_u8(np + i * nos_planestride)));
+                continue;
+            }
+            a_b = sse2_load4_u8(np + n_chan * nos_planestride);
+            /* Uncomposite the colour where 0 < a_g < 255 and a_b != 0 */
+            uncomp = _mm_andnot_si128(_mm_or_si128(_mm_cmpeq_epi32(a_g, c255),
+                                                   _mm_cmpeq_epi32(a_b, zero)), active);
+            uscale = _mm_sub_epi32(sse2_div_epu32(_mm_add_epi32(_mm_sub_epi32(_mm_slli_epi32(a_b, 9),
+                                                                              _mm_slli_epi32(a_b, 1)), a_g),
+                                                  sse2_nonzero_epi32(_mm_slli_epi32(a_g, 1))),
+                                   a_b);
+            a_s = sse2_mul8(a_g, valpha);
+            a_r = sse2_composite_alpha8(a_s, a_b, &scale, &comp, &copy);
+            comp = _mm_and_si128(comp, active);
+            copy = _mm_and_si128(copy, active);
+            for (i = 0; i < n_chan; i++) {
+                __m128i c_s = sse2_load4_u8(tp + i * tos_planestride);
+                __m128i c_b = sse2_load4_u8(np + i * nos_planestride);
+                __m128i tmp = _mm_add_epi32(sse2_mullo_epi32(_mm_sub_epi32(c_s, c_b), uscale), c80);
+
+                tmp = _mm_add_epi32(c_s, _mm_srai_epi32(_mm_add_epi32(tmp, _mm_srai_epi32(tmp, 8)), 8));
+                c_s = sse2_select(uncomp, sse2_clamp_u8(tmp), c_s);
+                sse2_store4_u8(np + i * nos_planestride,
+                               sse2_composite8(c_s, c_b, scale, comp, copy));
+            }
+            sse2_store4_u8(np + n_chan * nos_planestride, sse2_select(active, a_r, a_b));
+        }
+        tos_row += tos_rowstride;
+        nos_row += nos_rowstride;
+    }
+    if (x0 + width < x1)
+        compose_group_nonknockout_nonblend_nonisolated_nomask_common(tos_ptr + width, tos_isolated, tos_planestride, tos_rowstride, alpha, shape, blend_mode, tos_has_shape,
+            tos_shape_offset, tos_alpha_g_offset, tos_tag_offset, tos_has_tag, tos_alpha_g_ptr,
+            nos_ptr + width, nos_isolated, nos_planestride, nos_rowstride, nos_alpha_g_ptr, nos_knockout,
+            nos_shape_offset, nos_tag_offset, mask_row_ptr, has_mask, maskbuf, mask_bg_alpha, mask_tr_fn,
+            backdrop_ptr, has_matte, n_chan, additive, num_spots, overprint, drawn_comps, x0 + width, y0, x1, y1, pblend_procs, pdev);
+}
+#endif /* HAVE_SSE2 */
+
 static void
 compose_group_alphaless_knockout(byte *tos_ptr, bool tos_isolated, int tos_planestride, int tos_rowstride, byte alpha, byte shape, gs_blend_mode_t blend_mode, bool tos_has_shape,
               int tos_shape_offset, int tos_alpha_g_offset, int tos_tag_offset, bool tos_has_tag, byte *tos_alpha_g_ptr,
@@ -3443,6 +3720,7 @@ do_compose_group(pdf14_buf *tos, pdf14_buf *nos, pdf14_buf *maskbuf,
     if ((tos->n_chan == 0) || (nos->n_chan == 0))
         return;
     rect_merge(nos->dirty, tos->dirty);
+    pdf14_buf_mark_dirty(nos, x0, y0, x1 - x0, y1 - y0);
     if (nos->has_tags)
         if_debug7m('v', memory,
                    "pdf14_pop_transparency_group y0 = %d, y1 = %d, w = %d, alpha = %d, shape = %d, tag = %d, bm = %d\n",
@@ -3470,6 +3748,17 @@ do_compose_group(pdf14_buf *tos, pdf14_buf *nos, pdf14_buf *maskbuf,
     if (blend_mode != BLEND_MODE_Compatible && blend_mode != BLEND_MODE_Normal)
         overprint = false;
 
+    /* A constant soft mask (see pdf14_pop_transparency_mask) that is opaque
+       over the whole area being composed changes nothing, so compose as
+       though there was no mask at all. Knockout groups still need to know
+       about it, as it changes how they treat unpainted pixels. */
+    if (maskbuf != NULL && maskbuf->data != NULL && maskbuf->rowstride == 0 &&
+        !nos_knockout && !has_matte &&
+        maskbuf->transfer_fn[maskbuf->data[0]] == 255 &&
+        maskbuf->rect.p.x <= x0 && maskbuf->rect.p.y <= y0 &&
+        maskbuf->rect.q.x >= x1 && maskbuf->rect.q.y >= y1)
+        maskbuf = NULL;
+
     if (maskbuf != NULL) {
         int tmp;
 
@@ -3554,8 +3843,9 @@ do_compose_group(pdf14_buf *tos, pdf14_buf *nos, pdf14_buf *maskbuf,
                 if (maskbuf && maskbuf->rect.p.x <= x0 && maskbuf->rect.p.y <= y0 &&
                     maskbuf->rect.q.x >= x1 && maskbuf->rect.q.y >= y1) {
                     /* AVX and SSE accelerations only valid if maskbuf transfer
-                       function is identity and we have no matte color replacement */
-                    if (is_ident && !has_matte) {
+                       function is identity and we have no matte color replacement,
+                       and they expect a mask with a row for each row */
+                    if (is_ident && !has_matte && maskbuf->rowstride != 0) {
                         fn = compose_group_nonknockout_nonblend_isolated_allmask_common;
 #ifdef WITH_CAL
 			fn = (art_pdf_compose_group_fn)cal_get_compose_group(
@@ -3573,12 +3863,20 @@ do_compose_group(pdf14_buf *tos, pdf14_buf *nos, pdf14_buf *maskbuf,
                     /* Outside mask */
                     fn = &compose_group_nonknockout_nonblend_isolated_mask_common;
                 } else
+#ifdef HAVE_SSE2
+                    fn = &compose_group_nonknockout_nonblend_isolated_nomask_sse2;
+#else
                     fn = &compose_group_nonknockout_nonblend_isolated_nomask_common;
+#endif
         } else {
             if (has_mask || maskbuf) /* 4% */
                 fn = &compose_group_nonknockout_nonblend_nonisolated_mask_common;
             else /* 15% */
+#ifdef HAVE_SSE2
+                fn = &compose_group_nonknockout_nonblend_nonisolated_nomask_sse2;
+#else
                 fn = &compose_group_nonknockout_nonblend_nonisolated_nomask_common;
+#endif
         }
     } else
         fn = compose_group_nonknockout_noblend_general;
@@ -3917,24 +4215,30 @@ compose_group16_nonknockout_nonblend_isolated_allmask_common(uint16_t *tos_ptr,
     int width = x1 - x0;
     int x, y;
     int i;
+    /* Soft masks are mostly runs of equal values, so keep the pixel alpha
+       for the last mask value rather than interpolating every pixel. */
+    int last_mask = -1;
+    unsigned int pix_alpha = 0;
 
     for (y = y1 - y0; y > 0; --y) {
         uint16_t *gs_restrict mask_curr_ptr = mask_row_ptr;
         for (x = 0; x < width; x++) {
-            unsigned int mask = interp16(mask_tr_fn, *mask_curr_ptr++);
+            uint16_t mask_in = *mask_curr_ptr++;
             uint16_t src_alpha = tos_ptr[n_chan * tos_planestride];
             if (src_alpha != 0) {
                 uint16_t a_b;
-                unsigned int pix_alpha;
 
-                mask += mask>>15;
-                pix_alpha = (alpha * mask + 0x8000)>>16;
+                if (mask_in != last_mask) {
+                    unsigned int mask = interp16(mask_tr_fn, mask_in);
 
-                if (pix_alpha != 0xffff) {
-                    pix_alpha += pix_alpha>>15;
-                    src_alpha = (src_alpha * pix_alpha + 0x8000)>>16;
+                    last_mask = mask_in;
+                    mask += mask>>15;
+                    pix_alpha = (alpha * mask + 0x8000)>>16;
                 }
 
+                if (pix_alpha != 0xffff)
+                    src_alpha = (src_alpha * (pix_alpha + (pix_alpha>>15)) + 0x8000)>>16;
+
                 a_b = nos_ptr[n_chan * nos_planestride];
                 if (a_b == 0) {
                     /* Simple copy of colors plus alpha. */
@@ -3991,6 +4295,9 @@ compose_group16_nonknockout_nonblend_isolated_mask_common(uint16_t *tos_ptr, boo
     bool in_mask_rect_y;
     bool in_mask_rect;
     uint16_t pix_alpha, src_alpha;
+    /* The interpolated mask for the last mask value, as above. */
+    int last_mask = -1;
+    unsigned int mask = 0;
 
     for (y = y1 - y0; y > 0; --y) {
         mask_curr_ptr = mask_row_ptr;
@@ -4011,8 +4318,12 @@ compose_group16_nonknockout_nonblend_isolated_mask_common(uint16_t *tos_ptr, boo
 
             if (mask_curr_ptr != NULL) {
                 if (in_mask_rect) {
-                    unsigned int mask = interp16(mask_tr_fn, *mask_curr_ptr++);
-                    mask += mask>>15;
+                    if (*mask_curr_ptr != last_mask) {
+                        last_mask = *mask_curr_ptr;
+                        mask = interp16(mask_tr_fn, last_mask);
+                        mask += mask>>15;
+                    }
+                    mask_curr_ptr++;
                     pix_alpha = (pix_alpha * mask + 0x8000)>>16;
                 } else {
                     mask_curr_ptr++;
@@ -4135,6 +4446,306 @@ compose_group16_nonknockout_noblend_general(uint16_t *tos_ptr, bool tos_isolated
         backdrop_ptr, has_matte, n_chan, additive, num_spots, overprint, drawn_comps, x0, y0, x1, y1, pblend_procs, pdev, 1, 0);
 }
 
+#ifdef HAVE_SSE2
+/* SSE2 versions of the 16 bit compose cases; see the 8 bit ones above. */
+static void
+compose_group16_nonknockout_nonblend_isolated_nomask_sse2(uint16_t *tos_ptr, bool tos_isolated, int tos_planestride, int tos_rowstride,
+              uint16_t alpha, uint16_t shape, gs_blend_mode_t blend_mode, bool tos_has_shape, int tos_shape_offset, int tos_alpha_g_offset,
+              int tos_tag_offset, bool tos_has_tag, uint16_t *tos_alpha_g_ptr, uint16_t *nos_ptr, bool nos_isolated, int nos_planestride,
+              int nos_rowstride, uint16_t *nos_alpha_g_ptr, bool nos_knockout, int nos_shape_offset, int nos_tag_offset,
+              uint16_t *mask_row_ptr, int has_mask, pdf14_buf *maskbuf, uint16_t mask_bg_alpha, const uint16_t *mask_tr_fn, uint16_t *backdrop_ptr,
+              bool has_matte, int n_chan, bool additive, int num_spots, bool overprint, gx_color_index drawn_comps, int x0, int y0, int x1, int y1,
+              const pdf14_nonseparable_blending_procs_t *pblend_procs, pdf14_device *pdev)
+{
+    int width = (x1 - x0) & ~3;
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i cffff = _mm_set1_epi32(0xffff);
+    const __m128i valpha = _mm_set1_epi32(alpha + (alpha >> 15));
+    uint16_t *tos_row = tos_ptr;
+    uint16_t *nos_row = nos_ptr;
+    int x, y, i;
+
+    for (y = y1 - y0; y > 0; --y) {
+        for (x = 0; x < width; x += 4) {
+            uint16_t *tp = tos_row + x;
+            uint16_t *np = nos_row + x;
+            __m128i a_s = sse2_load4_u16(tp + n_chan * tos_planestride);
+            __m128i a_b, a_r, tmp, scale, s_zero, b_zero, comp, copy;
+
+            if (sse2_all_zero_epi32(a_s))
+                continue;
+            if (alpha != 65535)
+                a_s = _mm_srli_epi32(_mm_add_epi32(sse2_mullo_epi32(a_s, valpha),
+                                                   _mm_set1_epi32(0x8000)), 16);
+            a_b = sse2_load4_u16(np + n_chan * nos_planestride);
+            s_zero = _mm_cmpeq_epi32(a_s, zero);
+            b_zero = _mm_cmpeq_epi32(a_b, zero);
+            copy = _mm_andnot_si128(s_zero, b_zero);
+            comp = _mm_xor_si128(_mm_or_si128(s_zero, b_zero), _mm_cmpeq_epi32(zero, zero));
+            /* Result alpha is Union of backdrop and source alpha */
+            tmp = _mm_sub_epi32(_mm_set1_epi32(0x10000), _mm_add_epi32(a_b, _mm_srli_epi32(a_b, 15)));
+            tmp = _mm_add_epi32(sse2_mullo_epi32(tmp, _mm_sub_epi32(cffff, a_s)), _mm_set1_epi32(0x8000));
+            a_r = _mm_sub_epi32(cffff, _mm_srli_epi32(tmp, 16));
+            /* Compute a_s / a_r in 16.15 format */
+            scale = sse2_div_epu32(_mm_add_epi32(_mm_slli_epi32(a_s, 16), _mm_srli_epi32(a_r, 1)),
+                                   sse2_nonzero_epi32(a_r));
+            scale = _mm_srli_epi32(scale, 1);
+            for (i = 0; i < n_chan; i++) {
+                __m128i c_s = sse2_load4_u16(tp + i * tos_planestride);
+                __m128i c_b = sse2_load4_u16(np + i * nos_planestride);
+
+                tmp = _mm_add_epi32(sse2_mullo_epi32(scale, _mm_sub_epi32(c_s, c_b)), _mm_set1_epi32(0x4000));
+                tmp = _mm_add_epi32(c_b, _mm_srai_epi32(tmp, 15));
+                sse2_store4_u16(np + i * nos_planestride,
+                                sse2_select(comp, tmp, sse2_select(copy, c_s, c_b)));
+            }
+            sse2_store4_u16(np + n_chan * nos_planestride,
+                            sse2_select(comp, a_r, sse2_select(copy, a_s, a_b)));
+        }
+        tos_row += tos_rowstride;
+        nos_row += nos_rowstride;
+    }
+    if (x0 + width < x1)
+        compose_group16_nonknockout_nonblend_isolated_nomask_common(tos_ptr + width, tos_isolated, tos_planestride, tos_rowstride,
+            alpha, shape, blend_mode, tos_has_shape, tos_shape_offset, tos_alpha_g_offset,
+            tos_tag_offset, tos_has_tag, tos_alpha_g_ptr, nos_ptr + width, nos_isolated, nos_planestride,
+            nos_rowstride, nos_alpha_g_ptr, nos_knockout, nos_shape_offset, nos_tag_offset,
+            mask_row_ptr, has_mask, maskbuf, mask_bg_alpha, mask_tr_fn, backdrop_ptr,
+            has_matte, n_chan, additive, num_spots, overprint, drawn_comps, x0 + width, y0, x1, y1, pblend_procs, pdev);
+}
+
+/*
+ * Only the case of a group alpha of 65535, where the group is simply copied
+ * where it has been painted, is done with SSE2: otherwise uncompositing
+ * needs 64 bit arithmetic, and the scalar code is used.
+ */
+static void
+compose_group16_nonknockout_nonblend_nonisolated_nomask_sse2(uint16_t *tos_ptr, bool tos_isolated, int tos_planestride, int tos_rowstride,
+              uint16_t alpha, uint16_t shape, gs_blend_mode_t blend_mode, bool tos_has_shape, int tos_shape_offset, int tos_alpha_g_offset,
+              int tos_tag_offset, bool tos_has_tag, uint16_t *tos_alpha_g_ptr, uint16_t *nos_ptr, bool nos_isolated, int nos_planestride,
+              int nos_rowstride, uint16_t *nos_alpha_g_ptr, bool nos_knockout, int nos_shape_offset, int nos_tag_offset,
+              uint16_t *mask_row_ptr, int has_mask, pdf14_buf *maskbuf, uint16_t mask_bg_alpha, const uint16_t *mask_tr_fn, uint16_t *backdrop_ptr,
+              bool has_matte, int n_chan, bool additive, int num_spots, bool overprint, gx_color_index drawn_comps, int x0, int y0, int x1, int y1,
+              const pdf14_nonseparable_blending_procs_t *pblend_procs, pdf14_device *pdev)
+{
+    int width = 0;
+    uint16_t *tos_row = tos_ptr;
+    uint16_t *nos_row = nos_ptr;
+    int x, y, i;
+
+    if (alpha == 65535) {
+        width = (x1 - x0) & ~3;
+        for (y = y1 - y0; y > 0; --y) {
+            for (x = 0; x < width; x += 4) {
+                uint16_t *tp = tos_row + x;
+                uint16_t *np = nos_row + x;
+                __m128i a_g = sse2_load4_u16(tp + n_chan * tos_planestride);
+                __m128i active;
+
+                if (sse2_all_zero_epi32(a_g))
+                    continue;
+                active = _mm_xor_si128(_mm_cmpeq_epi32(a_g, _mm_setzero_si128()),
+                                       _mm_cmpeq_epi32(a_g, a_g));
+                for (i = 0; i <= n_chan; i++)
+                    sse2_store4_u16(np + i * nos_planestride,
+                                    sse2_select(active, sse2_load4_u16(tp + i * tos_planestride),
+                                                sse2_load4_u16(np + i * nos_planestride)));
+            }
+            tos_row += tos_rowstride;
+            nos_row += nos_rowstride;
+        }
+    }
+    if (x0 + width < x1)
+        compose_group16_nonknockout_nonblend_nonisolated_nomask_common(tos_ptr + width, tos_isolated, tos_planestride, tos_rowstride,
+            alpha, shape, blend_mode, tos_has_shape, tos_shape_offset, tos_alpha_g_offset,
+            tos_tag_offset, tos_has_tag, tos_alpha_g_ptr, nos_ptr + width, nos_isolated, nos_planestride,
+            nos_rowstride, nos_alpha_g_ptr, nos_knockout, nos_shape_offset, nos_tag_offset,
+            mask_row_ptr, has_mask, maskbuf, mask_bg_alpha, mask_tr_fn, backdrop_ptr,
+            has_matte, n_chan, additive, num_spots, overprint, drawn_comps, x0 + width, y0, x1, y1, pblend_procs, pdev);
+}
+
+/* The 4 unsigned 32 bit values in v as 2 pairs of doubles. */
+static inline void
+sse2_cvtepu32_pd(__m128i v, __m128d *lo, __m128d *hi)
+{
+    const __m128d dbias = _mm_set1_pd(2147483648.0);
+    __m128i vs = _mm_xor_si128(v, _mm_set1_epi32((int)0x80000000));
+
+    *lo = _mm_add_pd(_mm_cvtepi32_pd(vs), dbias);
+    *hi = _mm_add_pd(_mm_cvtepi32_pd(_mm_shuffle_epi32(vs, _MM_SHUFFLE(1, 0, 3, 2))), dbias);
+}
+
+/* Round down to an integer, for |x| < 2^51. */
+static inline __m128d
+sse2_floor_pd(__m128d x)
+{
+    /* Adding 1.5 * 2^52 leaves no fraction bits, so rounds to an integer. */
+    const __m128d magic = _mm_set1_pd(6755399441055744.0);
+    __m128d r = _mm_sub_pd(_mm_add_pd(x, magic), magic);
+
+    return _mm_sub_pd(r, _mm_and_pd(_mm_cmpgt_pd(r, x), _mm_set1_pd(1.0)));
+}
+
+/* v < lo ? lo : v > hi ? hi : v */
+static inline __m128i
+sse2_clamp_epi32(__m128i v, __m128i lo, __m128i hi)
+{
+    v = sse2_select(_mm_cmplt_epi32(v, lo), lo, v);
+    return sse2_select(_mm_cmpgt_epi32(v, hi), hi, v);
+}
+
+/*
+ * The uncompositing step of art_pdf_recomposite_group_16:
+ *   s + (((s - d) * scale + 0x8000) >> 16), clamped to 0..0xffff,
+ * where scale (which can need all 32 bits) is given as doubles. The product
+ * needs up to 49 bits, so it is done exactly in double precision.
+ */
+static inline __m128i
+sse2_uncomposite16(__m128i s, __m128i d, __m128d scale_lo, __m128d scale_hi)
+{
+    const __m128d half = _mm_set1_pd(32768.0);
+    const __m128d inv = _mm_set1_pd(1.0 / 65536.0);
+    const __m128d lim = _mm_set1_pd(131072.0);
+    __m128i diff = _mm_sub_epi32(s, d);
+    __m128d lo = _mm_mul_pd(_mm_cvtepi32_pd(diff), scale_lo);
+    __m128d hi = _mm_mul_pd(_mm_cvtepi32_pd(_mm_shuffle_epi32(diff, _MM_SHUFFLE(1, 0, 3, 2))), scale_hi);
+
+    /* Anything outside -0x20000..0x20000 clamps the same way. */
+    lo = sse2_floor_pd(_mm_mul_pd(_mm_add_pd(lo, half), inv));
+    hi = sse2_floor_pd(_mm_mul_pd(_mm_add_pd(hi, half), inv));
+    lo = _mm_max_pd(_mm_min_pd(lo, lim), _mm_sub_pd(_mm_setzero_pd(), lim));
+    hi = _mm_max_pd(_mm_min_pd(hi, lim), _mm_sub_pd(_mm_setzero_pd(), lim));
+    return sse2_clamp_epi32(_mm_add_epi32(s, _mm_unpacklo_epi64(_mm_cvttpd_epi32(lo), _mm_cvttpd_epi32(hi))),
+                            _mm_setzero_si128(), _mm_set1_epi32(0xffff));
+}
+
+/* The union of 2 alphas: 0xffff - (0xffff - a) * (0xffff - b). */
+static inline __m128i
+sse2_union16(__m128i a, __m128i b)
+{
+    __m128i tmp = _mm_sub_epi32(_mm_set1_epi32(0x10000), _mm_add_epi32(a, _mm_srli_epi32(a, 15)));
+
+    tmp = _mm_add_epi32(sse2_mullo_epi32(tmp, _mm_sub_epi32(_mm_set1_epi32(0xffff), b)),
+                        _mm_set1_epi32(0x8000));
+    return _mm_sub_epi32(_mm_set1_epi32(0xffff), _mm_srli_epi32(tmp, 16));
+}
+
+/*
+ * A non-isolated group (which always has alpha_g) composed in Normal blend
+ * mode with no soft mask, shape, tags, spots or backdrop: the commonest case
+ * that the other fast paths leave to template_compose_group16. This follows
+ * art_pdf_recomposite_group_16 and art_pdf_composite_pixel_alpha_16_inline,
+ * including the complementing of subtractive colors, and so gives exactly
+ * the same results.
+ */
+static void
+compose_group16_nonknockout_nonblend_nonisolated_alpha_g_sse2(uint16_t *tos_ptr, bool tos_isolated, int tos_planestride, int tos_rowstride,
+              uint16_t alpha, uint16_t shape, gs_blend_mode_t blend_mode, bool tos_has_shape, int tos_shape_offset, int tos_alpha_g_offset,
+              int tos_tag_offset, bool tos_has_tag, uint16_t *tos_alpha_g_ptr, uint16_t *nos_ptr, bool nos_isolated, int nos_planestride,
+              int nos_rowstride, uint16_t *nos_alpha_g_ptr, bool nos_knockout, int nos_shape_offset, int nos_tag_offset,
+              uint16_t *mask_row_ptr, int has_mask, pdf14_buf *maskbuf, uint16_t mask_bg_alpha, const uint16_t *mask_tr_fn, uint16_t *backdrop_ptr,
+              bool has_matte, int n_chan, bool additive, int num_spots, bool overprint, gx_color_index drawn_comps, int x0, int y0, int x1, int y1,
+              const pdf14_nonseparable_blending_procs_t *pblend_procs, pdf14_device *pdev)
+{
+    int width = (x1 - x0) & ~3;
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i ones = _mm_cmpeq_epi32(zero, zero);
+    const __m128i cffff = _mm_set1_epi32(0xffff);
+    const __m128i flip = additive ? zero : cffff;
+    const __m128i valpha = _mm_set1_epi32(alpha + (alpha >> 15));
+    uint16_t *tos_row = tos_ptr;
+    uint16_t *nos_row = nos_ptr;
+    uint16_t *nos_alpha_g_row = nos_alpha_g_ptr;
+    int x, y, i;
+
+    for (y = y1 - y0; y > 0; --y) {
+        for (x = 0; x < width; x += 4) {
+            uint16_t *tp = tos_row + x;
+            uint16_t *np = nos_row + x;
+            __m128i a_g = sse2_load4_u16(tp + tos_alpha_g_offset);
+            __m128i active, a_s, a_b, a_r, tmp, scale, uncomp, comp, copy;
+            __m128d uscale_lo, uscale_hi;
+            bool any_uncomp;
+
+            uscale_lo = uscale_hi = _mm_setzero_pd();
+            if (sse2_all_zero_epi32(a_g))
+                continue;
+            active = _mm_xor_si128(_mm_cmpeq_epi32(a_g, zero), ones);
+            if (alpha == 65535) {
+                /* Uncompositing and recompositing cancel out. */
+                if (nos_alpha_g_row != NULL) {
+                    __m128i n_g = sse2_load4_u16(nos_alpha_g_row + x);
+
+                    sse2_store4_u16(nos_alpha_g_row + x,
+                                    sse2_select(active, sse2_union16(n_g, a_g), n_g));
+                }
+                for (i = 0; i <= n_chan; i++)
+                    sse2_store4_u16(np + i * nos_planestride,
+                                    sse2_select(active, sse2_load4_u16(tp + i * tos_planestride),
+                                                sse2_load4_u16(np + i * nos_planestride)));
+                continue;
+            }
+            a_b = sse2_load4_u16(np + n_chan * nos_planestride);
+            a_s = _mm_srli_epi32(_mm_add_epi32(sse2_mullo_epi32(a_g, valpha),
+                                               _mm_set1_epi32(0x8000)), 16);
+            if (nos_alpha_g_row != NULL) {
+                __m128i n_g = sse2_load4_u16(nos_alpha_g_row + x);
+
+                sse2_store4_u16(nos_alpha_g_row + x,
+                                sse2_select(active, sse2_union16(n_g, a_s), n_g));
+            }
+            /* The scale for uncompositing, dst_alpha / src_alpha_g - 1 */
+            uncomp = _mm_andnot_si128(_mm_or_si128(_mm_cmpeq_epi32(a_g, cffff),
+                                                   _mm_cmpeq_epi32(a_b, zero)), active);
+            any_uncomp = !sse2_all_zero_epi32(uncomp);
+            if (any_uncomp) {
+                __m128d n_lo, n_hi, d_lo, d_hi, b_lo, b_hi;
+
+                sse2_cvtepu32_pd(_mm_add_epi32(_mm_sub_epi32(_mm_slli_epi32(a_b, 16), a_b),
+                                               _mm_srli_epi32(a_g, 1)), &n_lo, &n_hi);
+                sse2_cvtepu32_pd(sse2_nonzero_epi32(a_g), &d_lo, &d_hi);
+                sse2_cvtepu32_pd(a_b, &b_lo, &b_hi);
+                uscale_lo = _mm_sub_pd(sse2_floor_pd(_mm_div_pd(n_lo, d_lo)), b_lo);
+                uscale_hi = _mm_sub_pd(sse2_floor_pd(_mm_div_pd(n_hi, d_hi)), b_hi);
+            }
+            /* Then composite as art_pdf_composite_pixel_alpha_16_inline */
+            comp = _mm_andnot_si128(_mm_or_si128(_mm_cmpeq_epi32(a_s, zero),
+                                                 _mm_cmpeq_epi32(a_b, zero)), active);
+            copy = _mm_andnot_si128(_mm_cmpeq_epi32(a_s, zero),
+                                    _mm_and_si128(_mm_cmpeq_epi32(a_b, zero), active));
+            a_r = sse2_union16(a_b, a_s);
+            scale = sse2_div_epu32(_mm_add_epi32(_mm_slli_epi32(a_s, 16), _mm_srli_epi32(a_r, 1)),
+                                   sse2_nonzero_epi32(a_r));
+            scale = _mm_srli_epi32(scale, 1);
+            for (i = 0; i < n_chan; i++) {
+                __m128i c_s = _mm_xor_si128(sse2_load4_u16(tp + i * tos_planestride), flip);
+                __m128i c_b = _mm_xor_si128(sse2_load4_u16(np + i * nos_planestride), flip);
+
+                if (any_uncomp)
+                    c_s = sse2_select(uncomp, sse2_uncomposite16(c_s, c_b, uscale_lo, uscale_hi), c_s);
+                tmp = _mm_add_epi32(sse2_mullo_epi32(scale, _mm_sub_epi32(c_s, c_b)), _mm_set1_epi32(0x4000));
+                tmp = _mm_add_epi32(c_b, _mm_srai_epi32(tmp, 15));
+                sse2_store4_u16(np + i * nos_planestride,
+                                _mm_xor_si128(sse2_select(comp, tmp, sse2_select(copy, c_s, c_b)), flip));
+            }
+            sse2_store4_u16(np + n_chan * nos_planestride,
+                            sse2_select(comp, a_r, sse2_select(copy, a_s, a_b)));
+        }
+        tos_row += tos_rowstride;
+        nos_row += nos_rowstride;
+        if (nos_alpha_g_row != NULL)
+            nos_alpha_g_row += nos_rowstride;
+    }
+    if (x0 + width < x1)
+        compose_group16_nonknockout_noblend_general(tos_ptr + width, tos_isolated, tos_planestride, tos_rowstride,
+            alpha, shape, blend_mode, tos_has_shape, tos_shape_offset, tos_alpha_g_offset,
+            tos_tag_offset, tos_has_tag, tos_alpha_g_ptr + width, nos_ptr + width, nos_isolated, nos_planestride,
+            nos_rowstride, nos_alpha_g_ptr == NULL ? NULL : nos_alpha_g_ptr + width, nos_knockout, nos_shape_offset, nos_tag_offset,
+            mask_row_ptr, has_mask, maskbuf, mask_bg_alpha, mask_tr_fn, backdrop_ptr,
+            has_matte, n_chan, additive, num_spots, overprint, drawn_comps, x0 + width, y0, x1, y1, pblend_procs, pdev);
+}
+#endif /* HAVE_SSE2 */
+
 static void
 compose_group16_alphaless_knockout(uint16_t *tos_ptr, bool tos_isolated, int tos_planestride, int tos_rowstride,
               uint16_t alpha, uint16_t shape, gs_blend_mode_t blend_mode, bool tos_has_shape, int tos_shape_offset,
@@ -4216,6 +4827,7 @@ do_compose_group16(pdf14_buf *tos, pdf14_buf *nos, pdf14_buf *maskbuf,
     if ((tos->n_chan == 0) || (nos->n_chan == 0))
         return;
     rect_merge(nos->dirty, tos->dirty);
+    pdf14_buf_mark_dirty(nos, x0, y0, x1 - x0, y1 - y0);
     if (nos->has_tags)
         if_debug7m('v', memory,
                    "pdf14_pop_transparency_group y0 = %d, y1 = %d, w = %d, alpha = %d, shape = %d, tag = %d, bm = %d\n",
@@ -4244,6 +4856,15 @@ do_compose_group16(pdf14_buf *tos, pdf14_buf *nos, pdf14_buf *maskbuf,
     if (blend_mode != BLEND_MODE_Compatible && blend_mode != BLEND_MODE_Normal)
         overprint = false;
 
+    /* An opaque constant soft mask changes nothing; see do_compose_group. */
+    if (maskbuf != NULL && maskbuf->data != NULL && maskbuf->rowstride == 0 &&
+        !nos_knockout && !has_matte &&
+        interp16((uint16_t *)maskbuf->transfer_fn,
+                 *(uint16_t *)(void *)maskbuf->data) == 65535 &&
+        maskbuf->rect.p.x <= x0 && maskbuf->rect.p.y <= y0 &&
+        maskbuf->rect.q.x >= x1 && maskbuf->rect.q.y >= y1)
+        maskbuf = NULL;
+
     if (maskbuf != NULL) {
         unsigned int tmp;
         mask_tr_fn = (uint16_t *)maskbuf->transfer_fn;
@@ -4333,15 +4954,30 @@ do_compose_group16(pdf14_buf *tos, pdf14_buf *nos, pdf14_buf *maskbuf,
                     /* Outside mask data but still has mask */
                     fn = &compose_group16_nonknockout_nonblend_isolated_mask_common;
                 } else {
+#ifdef HAVE_SSE2
+                    fn = &compose_group16_nonknockout_nonblend_isolated_nomask_sse2;
+#else
                     fn = &compose_group16_nonknockout_nonblend_isolated_nomask_common;
+#endif
                 }
         } else {
             if (has_mask || maskbuf) /* 4% */
                 fn = &compose_group16_nonknockout_nonblend_nonisolated_mask_common;
             else /* 15% */
+#ifdef HAVE_SSE2
+                fn = &compose_group16_nonknockout_nonblend_nonisolated_nomask_sse2;
+#else
                 fn = &compose_group16_nonknockout_nonblend_nonisolated_nomask_common;
+#endif
         }
-    } else
+    }
+#ifdef HAVE_SSE2
+    else if (!tos_isolated && tos_alpha_g_ptr != NULL && tos->has_shape == 0 && tos_has_tag == 0 &&
+             nos_shape_offset == 0 && nos_tag_offset == 0 && backdrop_ptr == NULL && has_matte == 0 &&
+             num_spots == 0 && overprint == 0 && maskbuf == NULL)
+        fn = &compose_group16_nonknockout_nonblend_nonisolated_alpha_g_sse2;
+#endif
+    else
         fn = compose_group16_nonknockout_noblend_general;
 
     tos_planestride >>= 1;
@@ -4430,6 +5066,7 @@ do_compose_alphaless_group(pdf14_buf *tos, pdf14_buf *nos,
     if ((tos->n_chan == 0) || (nos->n_chan == 0))
         return;
     rect_merge(nos->dirty, tos->dirty);
+    pdf14_buf_mark_dirty(nos, x0, y0, x1 - x0, y1 - y0);
     if (nos->has_tags)
         if_debug7m('v', memory,
                    "pdf14_pop_transparency_group y0 = %d, y1 = %d, w = %d, alpha = %d, shape = %d, tag = %d, bm = %d\n",
@@ -4567,6 +5204,7 @@ do_compose_alphaless_group16(pdf14_buf *tos, pdf14_buf *nos,
     if ((tos->n_chan == 0) || (nos->n_chan == 0))
         return;
     rect_merge(nos->dirty, tos->dirty);
+    pdf14_buf_mark_dirty(nos, x0, y0, x1 - x0, y1 - y0);
     if (nos->has_tags)
         if_debug7m('v', memory,
                    "pdf14_pop_transparency_group y0 = %d, y1 = %d, w = %d, alpha = %d, shape = %d, tag = %d, bm = %d\n",
@@ -5188,10 +5826,7 @@ do_mark_fill_rectangle(gx_device * dev, int x, int y, int w, int h,
     if (x + w > buf->rect.q.x) w = buf->rect.q.x - x;
     if (y + h > buf->rect.q.y) h = buf->rect.q.y - y;
     /* Update the dirty rectangle with the mark */
-    if (x < buf->dirty.p.x) buf->dirty.p.x = x;
-    if (y < buf->dirty.p.y) buf->dirty.p.y = y;
-    if (x + w > buf->dirty.q.x) buf->dirty.q.x = x + w;
-    if (y + h > buf->dirty.q.y) buf->dirty.q.y = y + h;
+    pdf14_buf_mark_dirty(buf, x, y, w, h);
     dst_ptr = buf->data + (x - buf->rect.p.x) + (y - buf->rect.p.y) * rowstride;
     src_alpha = 255-src_alpha;
     shape = 255-shape;
@@ -5433,6 +6068,11 @@ mark_fill_rect16_sub4_fast(int w, int h, uint16_t *gs_restrict dst_ptr, uint16_t
                int alpha_g_off, int shape_off, uint16_t shape)
 {
     int i, j, k;
+    /* The source is constant, so the result alpha and the scale depend only
+       on the backdrop alpha; keep them for the last one seen, to save a
+       division per pixel. */
+    int last_a_b = -1;
+    unsigned int a_r = 0, src_scale = 0;
 
     for (j = h; j > 0; --j) {
         for (i = w; i > 0; --i) {
@@ -5447,20 +6087,22 @@ mark_fill_rect16_sub4_fast(int w, int h, uint16_t *gs_restrict dst_ptr, uint16_t
                 /* alpha */
                 dst_ptr[4 * planestride] = a_s;
             } else if (a_s != 0) {
-                /* Result alpha is Union of backdrop and source alpha */
-                unsigned int tmp, src_scale;
-                unsigned int a_r;
+                unsigned int tmp;
 
-                a_b += a_b>>15;
-                tmp = (0x10000 - a_b) * (0xffff - a_s) + 0x8000;
-                a_r = 0xffff - (tmp >> 16);
+                if (a_b != last_a_b) {
+                    last_a_b = a_b;
+                    /* Result alpha is Union of backdrop and source alpha */
+                    a_b += a_b>>15;
+                    tmp = (0x10000 - a_b) * (0xffff - a_s) + 0x8000;
+                    a_r = 0xffff - (tmp >> 16);
 
-                /* Compute a_s / a_r in 16.16 format */
-                src_scale = ((a_s << 16) + (a_r >> 1)) / a_r;
+                    /* Compute a_s / a_r in 16.16 format */
+                    src_scale = ((a_s << 16) + (a_r >> 1)) / a_r;
+                    src_scale >>= 1; /* Lose a bit to avoid overflow */
+                }
 
                 dst_ptr[4 * planestride] = a_r;
 
-                src_scale >>= 1; /* Lose a bit to avoid overflow */
                 /* Do simple compositing of source over backdrop */
                 for (k = 0; k < 4; k++) {
                     int c_s = src[k];
@@ -5518,6 +6160,10 @@ mark_fill_rect16_add3_common(int w, int h, uint16_t *gs_restrict dst_ptr, uint16
                int alpha_g_off, int shape_off, uint16_t shape)
 {
     int i, j, k;
+    /* As in mark_fill_rect16_sub4_fast, keep the result alpha and scale for
+       the last backdrop alpha. */
+    int last_a_b = -1;
+    unsigned int a_r = 0, src_scale = 0;
 
     for (j = h; j > 0; --j) {
         for (i = w; i > 0; --i) {
@@ -5531,21 +6177,23 @@ mark_fill_rect16_add3_common(int w, int h, uint16_t *gs_restrict dst_ptr, uint16
                 /* alpha */
                 dst_ptr[3 * planestride] = a_s;
             } else if (a_s != 0) {
-                unsigned int tmp, src_scale;
-                unsigned int a_r;
+                unsigned int tmp;
 
-                a_b += a_b >> 15;
-                /* Result alpha is Union of backdrop and source alpha */
-                tmp = (0x10000 - a_b) * (0xffff - a_s) + 0x8000;
-                a_r = 0xffff - (tmp >> 16);
-                /* todo: verify that a_r is nonzero in all cases */
+                if (a_b != last_a_b) {
+                    last_a_b = a_b;
+                    a_b += a_b >> 15;
+                    /* Result alpha is Union of backdrop and source alpha */
+                    tmp = (0x10000 - a_b) * (0xffff - a_s) + 0x8000;
+                    a_r = 0xffff - (tmp >> 16);
+                    /* todo: verify that a_r is nonzero in all cases */
 
-                /* Compute a_s / a_r in 16.16 format */
-                src_scale = ((a_s << 16) + (a_r >> 1)) / a_r;
+                    /* Compute a_s / a_r in 16.16 format */
+                    src_scale = ((a_s << 16) + (a_r >> 1)) / a_r;
+                    src_scale >>= 1; /* Lose a bit to avoid overflow */
+                }
 
                 dst_ptr[3 * planestride] = a_r;
 
-                src_scale >>= 1; /* Lose a bit to avoid overflow */
                 /* Do simple compositing of source over backdrop */
                 for (k = 0; k < 3; k++) {
                     int c_s = src[k];
@@ -5808,10 +6456,7 @@ do_mark_fill_rectangle16(gx_device * dev, int x, int y, int w, int h,
     if (x + w > buf->rect.q.x) w = buf->rect.q.x - x;
     if (y + h > buf->rect.q.y) h = buf->rect.q.y - y;
     /* Update the dirty rectangle with the mark */
-    if (x < buf->dirty.p.x) buf->dirty.p.x = x;
-    if (y < buf->dirty.p.y) buf->dirty.p.y = y;
-    if (x + w > buf->dirty.q.x) buf->dirty.q.x = x + w;
-    if (y + h > buf->dirty.q.y) buf->dirty.q.y = y + h;
+    pdf14_buf_mark_dirty(buf, x, y, w, h);
     dst_ptr = (uint16_t *)(buf->data + (x - buf->rect.p.x) * 2 + (y - buf->rect.p.y) * rowstride);
     src_alpha = 65535-src_alpha;
     shape = 65535-shape;
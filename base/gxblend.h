@@ -345,6 +345,9 @@ void pdf14_preserve_backdrop(pdf14_buf *buf, pdf14_buf *tos, bool knockout_buff
 #endif
                              );
 
+void pdf14_preserve_backdrop_rect(pdf14_buf *buf, pdf14_buf *tos,
+                                  const gs_int_rect *rect);
+
 int pdf14_preserve_backdrop_cm(pdf14_buf *buf, cmm_profile_t *group_profile,
                                pdf14_buf *tos, cmm_profile_t *tos_profile,
                                gs_memory_t *memory, gs_gstate *pgs,
@@ -33,6 +33,9 @@
 #ifdef DUMP_TO_PNG
 #include "png_.h"
 #endif
+#ifdef HAVE_SSE2
+#include <emmintrin.h>
+#endif
 
 /* A case where we have RGB + spots.  This is actually an RGB color and we
  * should zero out the spot colorants */
@@ -385,6 +388,52 @@ pdf14_preserve_backdrop(pdf14_buf *buf, pdf14_buf *tos, bool from_backdrop
 #endif
 }
 
+/*
+ * Reinitialise the area rect of the non-isolated group buf from its backdrop
+ * tos, as pdf14_preserve_backdrop does for the whole of buf, refreshing the
+ * knockout copy of the backdrop too if buf has one.  rect must lie within
+ * both buffers.
+ */
+void
+pdf14_preserve_backdrop_rect(pdf14_buf *buf, pdf14_buf *tos,
+                             const gs_int_rect *rect)
+{
+    int width = rect->q.x - rect->p.x;
+    int height = rect->q.y - rect->p.y;
+    bool deep = buf->deep;
+    int buf_offset = (rect->p.y - buf->rect.p.y) * buf->rowstride +
+                     ((rect->p.x - buf->rect.p.x)<<deep);
+    byte *buf_plane = buf->data + buf_offset;
+    byte *tos_plane = tos->data + (rect->p.y - tos->rect.p.y) * tos->rowstride +
+                      ((rect->p.x - tos->rect.p.x)<<deep);
+    int num_cleared = (buf->has_shape ? 1 : 0) + (buf->has_alpha_g ? 1 : 0);
+    int i, y;
+
+    if (width <= 0 || height <= 0)
+        return;
+    /* Color and alpha plane */
+    for (i = 0; i < tos->n_chan; i++) {
+        copy_plane_part(buf_plane, buf->rowstride, tos_plane, tos->rowstride,
+                        width, height, deep);
+        buf_plane += buf->planestride;
+        tos_plane += tos->planestride;
+    }
+    /* shape and alpha_g start out clear, the tags are copied */
+    copy_extra_planes(buf_plane, buf, tos_plane, tos, width, height);
+    for (i = 0; i < num_cleared; i++) {
+        byte *row = buf_plane + i * buf->planestride;
+
+        for (y = 0; y < height; y++, row += buf->rowstride)
+            memset(row, 0, width<<deep);
+    }
+    if (buf->backdrop != NULL)
+        for (i = 0; i < buf->n_planes; i++)
+            copy_plane_part(buf->backdrop + buf_offset + i * buf->planestride,
+                            buf->rowstride,
+                            buf->data + buf_offset + i * buf->planestride,
+                            buf->rowstride, width, height, deep);
+}
+
 /*
  * Encode a list of colorant values into a gx_color_index_value.
  */
@@ -721,12 +770,359 @@ dump_planar_rgba(gs_memory_t *mem, const pdf14_buf *pbuf)
 }
 #endif
 
+#ifdef HAVE_SSE2
+/*
+ * SSE2 versions of the final blend of the pdf14 buffer with the background
+ * and of the interleaving of its planes into chunky rows.  They follow the
+ * integer arithmetic of the scalar code below exactly, so the results are
+ * the same.  Each returns the number of pixels it did; the ones left over
+ * at the right are done by the scalar code.
+ */
+
+/* mask ? a : b */
+static inline __m128i
+sse2_select(__m128i mask, __m128i a, __m128i b)
+{
+    return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+static inline __m128i
+sse2_byteswap_u16(__m128i v)
+{
+    return _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+}
+
+/* The low 16 bits of 8 32 bit values, packed without saturating. */
+static inline __m128i
+sse2_pack_low16(__m128i lo, __m128i hi)
+{
+    lo = _mm_srai_epi32(_mm_slli_epi32(lo, 16), 16);
+    hi = _mm_srai_epi32(_mm_slli_epi32(hi, 16), 16);
+    return _mm_packs_epi32(lo, hi);
+}
+
+/* The 32 bit products of 8 pairs of unsigned 16 bit values. */
+static inline void
+sse2_mul_u16(__m128i a, __m128i b, __m128i *lo, __m128i *hi)
+{
+    __m128i l = _mm_mullo_epi16(a, b);
+    __m128i h = _mm_mulhi_epu16(a, b);
+
+    *lo = _mm_unpacklo_epi16(l, h);
+    *hi = _mm_unpackhi_epi16(l, h);
+}
+
+/* Blend 16 8 bit components c, whose inverted alphas are ai, with bg. */
+static inline __m128i
+sse2_blend_bg_u8(__m128i c, __m128i ai, __m128i bg)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one = _mm_set1_epi16(1);
+    const __m128i round = _mm_set1_epi16(0x80);
+    __m128i c_lo = _mm_unpacklo_epi8(c, zero);
+    __m128i c_hi = _mm_unpackhi_epi8(c, zero);
+    __m128i ai_lo = _mm_unpacklo_epi8(ai, zero);
+    __m128i ai_hi = _mm_unpackhi_epi8(ai, zero);
+    __m128i d_lo = _mm_sub_epi16(bg, c_lo);
+    __m128i d_hi = _mm_sub_epi16(bg, c_hi);
+    __m128i t0, t1, t2, t3;
+
+    /* tmp = (bg - comp) * ai + 0x80, as the products of (d, 1) and (ai, 0x80) */
+    t0 = _mm_madd_epi16(_mm_unpacklo_epi16(d_lo, one), _mm_unpacklo_epi16(ai_lo, round));
+    t1 = _mm_madd_epi16(_mm_unpackhi_epi16(d_lo, one), _mm_unpackhi_epi16(ai_lo, round));
+    t2 = _mm_madd_epi16(_mm_unpacklo_epi16(d_hi, one), _mm_unpacklo_epi16(ai_hi, round));
+    t3 = _mm_madd_epi16(_mm_unpackhi_epi16(d_hi, one), _mm_unpackhi_epi16(ai_hi, round));
+    /* comp += (tmp + (tmp >> 8)) >> 8 */
+    t0 = _mm_srai_epi32(_mm_add_epi32(t0, _mm_srai_epi32(t0, 8)), 8);
+    t1 = _mm_srai_epi32(_mm_add_epi32(t1, _mm_srai_epi32(t1, 8)), 8);
+    t2 = _mm_srai_epi32(_mm_add_epi32(t2, _mm_srai_epi32(t2, 8)), 8);
+    t3 = _mm_srai_epi32(_mm_add_epi32(t3, _mm_srai_epi32(t3, 8)), 8);
+    c_lo = _mm_add_epi16(c_lo, _mm_packs_epi32(t0, t1));
+    c_hi = _mm_add_epi16(c_hi, _mm_packs_epi32(t2, t3));
+    return _mm_packus_epi16(c_lo, c_hi);
+}
+
+/* Blend 8 16 bit components c, with alphas a (neither 0 nor 0xffff), with
+ * bg as gx_build_blended_image_row16 does. */
+static inline __m128i
+sse2_blend_bg_row_u16(__m128i c, __m128i a, __m128i bg)
+{
+    const __m128i round = _mm_set1_epi32(0x8000);
+    __m128i ai = _mm_xor_si128(a, _mm_set1_epi16(-1));
+    __m128i c0, c1, b0, b1;
+
+    ai = _mm_add_epi16(ai, _mm_srli_epi16(ai, 15));
+    /* comp += ((bg - comp) * a + 0x8000) >> 16, all unsigned 32 bit */
+    sse2_mul_u16(c, ai, &c0, &c1);
+    sse2_mul_u16(bg, ai, &b0, &b1);
+    c0 = _mm_srli_epi32(_mm_add_epi32(_mm_sub_epi32(b0, c0), round), 16);
+    c1 = _mm_srli_epi32(_mm_add_epi32(_mm_sub_epi32(b1, c1), round), 16);
+    return _mm_add_epi16(c, sse2_pack_low16(c0, c1));
+}
+
+/* Blend 8 16 bit components c, with alphas a (neither 0 nor 0xffff), with
+ * bg as gx_blend_image_buffer16 does. */
+static inline __m128i
+sse2_blend_bg_buffer_u16(__m128i c, __m128i a, __m128i bg)
+{
+    const __m128i round = _mm_set1_epi32(0x4000);
+    __m128i ai = _mm_xor_si128(a, _mm_set1_epi16(-1));
+    __m128i c0, c1, b0, b1;
+
+    ai = _mm_srli_epi16(_mm_add_epi16(ai, _mm_srli_epi16(ai, 15)), 1);
+    /* comp += ((bg - comp) * a + 0x4000) >> 15, all signed 32 bit */
+    sse2_mul_u16(c, ai, &c0, &c1);
+    sse2_mul_u16(bg, ai, &b0, &b1);
+    c0 = _mm_srai_epi32(_mm_add_epi32(_mm_sub_epi32(b0, c0), round), 15);
+    c1 = _mm_srai_epi32(_mm_add_epi32(_mm_sub_epi32(b1, c1), round), 15);
+    return _mm_add_epi16(c, sse2_pack_low16(c0, c1));
+}
+
+/* Store 16 pixels of 3 8 bit components, given as 4 vectors of 4 pixels
+ * with a spare 4th component. Each spare byte is overwritten by the next
+ * pixel, and the last one isn't written. */
+static inline void
+sse2_store_rgb_u8(byte *dst, const __m128i *px)
+{
+    int i, j, v;
+
+    for (i = 0; i < 4; i++) {
+        __m128i p = px[i];
+
+        for (j = 0; j < 4; j++) {
+            v = _mm_cvtsi128_si32(p);
+            p = _mm_srli_si128(p, 4);
+            if (i == 3 && j == 3)
+                memcpy(dst, &v, 3);
+            else
+                memcpy(dst, &v, 4);
+            dst += 3;
+        }
+    }
+}
+
+/* As above, for 8 pixels of 3 16 bit components in 4 vectors of 2 pixels. */
+static inline void
+sse2_store_rgb_u16(byte *dst, const __m128i *px)
+{
+    byte last[8];
+    int i;
+
+    for (i = 0; i < 4; i++) {
+        _mm_storel_epi64((__m128i *)dst, px[i]);
+        dst += 6;
+        if (i == 3) {
+            _mm_storel_epi64((__m128i *)last, _mm_srli_si128(px[i], 8));
+            memcpy(dst, last, 6);
+        } else
+            _mm_storel_epi64((__m128i *)dst, _mm_srli_si128(px[i], 8));
+        dst += 6;
+    }
+}
+
+static int
+build_blended_image_row_sse2(const byte *gs_restrict buf_ptr, int planestride,
+                             int width, int num_comp, byte bg, byte *gs_restrict linebuf)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i ones = _mm_set1_epi8(-1);
+    const __m128i bg8 = _mm_set1_epi8(bg);
+    const __m128i bg16 = _mm_set1_epi16(bg);
+    const byte *alpha_ptr = buf_ptr + planestride * num_comp;
+    bool generic = num_comp != 1 && num_comp != 3 && num_comp != 4;
+    __m128i c[4], px[4];
+    byte out[GS_CLIENT_COLOR_MAX_COMPONENTS * 16];
+    int x, i, k;
+
+    if (num_comp > GS_CLIENT_COLOR_MAX_COMPONENTS)
+        return 0;
+    for (x = 0; x + 16 <= width; x += 16) {
+        __m128i a = _mm_loadu_si128((const __m128i *)(alpha_ptr + x));
+        bool clear = _mm_movemask_epi8(_mm_cmpeq_epi8(a, zero)) == 0xffff;
+        bool opaque = _mm_movemask_epi8(_mm_cmpeq_epi8(a, ones)) == 0xffff;
+        __m128i ai = _mm_xor_si128(a, ones);
+
+        for (k = 0; k < num_comp; k++) {
+            __m128i v = bg8;
+
+            if (!clear) {
+                v = _mm_loadu_si128((const __m128i *)(buf_ptr + x + planestride * k));
+                if (!opaque)
+                    v = sse2_blend_bg_u8(v, ai, bg16);
+            }
+            if (generic)
+                _mm_storeu_si128((__m128i *)(out + 16 * k), v);
+            else
+                c[k] = v;
+        }
+        if (generic) {
+            for (i = 0; i < 16; i++)
+                for (k = 0; k < num_comp; k++)
+                    linebuf[i * num_comp + k] = out[16 * k + i];
+        } else if (num_comp == 1)
+            _mm_storeu_si128((__m128i *)linebuf, c[0]);
+        else {
+            if (num_comp == 3)
+                c[3] = zero;
+            px[0] = _mm_unpacklo_epi8(c[0], c[1]);
+            px[1] = _mm_unpackhi_epi8(c[0], c[1]);
+            px[2] = _mm_unpacklo_epi8(c[2], c[3]);
+            px[3] = _mm_unpackhi_epi8(c[2], c[3]);
+            c[0] = _mm_unpacklo_epi16(px[0], px[2]);
+            c[1] = _mm_unpackhi_epi16(px[0], px[2]);
+            c[2] = _mm_unpacklo_epi16(px[1], px[3]);
+            c[3] = _mm_unpackhi_epi16(px[1], px[3]);
+            if (num_comp == 3)
+                sse2_store_rgb_u8(linebuf, c);
+            else
+                for (i = 0; i < 4; i++)
+                    _mm_storeu_si128((__m128i *)(linebuf + 16 * i), c[i]);
+        }
+        linebuf += 16 * num_comp;
+    }
+    return x;
+}
+
+/* planestride is in shorts, and the output is big endian. */
+static int
+build_blended_image_row16_sse2(const uint16_t *gs_restrict buf_ptr, int planestride,
+                               int width, int num_comp, uint16_t bg, byte *gs_restrict linebuf)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i ones = _mm_set1_epi16(-1);
+    const __m128i bg16 = _mm_set1_epi16(bg);
+    const __m128i bebg16 = sse2_byteswap_u16(bg16);
+    const uint16_t *alpha_ptr = buf_ptr + planestride * num_comp;
+    __m128i c[4], px[4];
+    int x, i, k;
+
+    /* Interleaving other numbers of components is no quicker than the
+     * scalar code. */
+    if (num_comp != 1 && num_comp != 3 && num_comp != 4)
+        return 0;
+    for (x = 0; x + 8 <= width; x += 8) {
+        __m128i a = _mm_loadu_si128((const __m128i *)(alpha_ptr + x));
+        __m128i is_clear = _mm_cmpeq_epi16(a, zero);
+        bool clear = _mm_movemask_epi8(is_clear) == 0xffff;
+        bool opaque = _mm_movemask_epi8(_mm_cmpeq_epi16(a, ones)) == 0xffff;
+
+        for (k = 0; k < num_comp; k++) {
+            __m128i v = bebg16;
+
+            if (!clear) {
+                v = _mm_loadu_si128((const __m128i *)(buf_ptr + x + planestride * k));
+                if (!opaque)
+                    v = sse2_select(is_clear, bg16, sse2_blend_bg_row_u16(v, a, bg16));
+                v = sse2_byteswap_u16(v);
+            }
+            c[k] = v;
+        }
+        if (num_comp == 1)
+            _mm_storeu_si128((__m128i *)linebuf, c[0]);
+        else {
+            if (num_comp == 3)
+                c[3] = zero;
+            px[0] = _mm_unpacklo_epi16(c[0], c[1]);
+            px[1] = _mm_unpackhi_epi16(c[0], c[1]);
+            px[2] = _mm_unpacklo_epi16(c[2], c[3]);
+            px[3] = _mm_unpackhi_epi16(c[2], c[3]);
+            c[0] = _mm_unpacklo_epi32(px[0], px[2]);
+            c[1] = _mm_unpackhi_epi32(px[0], px[2]);
+            c[2] = _mm_unpacklo_epi32(px[1], px[3]);
+            c[3] = _mm_unpackhi_epi32(px[1], px[3]);
+            if (num_comp == 3)
+                sse2_store_rgb_u16(linebuf, c);
+            else
+                for (i = 0; i < 4; i++)
+                    _mm_storeu_si128((__m128i *)(linebuf + 16 * i), c[i]);
+        }
+        linebuf += 16 * num_comp;
+    }
+    return x;
+}
+
+/* Blend one row of a planar buffer in place. */
+static int
+blend_image_row_sse2(byte *buf_ptr, int width, int planestride, int num_comp, byte bg)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i ones = _mm_set1_epi8(-1);
+    const __m128i bg8 = _mm_set1_epi8(bg);
+    const __m128i bg16 = _mm_set1_epi16(bg);
+    const byte *alpha_ptr = buf_ptr + planestride * num_comp;
+    int x, k;
+
+    for (x = 0; x + 16 <= width; x += 16) {
+        __m128i a = _mm_loadu_si128((const __m128i *)(alpha_ptr + x));
+        __m128i ai = _mm_xor_si128(a, ones);
+
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(a, ones)) == 0xffff)
+            continue;
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(a, zero)) == 0xffff) {
+            for (k = 0; k < num_comp; k++)
+                _mm_storeu_si128((__m128i *)(buf_ptr + x + planestride * k), bg8);
+            continue;
+        }
+        for (k = 0; k < num_comp; k++) {
+            __m128i *p = (__m128i *)(buf_ptr + x + planestride * k);
+
+            _mm_storeu_si128(p, sse2_blend_bg_u8(_mm_loadu_si128(p), ai, bg16));
+        }
+    }
+    return x;
+}
+
+/* As above for 16 bits, converting to big endian; strides are in shorts. */
+static int
+blend_image_row16_sse2(uint16_t *buf_ptr, int width, int planestride, int num_comp,
+                       uint16_t bg)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i ones = _mm_set1_epi16(-1);
+    const __m128i bg16 = _mm_set1_epi16(bg);
+    const __m128i bebg16 = sse2_byteswap_u16(bg16);
+    const uint16_t *alpha_ptr = buf_ptr + planestride * num_comp;
+    int x, k;
+
+    for (x = 0; x + 8 <= width; x += 8) {
+        __m128i a = _mm_loadu_si128((const __m128i *)(alpha_ptr + x));
+        __m128i is_clear = _mm_cmpeq_epi16(a, zero);
+        bool opaque = _mm_movemask_epi8(_mm_cmpeq_epi16(a, ones)) == 0xffff;
+
+        if (_mm_movemask_epi8(is_clear) == 0xffff) {
+            for (k = 0; k < num_comp; k++)
+                _mm_storeu_si128((__m128i *)(buf_ptr + x + planestride * k), bebg16);
+            continue;
+        }
+        for (k = 0; k < num_comp; k++) {
+            __m128i *p = (__m128i *)(buf_ptr + x + planestride * k);
+            __m128i v = _mm_loadu_si128(p);
+
+            if (!opaque)
+                v = sse2_select(is_clear, bg16, sse2_blend_bg_buffer_u16(v, a, bg16));
+            _mm_storeu_si128(p, sse2_byteswap_u16(v));
+        }
+    }
+    return x;
+}
+#endif /* HAVE_SSE2 */
+
 void
 gx_build_blended_image_row(const byte *gs_restrict buf_ptr, int planestride,
                            int width, int num_comp, uint16_t bg, byte *gs_restrict linebuf)
 {
     int inc = planestride * num_comp;
 
+#ifdef HAVE_SSE2
+    {
+        int done = build_blended_image_row_sse2(buf_ptr, planestride, width,
+                                                num_comp, bg, linebuf);
+
+        buf_ptr += done;
+        linebuf += done * num_comp;
+        width -= done;
+    }
+#endif
     buf_ptr += inc - 1;
     for (; width > 0; width--) {
         /* composite RGBA (or CMYKA, etc.) pixel with over solid background */
@@ -769,6 +1165,16 @@ gx_build_blended_image_row16(const byte *gs_restrict buf_ptr_, int planestride,
      * then store out in big endian. */
     planestride >>= 1; /* Array indexing, not byte indexing */
     inc = planestride * num_comp;
+#ifdef HAVE_SSE2
+    {
+        int done = build_blended_image_row16_sse2(buf_ptr, planestride, width,
+                                                  num_comp, bg, linebuf);
+
+        buf_ptr += done;
+        linebuf += 2 * done * num_comp;
+        width -= done;
+    }
+#endif
     buf_ptr += inc - 1;
     for (; width > 0; width--) {
         /* composite RGBA (or CMYKA, etc.) pixel with over solid background */
@@ -816,7 +1222,12 @@ gx_blend_image_buffer(byte *buf_ptr, int width, int height, int rowstride,
 
     for (y = 0; y < height; y++) {
         position = y * rowstride;
-        for (x = 0; x < width; x++) {
+        x = 0;
+#ifdef HAVE_SSE2
+        x = blend_image_row_sse2(buf_ptr + position, width, planestride, num_comp, bg);
+        position += x;
+#endif
+        for (; x < width; x++) {
             /* composite RGBA (or CMYKA, etc.) pixel with over solid background */
             a = buf_ptr[position + planestride * num_comp];
             if ((a + 1) & 0xfe) {
@@ -859,7 +1270,12 @@ gx_blend_image_buffer16(byte *buf_ptr_, int width, int height, int rowstride,
     /* Note that the input here is native endian, and the output must be in big endian! */
     for (y = 0; y < height; y++) {
         position = y * rowstride;
-        for (x = 0; x < width; x++) {
+        x = 0;
+#ifdef HAVE_SSE2
+        x = blend_image_row16_sse2(buf_ptr + position, width, planestride, num_comp, bg);
+        position += x;
+#endif
+        for (; x < width; x++) {
             /* composite RGBA (or CMYKA, etc.) pixel with over solid background */
             a = buf_ptr[position + planestride * num_comp];
             if (a == 0) {
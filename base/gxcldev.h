@@ -297,7 +297,8 @@ struct gx_clist_state_s {
         { 0, 0 }, /* cmd_list */\
         { 0, /* or */\
           0, /* slow rop */\
-          { { max_int, max_int }, /* p */ { min_int, min_int } /* q */ } /* trans_bbox */\
+          { { max_int, max_int }, /* p */ { min_int, min_int } /* q */ }, /* trans_bbox */\
+          0, 0, 0, 0 /* cost statistics */\
         } /* color_usage */
 
 /* Define the size of the command buffer used for reading. */
@@ -668,10 +669,12 @@ typedef enum {
 } clist_playback_action;
 
 /* Play back and rasterize one band. */
+/* bprof is NULL unless the playback is being profiled (see gxclprof.h). */
 int clist_playback_band(clist_playback_action action,
                         gx_device_clist_reader *cdev,
                         stream *s, gx_device *target,
-                        int x0, int y0, gs_memory_t *mem);
+                        int x0, int y0, gs_memory_t *mem,
+                        clist_band_profile_t *bprof);
 
 /* Playback the band file, taking the indicated action w/ its contents. */
 int clist_playback_file_bands(clist_playback_action action,
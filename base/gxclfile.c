@@ -217,6 +217,12 @@ cl_cache_load_slot(CL_CACHE *cache, CL_CACHE_SLOT *slot, int64_t pos, byte *data
  * to be addressed via DELETE_ON_CLOSE under Windows, and immediate unlink
  * after opening under Linux. When running in this mode, we keep our own
  * record of position within the file for the sake of thread safety
+ *
+ * In that mode we also map the file into memory, where the platform
+ * allows it, when we start reading it, and read from the mapping rather
+ * than through the cache. The render threads each open their own IFILE on
+ * the same file, but the mappings all share the operating system's copy of
+ * the data, so the threads no longer read and cache a copy each.
  */
 
 #define ENC_FILE_STR ("encoded_file_ptr_%p")
@@ -229,6 +235,9 @@ typedef struct
     int64_t pos;
     int64_t filesize;		/* filesize maintained by clist_fwrite */
     CL_CACHE *cache;
+    byte *map;			/* read only mapping of the file, or NULL */
+    int64_t map_size;		/* size of the mapping */
+    bool no_map;		/* mapping failed, use the cache */
 } IFILE;
 
 static void
@@ -262,13 +271,28 @@ static IFILE *wrap_file(gs_memory_t *mem, gp_file *f, const char *fmode)
     ifile->pos = 0;
     ifile->filesize = 0;
     ifile->cache = cl_cache_alloc(ifile->mem);
+    ifile->map = NULL;
+    ifile->map_size = 0;
+    ifile->no_map = false;
     return ifile;
 }
 
+/* Release the mapping, if any, because the file is changing. */
+static void clist_unmap_file(IFILE *ifile)
+{
+    if (ifile->map != NULL) {
+        gp_funmap(ifile->map, ifile->map_size);
+        ifile->map = NULL;
+        ifile->map_size = 0;
+    }
+    ifile->no_map = false;
+}
+
 static int clist_close_file(IFILE *ifile)
 {
     int res = 0;
     if (ifile) {
+        clist_unmap_file(ifile);
         if (ifile->f != NULL)
             res = gp_fclose(ifile->f);
         if (ifile->cache != NULL)
@@ -283,7 +307,7 @@ static int clist_close_file(IFILE *ifile)
 static int
 clist_fopen(char fname[gp_file_name_sizeof], const char *fmode,
             clist_file_ptr * pcf, gs_memory_t * mem, gs_memory_t *data_mem,
-            bool ok_to_compress)
+            clist_compress_t compress)
 {
     if (*fname == 0) {
         if (fmode[0] == 'r')
@@ -368,6 +392,8 @@ clist_fwrite_chars(const void *data, uint len, clist_file_ptr cf)
     if (res >= 0)
         icf->pos += len;
     icf->filesize = icf->pos;	/* write truncates file */
+    if (icf->map != NULL || icf->no_map)
+        clist_unmap_file(icf);
     if (!CL_CACHE_NEEDS_INIT(icf->cache)) {
         /* writing invalidates the read cache */
         cl_cache_destroy(icf->cache);
@@ -387,6 +413,23 @@ clist_fread_chars(void *data, uint len, clist_file_ptr cf)
         IFILE *icf = (IFILE *)cf;
         byte *dp = data;
 
+        /* map the file on the first read, if we can */
+        if (icf->map == NULL && !icf->no_map && icf->filesize > 0) {
+            icf->map = gp_fmap(icf->f, icf->filesize);
+            if (icf->map != NULL)
+                icf->map_size = icf->filesize;
+            else
+                icf->no_map = true;
+        }
+        if (icf->map != NULL) {
+            if (icf->pos < icf->map_size) {
+                nread = (icf->map_size - icf->pos < len ?
+                         (int)(icf->map_size - icf->pos) : len);
+                memcpy(dp, icf->map + icf->pos, nread);
+                icf->pos += nread;
+            }
+            return nread;
+        }
         /* if we have a cache, check if it needs init, and do it */
         if (CL_CACHE_NEEDS_INIT(icf->cache)) {
             icf->cache = cl_cache_read_init(icf->cache, CL_CACHE_NSLOTS, 1<<CL_CACHE_SLOT_SIZE_LOG2, icf->filesize);
@@ -484,6 +527,8 @@ clist_rewind(clist_file_ptr cf, bool discard_data, const char *fname)
              * new scratch file. */
             char tfname[gp_file_name_sizeof] = {0};
             const gs_memory_t *mem = ocf->f->memory;
+            clist_unmap_file(ocf);
+            clist_unmap_file((IFILE *)cf);
             gp_fclose(ocf->f);
             ocf->f = gp_open_scratch_file_rm(mem, gp_scratch_file_name_prefix, tfname, fmode);
             if (ocf->f == NULL)
@@ -509,6 +554,7 @@ clist_rewind(clist_file_ptr cf, bool discard_data, const char *fname)
              */
 
             /* Opening with "w" mode deletes the contents when closing. */
+            clist_unmap_file((IFILE *)cf);
             f = gp_freopen(fname, gp_fmode_wb, f);
             if (f == NULL) return_error(gs_error_ioerror);
             ((IFILE *)cf)->f = gp_freopen(fname, fmode, f);
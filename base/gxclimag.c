@@ -1175,6 +1175,8 @@ clist_image_plane_data(gx_image_enum_common_t * info,
                 by0 = y0;
             if (by1 > y1)
                 by1 = y1;
+            if (by1 > by0)
+                re.pcls->color_usage.image_area += (ulong)(bx1 - bx0) * (by1 - by0);
             /*
              * Make sure we're skipping an integral number of pixels, by
              * truncating the initial X coordinate to the next lower
@@ -1278,6 +1280,7 @@ clist_create_compositor(gx_device * dev,
     int first_band = 0, no_of_bands = cdev->nbands;
     int code = pcte->type->procs.write(pcte, 0, &size, cdev);
     int temp_cropping_min, temp_cropping_max;
+    bool is_push;
 
     CMD_CHECK_LAST_OP_BLOCK_DEFINED(cdev);
 
@@ -1303,6 +1306,8 @@ clist_create_compositor(gx_device * dev,
 
     cropping_op = code;
     code = 0;
+    /* Count the groups (and masks) pushed in each band, for its cost estimate */
+    is_push = cropping_op == PUSHCROP;
 
     if (cropping_op == PUSHCROP || cropping_op == SAMEAS_PUSHCROP_BUTNOPUSH) {
         first_band = ry / band_height;
@@ -1341,6 +1346,12 @@ clist_create_compositor(gx_device * dev,
 
     if (cropping_op == ALLBANDS) {
         /* overprint applies to all bands */
+        if (is_push) {
+            int band;
+
+            for (band = max(first_band, 0); band <= min(last_band, cdev->nbands - 1); band++)
+                cdev->states[band].color_usage.trans_groups++;
+        }
         size_dummy = size;
         code = set_cmd_put_all_op(& dp,
                                    (gx_device_clist_writer *)dev,
@@ -1380,6 +1391,8 @@ clist_create_compositor(gx_device * dev,
         RECT_ENUM_INIT(re, temp_cropping_min, temp_cropping_max - temp_cropping_min);
         do {
             RECT_STEP_INIT(re);
+            if (is_push)
+                re.pcls->color_usage.trans_groups++;
             code = set_cmd_put_op(&dp, cdev, re.pcls, cmd_opv_extend, size);
             if (code >= 0) {
                 size_dummy = size;
@@ -31,6 +31,16 @@
 
 typedef void *clist_file_ptr;	/* We can't do any better than this. */
 
+/*
+ * Define the ways the band list may be compressed.  Only the memory based
+ * band list compresses, and then only once it gets large.  The choice only
+ * matters when the file is created: readers use the writer's choice.
+ */
+typedef enum {
+    clist_compress_default = 0,	/* zlib or LZW, as chosen when building */
+    clist_compress_fast		/* byte oriented LZ, see sblzx.h */
+} clist_compress_t;
+
 struct clist_io_procs_s {
 
     /* ---------------- Open/close/unlink ---------------- */
@@ -39,12 +49,13 @@ struct clist_io_procs_s {
      * If *fname = 0, generate and store a new scratch file name; otherwise,
      * open an existing file.  Only modes "r" and "w+" are supported,
      * and only binary data (but the caller must append the "b" if needed).
-     * Mode "r" with *fname = 0 is an error.
+     * Mode "r" with *fname = 0 is an error.  compress selects the
+     * compression to use for a new file.
      */
     int (*fopen)(char fname[gp_file_name_sizeof], const char *fmode,
                     clist_file_ptr * pcf,
                     gs_memory_t * mem, gs_memory_t *data_mem,
-                    bool ok_to_compress);
+                    clist_compress_t compress);
 
     /*
      * Close a file, optionally deleting it.
@@ -21,6 +21,7 @@
 #include "gxpath.h"
 #include "gxcpath.h"
 #include "gzcpath.h"
+#include "gxdevsop.h"
 
 /* Define whether to look for vertical clipping regions. */
 #define CHECK_VERTICAL_CLIPPING
@@ -33,6 +34,7 @@
 static dev_proc_open_device(clip_open);
 static dev_proc_fill_rectangle(clip_fill_rectangle);
 static dev_proc_fill_rectangle_hl_color(clip_fill_rectangle_hl_color);
+static dev_proc_fill_linear_color_scanline(clip_fill_linear_color_scanline);
 static dev_proc_copy_mono(clip_copy_mono);
 static dev_proc_copy_planes(clip_copy_planes);
 static dev_proc_copy_color(clip_copy_color);
@@ -109,7 +111,7 @@ static const gx_device_clip gs_clip_device =
   NULL,
   clip_fill_rectangle_hl_color,
   gx_forward_include_color_space,
-  gx_default_fill_linear_color_scanline,
+  clip_fill_linear_color_scanline,
   gx_default_fill_linear_color_trapezoid,
   gx_default_fill_linear_color_triangle,
   gx_forward_update_spot_equivalent_colors,
@@ -852,6 +854,92 @@ clip_fill_rectangle_hl_color(gx_device *dev, const gs_fixed_rect *rect,
     return dev_proc(rdev, fill_rectangle_hl_color)(dev, rect, pgs, pdcolor, pcpath);
 }
 
+/* Fill a scanline of a smooth shading */
+static int
+clip_call_fill_linear_color_scanline(clip_callback_data_t * pccd,
+                                     int xc, int yc, int xec, int yec)
+{
+    const gs_fill_attributes *fa = pccd->fa;
+    gx_device *tdev = pccd->tdev;
+    frac31 c[GX_DEVICE_COLOR_MAX_COMPONENTS];
+    int32_t f[GX_DEVICE_COLOR_MAX_COMPONENTS];
+    int n = tdev->color_info.num_components;
+    int i = (fa->swap_axes ? yc : xc);
+    int ie = (fa->swap_axes ? yec : xec);
+    int j = (fa->swap_axes ? xc : yc);
+    int di = i - pccd->i0;
+    int k;
+
+    /*
+     * Advance the colors to the start of the rectangle the same way that
+     * gx_default_fill_linear_color_scanline does, so that the target sees
+     * exactly the colors it would have seen from the whole scanline.
+     */
+    for (k = 0; k < n; k++) {
+        c[k] = pccd->c0[k];
+        f[k] = pccd->c0f[k];
+        if (pccd->cg_num[k] && di > 0) {
+            int64_t M = f[k] + (int64_t)pccd->cg_num[k] * di;
+            int32_t m;
+
+            c[k] += (frac31)(M / pccd->cg_den);
+            m = (int32_t)(M - M / pccd->cg_den * pccd->cg_den);
+            if (m < 0) {
+                c[k]--;
+                m += pccd->cg_den;
+            }
+            f[k] = m;
+        }
+    }
+    return dev_proc(tdev, fill_linear_color_scanline)
+        (tdev, fa, i, j, ie - i, c, f, pccd->cg_num, pccd->cg_den);
+}
+/*
+ * The default would split the scanline into runs of one color and clip each
+ * of them, which loses the pdf14 device's own implementation.  For that
+ * target only, clip the scanline and pass each visible piece of it on.
+ * Other targets (forwarding and subclass devices among them) keep getting
+ * the runs as before.
+ */
+static int
+clip_fill_linear_color_scanline(gx_device *dev, const gs_fill_attributes *fa,
+        int i0, int j, int w, const frac31 *c0, const int32_t *c0f,
+        const int32_t *cg_num, int32_t cg_den)
+{
+    gx_device_clip *rdev = (gx_device_clip *) dev;
+    gx_device *tdev = rdev->target;
+    gx_device *p14dev = NULL;
+    clip_callback_data_t ccdata;
+    int i, ie;
+
+    /* gxdso_is_pdf14_device is forwarded, so check that it is the target
+       itself that answers. */
+    if (dev_proc(tdev, dev_spec_op)(tdev, gxdso_is_pdf14_device, &p14dev,
+                                    sizeof(p14dev)) <= 0 ||
+        p14dev != tdev ||
+        dev_proc(tdev, fill_linear_color_scanline) ==
+            gx_default_fill_linear_color_scanline ||
+        rdev->translation.x != 0 || rdev->translation.y != 0)
+        return gx_default_fill_linear_color_scanline(dev, fa, i0, j, w, c0,
+                                                     c0f, cg_num, cg_den);
+    if (j < fixed2int(fa->clip->p.y) ||
+            j > fixed2int_ceiling(fa->clip->q.y)) /* Must be compatible to the clipping logic. */
+        return 0;
+    i = max(i0, fixed2int(fa->clip->p.x));
+    ie = min(i0 + w, fixed2int_ceiling(fa->clip->q.x));
+    ccdata.fa = fa;
+    ccdata.i0 = i0;
+    ccdata.c0 = c0;
+    ccdata.c0f = c0f;
+    ccdata.cg_num = cg_num;
+    ccdata.cg_den = cg_den;
+    if (fa->swap_axes)
+        return clip_enumerate(rdev, j, i, 1, ie - i,
+                              clip_call_fill_linear_color_scanline, &ccdata);
+    return clip_enumerate(rdev, i, j, ie - i, 1,
+                          clip_call_fill_linear_color_scanline, &ccdata);
+}
+
 /* Copy a monochrome rectangle */
 int
 clip_call_copy_mono(clip_callback_data_t * pccd, int xc, int yc, int xec, int yec)
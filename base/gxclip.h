@@ -56,6 +56,11 @@ typedef struct clip_callback_data_s {
     gx_path *ppath;                     /* fill_path, fill_stroke_path */
     const gx_fill_params *params;       /* fill_path, fill_stroke_path */
     const gx_stroke_params *stroke_params; /* fill_stroke_path */
+    const gs_fill_attributes *fa;       /* fill_linear_color_scanline */
+    int i0;                             /* ibid. */
+    const frac31 *c0;                   /* ibid. */
+    const int32_t *c0f, *cg_num;        /* ibid. */
+    int32_t cg_den;                     /* ibid. */
 } clip_callback_data_t;
 
 /* Declare the callback procedures. */
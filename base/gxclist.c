@@ -645,10 +645,10 @@ clist_open_output_file(gx_device *dev)
     clist_reset_page(cdev);
     if ((code = cdev->page_info.io_procs->fopen(cdev->page_cfname, fmode, &cdev->page_cfile,
                             cdev->bandlist_memory, cdev->bandlist_memory,
-                            true)) < 0 ||
+                            cdev->compression)) < 0 ||
         (code = cdev->page_info.io_procs->fopen(cdev->page_bfname, fmode, &cdev->page_bfile,
                             cdev->bandlist_memory, cdev->bandlist_memory,
-                            false)) < 0
+                            cdev->compression)) < 0
         ) {
         clist_close_output_file(dev);
         cdev->permanent_error = code;
@@ -709,6 +709,7 @@ clist_open(gx_device *dev)
 
     cdev->icc_cache_list_len = 0;
     cdev->icc_cache_list = NULL;
+    cdev->idle_render_threads = NULL;
     code = clist_open_output_file(dev);
     if ( code >= 0)
         code = clist_emit_page_header(dev);
@@ -736,6 +737,7 @@ clist_close(gx_device *dev)
      * in *2* places, once in gdev_prn_tear_down() for regular clists, and once in
      * gx_pattern_cache_free_entry() for pattern clists....
      */
+    clist_teardown_render_threads(dev);	/* including those kept between pages */
     for(i = 0; i < cdev->icc_cache_list_len; i++) {
         rc_decrement(cdev->icc_cache_list[i], "clist_close");
     }
@@ -768,19 +770,19 @@ clist_finish_page(gx_device *dev, bool flush)
 
     /* If this is a reader clist, which is about to be reset to a writer,
      * free any color_usage array used by same.
-     * since we have been rendering, shut down threads
-     * Also free the icc_table at this time and the icc_cache
+     * since we have been rendering, stop the threads (they are kept for
+     * the next page). Also free the icc_table at this time and the icc_cache
      */
     if (!CLIST_IS_WRITER((gx_device_clist *)dev)) {
         gx_device_clist_reader * const crdev =  &((gx_device_clist *)dev)->reader;
 
-        clist_teardown_render_threads(dev);
+        clist_finish_render_threads(dev);
         gs_free_object(cdev->memory, crdev->color_usage_array, "clist_color_usage_array");
         crdev->color_usage_array = NULL;
 
        /* Free the icc table associated with this device.
-           The threads that may have pointed to this were destroyed in
-           the above call to clist_teardown_render_threads.  Since they
+           The threads that may have pointed to this were detached in
+           the above call to clist_finish_render_threads.  Since they
            all maintained a copy of the cache and the table there should not
            be any issues. */
         clist_free_icc_table(crdev->icc_table, crdev->memory);
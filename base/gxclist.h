@@ -169,6 +169,10 @@ typedef struct cmd_list_s {
  * and reading (second) phase.
  */
 typedef struct gx_clist_state_s gx_clist_state;
+typedef struct clist_render_thread_control_s clist_render_thread_control_t;
+typedef struct clist_band_sched_s clist_band_sched_t;
+typedef struct clist_profile_s clist_profile_t;
+typedef struct clist_band_profile_s clist_band_profile_t;
 
 #define gx_device_clist_common_members\
         gx_device_forward_common;	/* (see gxdevice.h) */\
@@ -202,7 +206,11 @@ typedef struct gx_clist_state_s gx_clist_state;
                                            file location. */\
         gsicc_link_cache_t *icc_cache_cl; /* Link cache */\
         int icc_cache_list_len;         /* Length of list of caches, one per rendering thread */\
-        gsicc_link_cache_t **icc_cache_list  /* Link cache list */
+        gsicc_link_cache_t **icc_cache_list;  /* Link cache list */\
+        clist_render_thread_control_t *idle_render_threads; /* rendering threads kept between pages */\
+        int render_threads_requested;	/* set by clist_enable_multi_thread_render */\
+        clist_compress_t compression;	/* for the band list in memory */\
+        clist_profile_t *profile	/* band rendering profile, see gxclprof.h */
 
 /* Define a structure to hold where the ICC profiles are stored in the clist
    Profiles are added into psuedo bands of the clist, these are bands that exist beyond
@@ -331,6 +339,8 @@ struct gx_device_clist_writer_s {
     int pdf14_trans_group_level;/* 0 when at page level group -- push increments, pop decrements */
     int pdf14_smask_level;	/* 0 when at SMask None -- push increments, pop decrements */
     bool page_pdf14_needed;	/* save page level pdf14_needed state */
+    bool pdf14_page_group_trivial; /* the open page group doesn't change opaque */
+                                /* marks, so level 1 counts as page level */
 
     float dash_pattern[cmd_max_dash];	/* current dash pattern */
     const gx_clip_path *clip_path;	/* current clip path, */
@@ -379,7 +389,6 @@ struct gx_device_clist_writer_s {
 #define clist_disable_pass_thru_params (1 << 5)	/* disable EXCEPT at top of page */
 #define clist_disable_copy_alpha (1 << 6) /* target does not support copy_alpha */
 
-typedef struct clist_render_thread_control_s clist_render_thread_control_t;
 
 /* Define the state of a band list when reading. */
 /* For normal rasterizing, pages and num_pages are both 0. */
@@ -394,9 +403,8 @@ typedef struct gx_device_clist_reader_s {
     int num_render_threads;		/* number of threads being used */
     clist_render_thread_control_t *render_threads;	/* array of threads */
     byte *main_thread_data;		/* saved data pointer of main thread */
-    int curr_render_thread;		/* index into array */
+    clist_band_sched_t *band_sched;	/* band scheduler shared by the threads */
     int thread_lookahead_direction;	/* +1 or -1 */
-    int next_band;			/* may be < 0 or >= num bands when no more remain to render */
 
 } gx_device_clist_reader;
 
@@ -539,9 +547,18 @@ int clist_rasterize_lines(gx_device *dev, int y, int lineCount,
                                   const gx_render_plane_t *render_plane,
                                   int *pmy);
 
-/* Enable multi threaded rendering. Returns > 0 if supported, < 0 if single threaded */
+/* Enable multi threaded rendering of the bands by get_bits_rectangle and */
+/* process_page, using up to num_threads threads (none if < 1). A device  */
+/* opts in by calling this once it is a clist device, and again when the  */
+/* number of threads changes. process_page still delivers the bands to    */
+/* the output_fn one at a time, in order.                                 */
+/* Returns > 0 if supported, < 0 if single threaded                       */
 int
-clist_enable_multi_thread_render(gx_device *dev);
+clist_enable_multi_thread_render(gx_device *dev, int num_threads);
+
+/* Stop the render threads at the end of a page, keeping them for the next */
+void
+clist_finish_render_threads(gx_device *dev);
 
 /* Shutdown render threads and free up the related memory */
 void
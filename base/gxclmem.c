@@ -18,8 +18,10 @@
 #include "memory_.h"
 #include "gx.h"
 #include "gserrors.h"
+#include "gp.h"
 #include "gxclmem.h"
 #include "gssprintf.h"
+#include "sblzx.h"
 
 #include "valgrind.h"
 
@@ -169,6 +171,7 @@ static int memfile_init_empty(MEMFILE * f);
 static int memfile_set_memory_warning(clist_file_ptr cf, int bytes_left);
 static int memfile_fclose(clist_file_ptr cf, const char *fname, bool delete);
 static int memfile_get_pdata(MEMFILE * f);
+static void memfile_report_stats(MEMFILE * f);
 
 /************************************************/
 /*   #define DEBUG      /- force statistics -/  */
@@ -233,12 +236,180 @@ allocateWithReserve(
     return block;
 }
 
+/* ---------------- Compression ---------------- */
+
+/* Return the prototype filter states for compressing and decompressing */
+/* a file, according to the compression chosen when it was created. */
+static const stream_template *
+memfile_compressor_template(const MEMFILE * f)
+{
+    if (f->compress == clist_compress_fast)
+        return &s_BLZE_template;
+    return clist_compressor_template();
+}
+static const stream_template *
+memfile_decompressor_template(const MEMFILE * f)
+{
+    if (f->compress == clist_compress_fast)
+        return &s_BLZD_template;
+    return clist_decompressor_template();
+}
+static void
+memfile_compressor_init(const MEMFILE * f, stream_state *state)
+{
+    if (f->compress == clist_compress_fast)
+        state->templat = &s_BLZE_template;
+    else
+        clist_compressor_init(state);
+}
+static void
+memfile_decompressor_init(const MEMFILE * f, stream_state *state)
+{
+    if (f->compress == clist_compress_fast)
+        state->templat = &s_BLZD_template;
+    else
+        clist_decompressor_init(state);
+}
+
+/* Return the elapsed time since t0 in microseconds. */
+static int64_t
+memfile_usec_since(const long t0[2])
+{
+    long t1[2];
+
+    gp_get_realtime(t1);
+    return (int64_t)(t1[0] - t0[0]) * 1000000 + (t1[1] - t0[1]) / 1000;
+}
+
+/* ---------------- Shared block cache ---------------- */
+
+/* Allocate the cache of decompressed blocks shared by the readers of f. */
+/* If there isn't enough memory, the readers simply don't share. */
+static void
+memfile_shared_cache_alloc(MEMFILE * f)
+{
+    MEMFILE_SHARED_CACHE *cache;
+    int i, count = GET_NUM_RAW_BUFFERS(f);
+
+    cache = (MEMFILE_SHARED_CACHE *)MALLOC(f, sizeof(*cache), "memfile shared cache");
+    if (cache == NULL)
+        return;
+    memset(cache, 0, sizeof(*cache));
+    cache->lock = gx_monitor_label(gx_monitor_alloc(f->data_memory),
+                                   "memfile shared cache");
+    cache->blocks = (MEMFILE_SHARED_BLK *)MALLOC(f, count * sizeof(MEMFILE_SHARED_BLK),
+                                                 "memfile shared cache blocks");
+    if (cache->lock == NULL || cache->blocks == NULL) {
+        gx_monitor_free(cache->lock);
+        gs_free_object(f->data_memory, cache->blocks, "memfile shared cache blocks");
+        gs_free_object(f->data_memory, cache, "memfile shared cache");
+        return;
+    }
+    for (i = 0; i < count; i++) {
+        MEMFILE_SHARED_BLK *blk = &cache->blocks[i];
+
+        blk->key = NULL;
+        blk->refs = 0;
+        blk->used = 0;
+        blk->data = MALLOC(f, MEMFILE_DATA_SIZE, "memfile shared cache data");
+        if (blk->data == NULL)
+            break;
+    }
+    cache->count = i;
+    f->shared_cache = cache;
+}
+
+static void
+memfile_shared_cache_free(MEMFILE * f)
+{
+    MEMFILE_SHARED_CACHE *cache = f->shared_cache;
+    int i;
+
+    if (cache == NULL)
+        return;
+    for (i = 0; i < cache->count; i++)
+        gs_free_object(f->data_memory, cache->blocks[i].data,
+                       "memfile shared cache data");
+    gs_free_object(f->data_memory, cache->blocks, "memfile shared cache blocks");
+    gx_monitor_free(cache->lock);
+    gs_free_object(f->data_memory, cache, "memfile shared cache");
+    f->shared_cache = NULL;
+}
+
+/* Copy the block whose compressed data starts at key into data. */
+/* Return true if it was in the cache. */
+static bool
+memfile_shared_get(MEMFILE_SHARED_CACHE *cache, const char *key, char *data)
+{
+    MEMFILE_SHARED_BLK *blk = NULL;
+    int i;
+
+    gx_monitor_enter(cache->lock);
+    for (i = 0; i < cache->count; i++)
+        if (cache->blocks[i].key == key) {
+            blk = &cache->blocks[i];
+            blk->refs++;
+            blk->used = ++cache->tick;
+            break;
+        }
+    if (blk == NULL)
+        cache->misses++;
+    else
+        cache->hits++;
+    gx_monitor_leave(cache->lock);
+    if (blk == NULL)
+        return false;
+    memcpy(data, blk->data, MEMFILE_DATA_SIZE);
+    gx_monitor_enter(cache->lock);
+    blk->refs--;
+    gx_monitor_leave(cache->lock);
+    return true;
+}
+
+/* Add a block that has just been decompressed to the cache, replacing */
+/* the least recently used one that nobody is copying. */
+static void
+memfile_shared_put(MEMFILE_SHARED_CACHE *cache, const char *key, const char *data)
+{
+    MEMFILE_SHARED_BLK *blk = NULL;
+    int i;
+
+    gx_monitor_enter(cache->lock);
+    for (i = 0; i < cache->count; i++) {
+        MEMFILE_SHARED_BLK *b = &cache->blocks[i];
+
+        if (b->key == key) {
+            /* Another reader got here first. */
+            gx_monitor_leave(cache->lock);
+            return;
+        }
+        if (b->refs == 0 && (blk == NULL || b->used < blk->used))
+            blk = b;
+    }
+    if (blk != NULL) {
+        if (blk->key != NULL)
+            cache->evictions++;
+        /* Take the entry out of the cache while we fill it. */
+        blk->key = NULL;
+        blk->refs = 1;
+    }
+    gx_monitor_leave(cache->lock);
+    if (blk == NULL)
+        return;
+    memcpy(blk->data, data, MEMFILE_DATA_SIZE);
+    gx_monitor_enter(cache->lock);
+    blk->key = key;
+    blk->refs = 0;
+    blk->used = ++cache->tick;
+    gx_monitor_leave(cache->lock);
+}
+
 /* ---------------- Open/close/unlink ---------------- */
 
 static int
 memfile_fopen(char fname[gp_file_name_sizeof], const char *fmode,
               clist_file_ptr /*MEMFILE * */  * pf,
-              gs_memory_t *mem, gs_memory_t *data_mem, bool ok_to_compress)
+              gs_memory_t *mem, gs_memory_t *data_mem, clist_compress_t compress)
 {
     MEMFILE *f = NULL;
     int code = 0;
@@ -265,9 +436,16 @@ memfile_fopen(char fname[gp_file_name_sizeof], const char *fmode,
         } else {
             /* We need to 'clone' this memfile so that each reader instance     */
             /* will be able to maintain it's own 'state'                        */
+            /* If the file is compressed, the readers share the blocks they     */
+            /* decompress. Readers may be opened from several threads, so the   */
+            /* cache is set up and the clone linked in under the base's lock.   */
+            gx_monitor_enter(base_f->open_lock);
+            if (base_f->shared_cache == NULL && base_f->log_head->phys_blk->data_limit != NULL)
+                memfile_shared_cache_alloc(base_f);
             f = gs_alloc_struct(mem, MEMFILE, &st_MEMFILE,
                                 "memfile_fopen_instance(MEMFILE)");
             if (f == NULL) {
+                gx_monitor_leave(base_f->open_lock);
                 emprintf1(mem,
                           "memfile_open_scratch(%s): gs_alloc_struct failed\n",
                           fname);
@@ -279,12 +457,17 @@ memfile_fopen(char fname[gp_file_name_sizeof], const char *fmode,
             f->data_memory = data_mem;
             f->compress_state = 0;              /* Not used by reader instance */
             f->decompress_state = 0;    /* make clean for GC, or alloc'n failure */
+            f->compressor_initialized = false;
+            f->decompressor_initialized = false;
+            f->decompress_blocks = 0;
+            f->decompress_usec = 0;
             f->reservePhysBlockChain = NULL;
             f->reservePhysBlockCount = 0;
             f->reserveLogBlockChain = NULL;
             f->reserveLogBlockCount = 0;
             f->openlist = base_f->openlist;
             base_f->openlist = f;               /* link this one in to the base memfile */
+            gx_monitor_leave(base_f->open_lock);
             f->base_memfile = base_f;
             f->log_curr_pos = 0;
             f->raw_head = NULL;
@@ -297,7 +480,7 @@ memfile_fopen(char fname[gp_file_name_sizeof], const char *fmode,
                 LOG_MEMFILE_BLK *log_block, *new_log_block;
                 int i;
                 int num_log_blocks = (f->log_length + MEMFILE_DATA_SIZE - 1) / MEMFILE_DATA_SIZE;
-                const stream_template *decompress_template = clist_decompressor_template();
+                const stream_template *decompress_template = memfile_decompressor_template(f);
 
                 new_log_block = MALLOC(f, num_log_blocks * sizeof(LOG_MEMFILE_BLK), "memfile_fopen" );
                 if (new_log_block == NULL) {
@@ -325,7 +508,7 @@ memfile_fopen(char fname[gp_file_name_sizeof], const char *fmode,
                     code = gs_note_error(gs_error_VMerror);
                     goto finish;
                 }
-                clist_decompressor_init(f->decompress_state);
+                memfile_decompressor_init(f, f->decompress_state);
                 f->decompress_state->memory = mem;
                 if (decompress_template->set_defaults)
                     (*decompress_template->set_defaults) (f->decompress_state);
@@ -353,14 +536,24 @@ memfile_fopen(char fname[gp_file_name_sizeof], const char *fmode,
     f->decompress_state = 0;
     f->openlist = NULL;
     f->base_memfile = NULL;
+    f->open_lock = NULL;
     f->total_space = 0;
     f->reservePhysBlockChain = NULL;
     f->reservePhysBlockCount = 0;
     f->reserveLogBlockChain = NULL;
     f->reserveLogBlockCount = 0;
+    f->compress = compress;
+    f->shared_cache = NULL;
+    f->compress_blocks = f->compress_bytes = f->compress_usec = 0;
+    f->decompress_blocks = f->decompress_usec = 0;
     /* init an empty file           */
     if ((code = memfile_init_empty(f)) < 0)
         goto finish;
+    f->open_lock = gx_monitor_label(gx_monitor_alloc(data_mem), "memfile open");
+    if (f->open_lock == NULL) {
+        code = gs_note_error(gs_error_VMerror);
+        goto finish;
+    }
     if ((code = memfile_set_memory_warning(f, 0)) < 0)
         goto finish;
     /*
@@ -371,8 +564,8 @@ memfile_fopen(char fname[gp_file_name_sizeof], const char *fmode,
     f->compress_state = 0;      /* make clean for GC */
     f->decompress_state = 0;
     if (f->ok_to_compress) {
-        const stream_template *compress_template = clist_compressor_template();
-        const stream_template *decompress_template = clist_decompressor_template();
+        const stream_template *compress_template = memfile_compressor_template(f);
+        const stream_template *decompress_template = memfile_decompressor_template(f);
 
         f->compress_state =
             gs_alloc_struct(mem, stream_state, compress_template->stype,
@@ -387,8 +580,8 @@ memfile_fopen(char fname[gp_file_name_sizeof], const char *fmode,
             code = gs_note_error(gs_error_VMerror);
             goto finish;
         }
-        clist_compressor_init(f->compress_state);
-        clist_decompressor_init(f->decompress_state);
+        memfile_compressor_init(f, f->compress_state);
+        memfile_decompressor_init(f, f->decompress_state);
         f->compress_state->memory = mem;
         f->decompress_state->memory = mem;
         if (compress_template->set_defaults)
@@ -439,38 +632,36 @@ memfile_fclose(clist_file_ptr cf, const char *fname, bool delete)
             /* Here we need to delete this instance from the 'openlist' */
             /* in case this file was opened for 'read' on a previously  */
             /* written file (base_memfile != NULL)                          */
+            gx_monitor_enter(f->base_memfile->open_lock);
             for (prev_f = f->base_memfile; prev_f != NULL; prev_f = prev_f->openlist)
                 if (prev_f->openlist == f)
                     break;
+            if (prev_f != NULL)
+                prev_f->openlist = f->openlist;     /* link around the one being fclosed */
+            gx_monitor_leave(f->base_memfile->open_lock);
             if (prev_f == NULL) {
                 emprintf1(f->memory,
                           "Could not find %p on memfile openlist\n",
                           f);
                 return_error(gs_error_invalidfileaccess);
             }
-            prev_f->openlist = f->openlist;     /* link around the one being fclosed */
             /* Now delete this MEMFILE reader instance */
             /* NB: we don't delete 'base' instances until we delete */
             /* If the file is compressed, free the logical blocks, but not */
             /* the phys_blk info (that is still used by the base memfile   */
             if (f->log_head->phys_blk->data_limit != NULL) {
-                LOG_MEMFILE_BLK *tmpbp, *bp = f->log_head;
-
-                while (bp != NULL) {
-                    tmpbp = bp->link;
-                    FREE(f, bp, "memfile_free_mem(log_blk)");
-                    bp = tmpbp;
-                }
+                /* The logical blocks were copied into a single array. */
+                gs_free_object(f->data_memory, f->log_head, "memfile_fclose(log_blk)");
                 f->log_head = NULL;
 
-                /* Free any internal compressor state. */
-                if (f->compressor_initialized) {
+                /* Free any internal decompressor state; a reader */
+                /* instance has no compressor.                   */
+                if (f->decompressor_initialized) {
                     if (f->decompress_state->templat->release != 0)
                         (*f->decompress_state->templat->release) (f->decompress_state);
-                    if (f->compress_state->templat->release != 0)
-                        (*f->compress_state->templat->release) (f->compress_state);
-                    f->compressor_initialized = false;
+                    f->decompressor_initialized = false;
                 }
+                memfile_report_stats(f);
                 /* free the raw buffers                                           */
                 while (f->raw_head != NULL) {
                     RAW_BUFFER *tmpraw = f->raw_head->fwd;
@@ -478,6 +669,8 @@ memfile_fclose(clist_file_ptr cf, const char *fname, bool delete)
                     FREE(f, f->raw_head, "memfile_free_mem(raw)");
                     f->raw_head = tmpraw;
                 }
+                gs_free_object(f->memory, f->decompress_state,
+                               "memfile_fclose(decompress_state)");
             }
             /* deallocate the memfile object proper */
             gs_free_object(f->memory, f, "memfile_close_and_unlink(MEMFILE)");
@@ -518,6 +711,8 @@ memfile_fclose(clist_file_ptr cf, const char *fname, bool delete)
                        "memfile_close_and_unlink(decompress_state)");
         gs_free_object(f->memory, f->compress_state,
                        "memfile_close_and_unlink(compress_state)");
+        if (f->base_memfile == NULL)
+            gx_monitor_free(f->open_lock);
 
         /* deallocate the memfile object proper */
         gs_free_object(f->memory, f, "memfile_close_and_unlink(MEMFILE)");
@@ -615,7 +810,10 @@ compress_log_blk(MEMFILE * f, LOG_MEMFILE_BLK * bp)
     long compressed_size;
     byte *start_ptr;
     PHYS_MEMFILE_BLK *newphys;
+    long t0[2];
 
+    if (gs_debug[':'])
+        gp_get_realtime(t0);
     /* compress this block */
     f->rd.ptr = (const byte *)(bp->phys_blk->data) - 1;
     f->rd.limit = f->rd.ptr + MEMFILE_DATA_SIZE;
@@ -672,6 +870,10 @@ compress_log_blk(MEMFILE * f, LOG_MEMFILE_BLK * bp)
 #ifdef DEBUG
     tot_compressed += compressed_size;
 #endif
+    f->compress_blocks++;
+    f->compress_bytes += compressed_size;
+    if (gs_debug[':'])
+        f->compress_usec += memfile_usec_since(t0);
     return (status < 0 ? gs_note_error(gs_error_ioerror) : ecode);
 }                               /* end "compress_log_blk()"                                     */
 
@@ -843,6 +1045,7 @@ memfile_get_pdata(MEMFILE * f)
 {
     int code, i, num_raw_buffers, status;
     LOG_MEMFILE_BLK *bp = f->log_curr_blk;
+    long t0[2];
 
     if (bp->phys_blk->data_limit == NULL) {
         /* Not compressed, return this data pointer                       */
@@ -900,6 +1103,7 @@ memfile_get_pdata(MEMFILE * f)
                     (f->decompress_state);
             if (code < 0)
                 return_error(gs_error_VMerror);
+            f->decompressor_initialized = true;
 
         }                       /* end allocating the raw buffer pool (first time only)           */
         if (bp->raw_block == NULL) {
@@ -925,47 +1129,58 @@ memfile_get_pdata(MEMFILE * f)
             f->raw_head->log_blk = bp;
 
             /* Decompress the data into this raw block                     */
-            /* Initialize the decompressor                              */
-            if (f->decompress_state->templat->reinit != 0)
-                (*f->decompress_state->templat->reinit) (f->decompress_state);
-            /* Set pointers and call the decompress routine             */
-            f->wt.ptr = (byte *) (f->raw_head->data) - 1;
-            f->wt.limit = f->wt.ptr + MEMFILE_DATA_SIZE;
-            f->rd.ptr = (const byte *)(bp->phys_pdata) - 1;
-            f->rd.limit = (const byte *)bp->phys_blk->data_limit;
-#ifdef DEBUG
-            decomp_wt_ptr0 = f->wt.ptr;
-            decomp_wt_limit0 = f->wt.limit;
-            decomp_rd_ptr0 = f->rd.ptr;
-            decomp_rd_limit0 = f->rd.limit;
-#endif
-            status = (*f->decompress_state->templat->process)
-                (f->decompress_state, &(f->rd), &(f->wt), true);
-            if (status == 0) {  /* More input data needed */
-                /* switch to next block and continue decompress             */
-                int back_up = 0;        /* adjust pointer backwards     */
-
-                if (f->rd.ptr != f->rd.limit) {
-                    /* transfer remainder bytes from the previous block      */
-                    back_up = f->rd.limit - f->rd.ptr;
-                    for (i = 0; i < back_up; i++)
-                        *(bp->phys_blk->link->data - back_up + i) = *++f->rd.ptr;
-                }
-                f->rd.ptr = (const byte *)bp->phys_blk->link->data - back_up - 1;
-                f->rd.limit = (const byte *)bp->phys_blk->link->data_limit;
+            /* Unless another reader has already decompressed this block */
+            if (f->shared_cache == NULL ||
+                !memfile_shared_get(f->shared_cache, bp->phys_pdata, f->raw_head->data)) {
+                if (gs_debug[':'])
+                    gp_get_realtime(t0);
+                /* Initialize the decompressor                              */
+                if (f->decompress_state->templat->reinit != 0)
+                    (*f->decompress_state->templat->reinit) (f->decompress_state);
+                /* Set pointers and call the decompress routine             */
+                f->wt.ptr = (byte *) (f->raw_head->data) - 1;
+                f->wt.limit = f->wt.ptr + MEMFILE_DATA_SIZE;
+                f->rd.ptr = (const byte *)(bp->phys_pdata) - 1;
+                f->rd.limit = (const byte *)bp->phys_blk->data_limit;
 #ifdef DEBUG
-                decomp_wt_ptr1 = f->wt.ptr;
-                decomp_wt_limit1 = f->wt.limit;
-                decomp_rd_ptr1 = f->rd.ptr;
-                decomp_rd_limit1 = f->rd.limit;
+                decomp_wt_ptr0 = f->wt.ptr;
+                decomp_wt_limit0 = f->wt.limit;
+                decomp_rd_ptr0 = f->rd.ptr;
+                decomp_rd_limit0 = f->rd.limit;
 #endif
                 status = (*f->decompress_state->templat->process)
                     (f->decompress_state, &(f->rd), &(f->wt), true);
-                if (status == 0) {
-                    emprintf(f->memory,
-                             "Decompression required more than one full block!\n");
-                    return_error(gs_error_Fatal);
+                if (status == 0) {  /* More input data needed */
+                    /* switch to next block and continue decompress             */
+                    int back_up = 0;        /* adjust pointer backwards     */
+
+                    if (f->rd.ptr != f->rd.limit) {
+                        /* transfer remainder bytes from the previous block      */
+                        back_up = f->rd.limit - f->rd.ptr;
+                        for (i = 0; i < back_up; i++)
+                            *(bp->phys_blk->link->data - back_up + i) = *++f->rd.ptr;
+                    }
+                    f->rd.ptr = (const byte *)bp->phys_blk->link->data - back_up - 1;
+                    f->rd.limit = (const byte *)bp->phys_blk->link->data_limit;
+#ifdef DEBUG
+                    decomp_wt_ptr1 = f->wt.ptr;
+                    decomp_wt_limit1 = f->wt.limit;
+                    decomp_rd_ptr1 = f->rd.ptr;
+                    decomp_rd_limit1 = f->rd.limit;
+#endif
+                    status = (*f->decompress_state->templat->process)
+                        (f->decompress_state, &(f->rd), &(f->wt), true);
+                    if (status == 0) {
+                        emprintf(f->memory,
+                                 "Decompression required more than one full block!\n");
+                        return_error(gs_error_Fatal);
+                    }
                 }
+                if (gs_debug[':'])
+                    f->decompress_usec += memfile_usec_since(t0);
+                f->decompress_blocks++;
+                if (f->shared_cache != NULL)
+                    memfile_shared_put(f->shared_cache, bp->phys_pdata, f->raw_head->data);
             }
             bp->raw_block = f->raw_head;        /* point to raw block           */
         }
@@ -1120,6 +1335,36 @@ memfile_fseek(clist_file_ptr cf, int64_t offset, int mode, const char *ignore_fn
 
 /* ---------------- Internal routines ---------------- */
 
+/* Report and reset the compression and cache statistics of a file (-Z:). */
+static void
+memfile_report_stats(MEMFILE * f)
+{
+    if (gs_debug[':'] && f->base_memfile == NULL && f->compress_blocks != 0) {
+        int64_t raw = f->compress_blocks * MEMFILE_DATA_SIZE;
+
+        dmprintf6(f->memory,
+                  "%% Band list %s: compressed %"PRId64" blocks, %"PRId64" to %"PRId64" bytes (%d%%) in %"PRId64" usec\n",
+                  (f->compress == clist_compress_fast ? "fast" : "default"),
+                  f->compress_blocks, raw, f->compress_bytes,
+                  (int)(f->compress_bytes * 100 / raw), f->compress_usec);
+    }
+    if (gs_debug[':'] && f->decompress_blocks != 0)
+        dmprintf3(f->memory,
+                  "%% Band list reader %p: decompressed %"PRId64" blocks in %"PRId64" usec\n",
+                  (void *)f, f->decompress_blocks, f->decompress_usec);
+    if (f->base_memfile == NULL && f->shared_cache != NULL) {
+        MEMFILE_SHARED_CACHE *cache = f->shared_cache;
+
+        if (gs_debug[':'])
+            dmprintf4(f->memory,
+                      "%% Band list shared cache: %d blocks, %"PRId64" hits, %"PRId64" misses, %"PRId64" evictions\n",
+                      cache->count, cache->hits, cache->misses, cache->evictions);
+        cache->hits = cache->misses = cache->evictions = 0;
+    }
+    f->compress_blocks = f->compress_bytes = f->compress_usec = 0;
+    f->decompress_blocks = f->decompress_usec = 0;
+}
+
 static void
 memfile_free_mem(MEMFILE * f)
 {
@@ -1185,13 +1430,19 @@ memfile_free_mem(MEMFILE * f)
     f->log_head = NULL;
 
     /* Free any internal compressor state. */
-    if (f->compressor_initialized) {
+    if (f->decompressor_initialized) {
         if (f->decompress_state->templat->release != 0)
             (*f->decompress_state->templat->release) (f->decompress_state);
+        f->decompressor_initialized = false;
+    }
+    if (f->compressor_initialized) {
         if (f->compress_state->templat->release != 0)
             (*f->compress_state->templat->release) (f->compress_state);
         f->compressor_initialized = false;
     }
+    memfile_report_stats(f);
+    if (f->base_memfile == NULL)
+        memfile_shared_cache_free(f);
     /* free the raw buffers                                           */
     while (f->raw_head != NULL) {
         RAW_BUFFER *tmpraw = f->raw_head->fwd;
@@ -1215,6 +1466,7 @@ memfile_init_empty(MEMFILE * f)
     f->log_length = 0;
     f->raw_head = NULL;
     f->compressor_initialized = false;
+    f->decompressor_initialized = false;
     f->total_space = 0;
 
     /* File empty - get a physical mem block (includes the buffer area)  */
@@ -21,6 +21,7 @@
 
 #include "gxclio.h"		/* defines interface */
 #include "strimpl.h"		/* stream structures      */
+#include "gxsync.h"
 
 /*
  * The best values of MEMFILE_DATA_SIZE are slightly less than a power of 2,
@@ -56,6 +57,30 @@ typedef struct PHYS_MEMFILE_BLK {
     char data[MEMFILE_DATA_SIZE];
 } PHYS_MEMFILE_BLK;
 
+/*
+ * When several threads read the same compressed file, they share a cache
+ * of decompressed blocks as well as keeping their own raw buffers, so that
+ * blocks that all of them need (such as those of the page level pseudo
+ * band) are only decompressed once.  The cache belongs to the file that
+ * was written and is keyed by the start of the compressed data.  Entries
+ * are copied in and out with the lock released, holding a reference that
+ * keeps the entry from being reused meanwhile.
+ */
+typedef struct MEMFILE_SHARED_BLK {
+    const char *key;		/* phys_pdata of the block, NULL if none */
+    int refs;			/* readers copying in or out */
+    int64_t used;		/* tick of the last use, for LRU */
+    char *data;
+} MEMFILE_SHARED_BLK;
+
+typedef struct MEMFILE_SHARED_CACHE {
+    gx_monitor_t *lock;
+    int count;
+    MEMFILE_SHARED_BLK *blocks;
+    int64_t tick;
+    int64_t hits, misses, evictions;	/* reported with -Z: */
+} MEMFILE_SHARED_CACHE;
+
 typedef struct LOG_MEMFILE_BLK {
     struct LOG_MEMFILE_BLK *link;
     PHYS_MEMFILE_BLK *phys_blk;
@@ -67,6 +92,7 @@ struct MEMFILE_s {
     gs_memory_t *memory;	/* storage allocator */
     gs_memory_t *data_memory;	/* storage allocator for data */
     bool ok_to_compress;	/* if true, OK to compress this file */
+    clist_compress_t compress;	/* how to compress it */
     bool is_open;		/* track open/closed for each access struct */
         /*
          * We need to maintain a linked list of other structs that
@@ -83,6 +109,7 @@ struct MEMFILE_s {
          */
     struct MEMFILE_s *openlist;
     struct MEMFILE_s *base_memfile;	/* reader instances set this to the file that was written */
+    gx_monitor_t *open_lock;	/* of the base memfile: protects openlist and shared_cache */
         /*
          * Reserve memory blocks: these are used to guarantee that a
          * given-sized write (or sequence of writes) will always succeed.
@@ -118,8 +145,20 @@ struct MEMFILE_s {
     stream_cursor_read rd;	/* use .ptr, .limit */			/******* READER INSTANCE *******/
     stream_cursor_write wt;	/* use .ptr, .limit */			/******* READER INSTANCE *******/
     bool compressor_initialized;
+    bool decompressor_initialized;					/******* READER INSTANCE *******/
     stream_state *compress_state;
     stream_state *decompress_state;					/******* READER INSTANCE *******/
+    MEMFILE_SHARED_CACHE *shared_cache;	/* of the base memfile, or NULL */
+        /*
+         * Compression statistics, reported when the file is freed if -Z:
+         * is set.  Times are only measured with -Z: too.  Every compressed
+         * block holds MEMFILE_DATA_SIZE bytes of data.
+         */
+    int64_t compress_blocks;	/* blocks compressed by the writer */
+    int64_t compress_bytes;	/* size of the compressed blocks */
+    int64_t compress_usec;	/* time spent compressing */
+    int64_t decompress_blocks;	/* blocks decompressed */		/******* READER INSTANCE *******/
+    int64_t decompress_usec;	/* time spent decompressing */		/******* READER INSTANCE *******/
 };
 typedef struct MEMFILE_s MEMFILE;
 
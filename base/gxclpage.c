@@ -455,6 +455,7 @@ do_page_load(gx_device_printer *pdev, gx_saved_page *page, clist_file_ptr *save_
     crdev->num_pages = 1;		/* single page at a time */
     crdev->offset_map = NULL;
     crdev->render_threads = NULL;
+    crdev->band_sched = NULL;
     crdev->ymin = crdev->ymax = 0;      /* invalidate buffer contents to force rasterizing */
 
     /* We probably don't need to copy in the filenames, but do it in case something expects it */
@@ -482,11 +483,11 @@ gx_saved_page_load(gx_device_printer *pdev, gx_saved_page *page)
     /* Now open this page's files */
     code = crdev->page_info.io_procs->fopen(crdev->page_info.cfname,
                gp_fmode_rb, &(crdev->page_info.cfile), crdev->bandlist_memory,
-               crdev->bandlist_memory, true);
+               crdev->bandlist_memory, clist_compress_default);
     if (code >= 0) {
         code = crdev->page_info.io_procs->fopen(crdev->page_info.bfname,
                    gp_fmode_rb, &(crdev->page_info.bfile), crdev->bandlist_memory,
-                   crdev->bandlist_memory, false);
+                   crdev->bandlist_memory, clist_compress_default);
     }
 
     return code;
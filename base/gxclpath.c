@@ -41,11 +41,32 @@
 ulong stats_cmd_diffs[5];
 #endif
 
+/*
+ * Y bounds of the subpaths of a path that is written into several bands.
+ * cmd_put_path uses these to pass over a subpath lying entirely above or
+ * below the band without enumerating its segments once more for every
+ * band the path touches.
+ */
+typedef struct cmd_subpath_bounds_s {
+    const subpath *psub;
+    fixed ymin, ymax;		/* including curve control points */
+} cmd_subpath_bounds;
+typedef struct cmd_path_bounds_s {
+    int count;			/* 0 if not computed */
+    cmd_subpath_bounds *subpaths;
+} cmd_path_bounds;
+
 /* Forward declarations */
 static int cmd_put_path(gx_device_clist_writer * cldev,
                          gx_clist_state * pcls, const gx_path * ppath,
                          fixed ymin, fixed ymax, byte op,
-                         bool implicit_close, segment_notes keep_notes);
+                         bool implicit_close, segment_notes keep_notes,
+                         const cmd_path_bounds * pbounds);
+static void cmd_path_bounds_init(gx_device_clist_writer * cldev,
+                                 cmd_path_bounds * pbounds,
+                                 const gx_path * ppath, int nbands);
+static void cmd_path_bounds_release(gx_device_clist_writer * cldev,
+                                    cmd_path_bounds * pbounds);
 
 /* ------ Utilities ------ */
 
@@ -620,7 +641,7 @@ cmd_write_unknown(gx_device_clist_writer * cldev, gx_clist_state * pcls,
                                     int2fixed(ymax + 1),
                                     (byte)(pcpath->rule == gx_rule_even_odd ?
                                      cmd_opv_eofill : cmd_opv_fill),
-                                    true, sn_not_first);
+                                    true, sn_not_first, NULL);
             } else {
                   /* Complex paths disabled: write outer box as clip */
                   punt_to_outer_box = true;
@@ -745,6 +766,7 @@ clist_fill_path(gx_device * dev, const gs_gstate * pgs, gx_path * ppath,
     gs_fixed_point adjust;
     bool slow_rop = cmd_slow_rop(dev, lop_know_S_0(lop), pdcolor);
     cmd_rects_enum_t re;
+    cmd_path_bounds bounds;
     int code;
 
     adjust = params->adjust;
@@ -846,21 +868,23 @@ clist_fill_path(gx_device * dev, const gs_gstate * pgs, gx_path * ppath,
         }
 
         RECT_ENUM_INIT(re, ry, rheight);
+        cmd_path_bounds_init(cdev, &bounds, ppath, re.rect_nbands);
         do {
             RECT_STEP_INIT(re);
             code = cmd_do_write_unknown(cdev, re.pcls, FILL_KNOWN);
             if (code < 0)
-                return code;
+                break;
             if ((code = cmd_do_enable_clip(cdev, re.pcls, pcpath != NULL)) < 0 ||
                 (code = cmd_update_lop(cdev, re.pcls, lop)) < 0
                 )
-                return code;
+                break;
             code = cmd_put_drawing_color(cdev, re.pcls, pdcolor, &re,
                                          devn_not_tile_fill);
             if (code == gs_error_unregistered)
-                return code;
+                break;
             if (code < 0) {
                 /* Something went wrong, use the default implementation. */
+                cmd_path_bounds_release(cdev, &bounds);
                 return gx_default_fill_path(dev, pgs, ppath, params, pdcolor,
                                             pcpath);
             }
@@ -869,11 +893,15 @@ clist_fill_path(gx_device * dev, const gs_gstate * pgs, gx_path * ppath,
                                 int2fixed(max(re.y - 1, y0)),
                                 int2fixed(min(re.y + re.height + 1, y1)),
                                 op,
-                                true, sn_none /* fill doesn't need the notes */ );
+                                true, sn_none /* fill doesn't need the notes */,
+                                &bounds);
             if (code < 0)
-                return code;
+                break;
             re.y += re.height;
         } while (re.y < re.yend);
+        cmd_path_bounds_release(cdev, &bounds);
+        if (code < 0)
+            return code;
     }
     return 0;
 }
@@ -1053,7 +1081,7 @@ clist_fill_stroke_path(gx_device * pdev, const gs_gstate * pgs,
         /* Don't skip segments when expansion is unknown.  */
 
         code = cmd_put_path(cdev, re.pcls, ppath, min_fixed, max_fixed,
-                            op, false, (segment_notes)~0);
+                            op, false, (segment_notes)~0, NULL);
         if (code < 0)
             return code;
         re.y += re.height;
@@ -1077,7 +1105,11 @@ clist_stroke_path(gx_device * dev, const gs_gstate * pgs, gx_path * ppath,
     gs_logical_operation_t lop = pgs->log_op;
     bool slow_rop = cmd_slow_rop(dev, lop_know_S_0(lop), pdcolor);
     cmd_rects_enum_t re;
+    cmd_path_bounds bounds;
+    int code = 0;
 
+    bounds.count = 0;
+    bounds.subpaths = NULL;
     CMD_CHECK_LAST_OP_BLOCK_DEFINED(cdev);
     if ((cdev->disable_mask & clist_disable_stroke_path) ||
         gs_debug_c(',')
@@ -1188,22 +1220,23 @@ clist_stroke_path(gx_device * dev, const gs_gstate * pgs, gx_path * ppath,
         clist_update_trans_bbox(cdev, &trans_bbox);
     }
     RECT_ENUM_INIT(re, ry, rheight);
+    if (!(pattern_size || expansion_code < 0))
+        cmd_path_bounds_init(cdev, &bounds, ppath, re.rect_nbands);
     do {
-        int code;
-
         RECT_STEP_INIT(re);
         CMD_CHECK_LAST_OP_BLOCK_DEFINED(cdev);
         if ((code = cmd_do_write_unknown(cdev, re.pcls, STROKE_ALL_KNOWN)) < 0 ||
             (code = cmd_do_enable_clip(cdev, re.pcls, pcpath != NULL)) < 0 ||
             (code = cmd_update_lop(cdev, re.pcls, lop)) < 0
             )
-            return code;
+            break;
         CMD_CHECK_LAST_OP_BLOCK_DEFINED(cdev);
         code = cmd_put_drawing_color(cdev, re.pcls, pdcolor, &re, devn_not_tile_stroke);
             if (code == gs_error_unregistered)
-                return code;
+                break;
         if (code < 0) {
             /* Something went wrong, use the default implementation. */
+            cmd_path_bounds_release(cdev, &bounds);
             return gx_default_stroke_path(dev, pgs, ppath, params, pdcolor,
                                           pcpath);
         }
@@ -1228,13 +1261,14 @@ clist_stroke_path(gx_device * dev, const gs_gstate * pgs, gx_path * ppath,
             }
             code = cmd_put_path(cdev, re.pcls, ppath, ymin, ymax,
                                 cmd_opv_stroke,
-                                false, (segment_notes)~0);
+                                false, (segment_notes)~0, &bounds);
             if (code < 0)
-                return code;
+                break;
         }
         re.y += re.height;
     } while (re.y < re.yend);
-    return 0;
+    cmd_path_bounds_release(cdev, &bounds);
+    return code < 0 ? code : 0;
 }
 
 /*
@@ -1302,7 +1336,8 @@ clist_put_polyfill(gx_device *dev, fixed px, fixed py,
                             int2fixed(max(re.y - 1, y0)),
                             int2fixed(min(re.y + re.height + 1, y1)),
                             cmd_opv_polyfill,
-                            true, sn_none /* fill doesn't need the notes */ );
+                            true, sn_none /* fill doesn't need the notes */,
+                            NULL);
         if (code < 0)
             goto out;
         re.y += re.height;
@@ -1385,6 +1420,7 @@ cmd_put_segment(cmd_segment_writer * psw, byte op,
     byte *q = psw->cmd;
 
     --q;
+    psw->pcls->color_usage.path_segments++;
 
 #ifdef DEBUG
     if (gs_debug_c('L')) {
@@ -1505,14 +1541,81 @@ cmd_put_segment(cmd_segment_writer * psw, byte op,
 #define cmd_put_rlineto(psw, operands, notes)\
   cmd_put_segment(psw, cmd_opv_rlineto, operands, notes)
 
+/*
+ * Compute the Y bounds of each subpath of a path that is about to be
+ * written into nbands bands.  This is only an optimization: if the path
+ * is too simple to benefit, or we can't get the memory, we leave
+ * pbounds->count = 0 and cmd_put_path enumerates every segment as before.
+ */
+static void
+cmd_path_bounds_init(gx_device_clist_writer * cldev, cmd_path_bounds * pbounds,
+                     const gx_path * ppath, int nbands)
+{
+    int count = gx_path_subpath_count(ppath);
+    const subpath *psub;
+    int i = 0;
+
+    pbounds->count = 0;
+    pbounds->subpaths = NULL;
+    if (nbands < 2 || count < 2 || ppath->segments == 0)
+        return;
+    pbounds->subpaths = (cmd_subpath_bounds *)
+        gs_alloc_byte_array(cldev->bandlist_memory, count,
+                            sizeof(cmd_subpath_bounds), "cmd_path_bounds_init");
+    if (pbounds->subpaths == NULL)
+        return;
+    for (psub = ppath->first_subpath; psub != 0 && i < count;
+         psub = (const subpath *)psub->last->next, ++i) {
+        const segment *pseg = (const segment *)psub;
+        fixed ymin = psub->pt.y, ymax = ymin;
+
+        while (pseg != psub->last) {
+            pseg = pseg->next;
+            if (pseg->pt.y < ymin)
+                ymin = pseg->pt.y;
+            else if (pseg->pt.y > ymax)
+                ymax = pseg->pt.y;
+            if (pseg->type == s_curve) {
+                const curve_segment *pcseg = (const curve_segment *)pseg;
+
+                ymin = min(ymin, min(pcseg->p1.y, pcseg->p2.y));
+                ymax = max(ymax, max(pcseg->p1.y, pcseg->p2.y));
+            }
+        }
+        pbounds->subpaths[i].psub = psub;
+        pbounds->subpaths[i].ymin = ymin;
+        pbounds->subpaths[i].ymax = ymax;
+    }
+    if (psub != 0 || i != count) {
+        /* subpath_count doesn't match the segments: don't use the bounds. */
+        cmd_path_bounds_release(cldev, pbounds);
+        return;
+    }
+    pbounds->count = count;
+}
+
+static void
+cmd_path_bounds_release(gx_device_clist_writer * cldev, cmd_path_bounds * pbounds)
+{
+    if (pbounds->subpaths != NULL)
+        gs_free_object(cldev->bandlist_memory, pbounds->subpaths,
+                       "cmd_path_bounds_release");
+    pbounds->count = 0;
+    pbounds->subpaths = NULL;
+}
+
 /*
  * Write a path.  We go to a lot of trouble to omit segments that are
- * entirely outside the band.
+ * entirely outside the band.  If pbounds is not NULL and has been
+ * computed, we also use it to pass over whole subpaths outside the band
+ * without enumerating their segments; the commands written are exactly
+ * the same either way.
  */
 static int
 cmd_put_path(gx_device_clist_writer * cldev, gx_clist_state * pcls,
              const gx_path * ppath, fixed ymin, fixed ymax, byte path_op,
-             bool implicit_close, segment_notes keep_notes)
+             bool implicit_close, segment_notes keep_notes,
+             const cmd_path_bounds * pbounds)
 {
     gs_path_enum cenum;
     cmd_segment_writer writer;
@@ -1581,6 +1684,9 @@ cmd_put_path(gx_device_clist_writer * cldev, gx_clist_state * pcls,
                                 /* 0 if newpath/closepath */
     struct { fixed vs[6]; } prev = { { 0 } };
 
+    /* The index of the next subpath in pbounds: */
+    int isub = 0;
+
     first.x = first.y = out.x = out.y = start.x = start.y = 0; /* Quiet gcc warning. */
     if_debug4m('p', cldev->memory, "[p]initial (%g,%g), clip [%g..%g)\n",
                fixed2float(px), fixed2float(py),
@@ -1624,6 +1730,44 @@ cmd_put_path(gx_device_clist_writer * cldev, gx_clist_state * pcls,
                     gx_path_enum_backup(&cenum);
                     goto close;
                 }
+                if (pbounds != NULL && isub < pbounds->count) {
+                    const cmd_subpath_bounds *psb = &pbounds->subpaths[isub++];
+                    int all_side =
+                        (psb->ymax < ymin ? -1 : psb->ymin > ymax ? 1 : 0);
+
+                    if (all_side != 0) {
+                        /*
+                         * Every segment of this subpath would be skipped
+                         * below.  Leave the state exactly as the skipping
+                         * code would, and go straight to the next subpath.
+                         */
+                        const segment *plast = psb->psub->last;
+                        bool closed = plast->type == s_line_close;
+                        const segment *pend = (closed ? plast->prev : plast);
+
+                        start.x = A, start.y = B;
+                        start_side = side = all_side;
+                        out = start;
+                        start_skip = false;
+                        if (pend != (const segment *)psb->psub) {
+                            start_skip = true;
+                            out = pend->pt;
+                            out_notes = pend->notes & keep_notes;
+                        }
+                        if (closed) {
+                            set_first_point();
+                            open = 0;
+                        } else
+                            open = -1;
+                        cenum.pseg = plast->next;
+                        cenum.notes = plast->notes;
+                        if_debug3m('p', cldev->memory,
+                                   "[p]skip subpath (%g,%g) side %d\n",
+                                   fixed2float(start.x), fixed2float(start.y),
+                                   side);
+                        continue;
+                    }
+                }
                 open = -1;
                 start.x = A, start.y = B;
                 start_skip = false;
@@ -0,0 +1,357 @@
+/* Copyright (C) 2001-2019 Artifex Software, Inc.
+   All Rights Reserved.
+
+   This software is provided AS-IS with no warranty, either express or
+   implied.
+
+   This software is distributed under license and may not be copied,
+   modified or distributed except as expressly authorized under the terms
+   of the license contained in the file LICENSE in this distribution.
+
+   Refer to licensing information at http://www.artifex.com or contact
+   Artifex Software, Inc.,  1305 Grant Avenue - Suite 200, Novato,
+   CA 94945, U.S.A., +1(415)492-9861, for further information.
+*/
+
+
+/* Band rendering profiler for the command list */
+#include "memory_.h"
+#include "gx.h"
+#include "gp.h"
+#include "gserrors.h"
+#include "gxsync.h"
+#include "gxdevice.h"
+#include "gxcomp.h"
+#include "gstrans.h"
+#include "gxcldev.h"
+#include "gxclpath.h"
+#include "gxclprof.h"
+
+/*
+ * Each command is counted under a key.  Commands whose opcode has a
+ * sub-opcode table (misc, misc2, segment, path) are counted separately;
+ * the others (fills, copies, tiles, colors), whose low 4 bits are an
+ * operand, are counted together by their high 4 bits.  The extended
+ * commands and the compositors have keys of their own.
+ */
+#define PROF_EXT_OPS 16
+#define PROF_PDF14_OPS 16
+#define PROF_KEY_EXT 256
+#define PROF_KEY_PDF14 (PROF_KEY_EXT + PROF_EXT_OPS)
+#define PROF_KEY_OVERPRINT (PROF_KEY_PDF14 + PROF_PDF14_OPS)
+#define PROF_KEY_OTHER_COMP (PROF_KEY_OVERPRINT + 1)
+#define PROF_NUM_KEYS (PROF_KEY_OTHER_COMP + 1)
+
+/* Rendering threads beyond this many all share the last tid. */
+#define PROF_MAX_THREADS 64
+
+struct clist_profile_s {
+    gs_memory_t *memory;	/* non-GC, thread safe */
+    gx_monitor_t *lock;		/* protects everything below */
+    int rc;
+    char *fname;
+    gp_file *file;
+    long t0[2];			/* time stamps are relative to this */
+    int num_threads;
+    const gx_device *threads[PROF_MAX_THREADS];
+};
+
+struct clist_band_profile_s {
+    clist_profile_t *profile;
+    gs_memory_t *memory;
+    const gx_device *dev;
+    int band_first, band_last;
+    long start[2];
+    long last[2];		/* start of the current command */
+    int key;			/* key of the current command, -1 if none */
+    int comp_key;
+    long comp_start[2];
+    ulong count[PROF_NUM_KEYS];
+    int64_t nsec[PROF_NUM_KEYS];
+};
+
+static const char *const prof_op_names[16] = {cmd_op_name_strings};
+static const char *const prof_misc_op_names[16] = {cmd_misc_op_name_strings};
+static const char *const prof_misc2_op_names[16] = {cmd_misc2_op_name_strings};
+static const char *const prof_segment_op_names[16] = {cmd_segment_op_name_strings};
+static const char *const prof_path_op_names[16] = {cmd_path_op_name_strings};
+static const char *const prof_ext_op_names[PROF_EXT_OPS] = {
+    "put_params", "create_compositor", "put_halftone", "put_ht_seg",
+    "put_fill_dcolor", "put_stroke_dcolor", "tile_rect_hl",
+    "put_tile_devn_color0", "put_tile_devn_color1", "set_color_is_devn",
+    "unset_color_is_devn"
+};
+static const char *const prof_pdf14_op_names[] = PDF14_OPCODE_NAMES;
+
+static int64_t
+prof_nsec_between(const long t0[2], const long t1[2])
+{
+    return (int64_t)(t1[0] - t0[0]) * 1000000000 + (t1[1] - t0[1]);
+}
+
+static int
+prof_key(int op, const byte *cbp)
+{
+    switch (op >> 4) {
+        case cmd_op_misc >> 4:
+        case cmd_op_misc2 >> 4:
+        case cmd_op_segment >> 4:
+        case cmd_op_path >> 4:
+            if (op == cmd_opv_extend && *cbp < PROF_EXT_OPS)
+                return PROF_KEY_EXT + *cbp;
+            return op;
+        default:
+            return op & 0xf0;
+    }
+}
+
+/* Write the name of a key, or return false if it doesn't have one. */
+static bool
+prof_print_key(gp_file *f, int key)
+{
+    const char *name;
+    int len;
+
+    if (key < PROF_KEY_EXT) {
+        switch (key >> 4) {
+            case cmd_op_misc >> 4:
+                name = prof_misc_op_names[key & 0xf]; break;
+            case cmd_op_misc2 >> 4:
+                name = prof_misc2_op_names[key & 0xf]; break;
+            case cmd_op_segment >> 4:
+                name = prof_segment_op_names[key & 0xf]; break;
+            case cmd_op_path >> 4:
+                name = prof_path_op_names[key & 0xf]; break;
+            default:
+                name = prof_op_names[key >> 4];
+        }
+    } else if (key < PROF_KEY_PDF14)
+        name = prof_ext_op_names[key - PROF_KEY_EXT];
+    else if (key < PROF_KEY_OVERPRINT) {
+        if (key - PROF_KEY_PDF14 >= (int)countof(prof_pdf14_op_names))
+            return false;
+        name = prof_pdf14_op_names[key - PROF_KEY_PDF14];
+    } else if (key == PROF_KEY_OVERPRINT)
+        name = "overprint";
+    else
+        name = "other_compositor";
+    if (name == NULL)
+        return false;
+    /* The pdf14 names are padded with spaces. */
+    for (len = strlen(name); len > 0 && name[len - 1] == ' '; --len)
+        DO_NOTHING;
+    gp_fprintf(f, "\"%.*s\"", len, name);
+    return true;
+}
+
+/* ---------------- Profiles ---------------- */
+
+int
+clist_profile_new(gs_memory_t *mem, const byte *fname, uint len,
+                  clist_profile_t **pprof)
+{
+    gs_memory_t *pmem = mem->non_gc_memory;
+    clist_profile_t *prof;
+
+    prof = (clist_profile_t *)gs_alloc_bytes(pmem, sizeof(*prof),
+                                             "clist_profile_new");
+    if (prof == NULL)
+        return_error(gs_error_VMerror);
+    memset(prof, 0, sizeof(*prof));
+    prof->memory = pmem;
+    prof->rc = 1;
+    prof->fname = (char *)gs_alloc_bytes(pmem, len + 1,
+                                         "clist_profile_new(fname)");
+    prof->lock = gx_monitor_alloc(pmem);
+    if (prof->fname == NULL || prof->lock == NULL) {
+        clist_profile_release(prof);
+        return_error(gs_error_VMerror);
+    }
+    memcpy(prof->fname, fname, len);
+    prof->fname[len] = 0;
+    prof->file = gp_fopen(pmem, prof->fname, "w");
+    if (prof->file == NULL) {
+        clist_profile_release(prof);
+        return_error(gs_error_invalidfileaccess);
+    }
+    gp_fputs("[{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,"
+             "\"args\":{\"name\":\"band rendering\"}}", prof->file);
+    gp_get_realtime(prof->t0);
+    *pprof = prof;
+    return 0;
+}
+
+clist_profile_t *
+clist_profile_retain(clist_profile_t *prof)
+{
+    if (prof != NULL) {
+        gx_monitor_enter(prof->lock);
+        prof->rc++;
+        gx_monitor_leave(prof->lock);
+    }
+    return prof;
+}
+
+void
+clist_profile_release(clist_profile_t *prof)
+{
+    int rc;
+
+    if (prof == NULL)
+        return;
+    if (prof->lock != NULL) {
+        gx_monitor_enter(prof->lock);
+        rc = --prof->rc;
+        gx_monitor_leave(prof->lock);
+        if (rc > 0)
+            return;
+        gx_monitor_free(prof->lock);
+    }
+    if (prof->file != NULL) {
+        gp_fputs("\n]\n", prof->file);
+        gp_fclose(prof->file);
+    }
+    gs_free_object(prof->memory, prof->fname, "clist_profile_release(fname)");
+    gs_free_object(prof->memory, prof, "clist_profile_release");
+}
+
+const char *
+clist_profile_fname(const clist_profile_t *prof)
+{
+    return (prof == NULL ? "" : prof->fname);
+}
+
+/* Return the tid for dev, announcing it if it is new.  Call with the lock. */
+static int
+prof_thread_id(clist_profile_t *prof, const gx_device *dev)
+{
+    int i;
+
+    for (i = 0; i < prof->num_threads; i++)
+        if (prof->threads[i] == dev)
+            return i + 1;
+    if (prof->num_threads == PROF_MAX_THREADS)
+        return PROF_MAX_THREADS;
+    prof->threads[i] = dev;
+    prof->num_threads++;
+    gp_fprintf(prof->file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,"
+               "\"tid\":%d,\"args\":{\"name\":\"renderer %d\"}}", i + 1, i + 1);
+    return i + 1;
+}
+
+/* ---------------- Bands ---------------- */
+
+clist_band_profile_t *
+clist_band_profile_begin(clist_profile_t *prof, const gx_device *dev,
+                         int band_first, int band_last, gs_memory_t *mem)
+{
+    clist_band_profile_t *bprof;
+
+    if (prof == NULL)
+        return NULL;
+    bprof = (clist_band_profile_t *)gs_alloc_bytes(mem, sizeof(*bprof),
+                                                   "clist_band_profile_begin");
+    if (bprof == NULL)
+        return NULL;
+    memset(bprof, 0, sizeof(*bprof));
+    bprof->profile = prof;
+    bprof->memory = mem;
+    bprof->dev = dev;
+    bprof->band_first = band_first;
+    bprof->band_last = band_last;
+    bprof->key = -1;
+    gp_get_realtime(bprof->start);
+    bprof->last[0] = bprof->start[0];
+    bprof->last[1] = bprof->start[1];
+    return bprof;
+}
+
+void
+clist_band_profile_cmd(clist_band_profile_t *bprof, int op, const byte *cbp)
+{
+    long now[2];
+
+    gp_get_realtime(now);
+    if (bprof->key >= 0)
+        bprof->nsec[bprof->key] += prof_nsec_between(bprof->last, now);
+    bprof->last[0] = now[0];
+    bprof->last[1] = now[1];
+    bprof->key = prof_key(op, cbp);
+    bprof->count[bprof->key]++;
+}
+
+void
+clist_band_profile_comp_begin(clist_band_profile_t *bprof,
+                              const gs_composite_t *pcomp)
+{
+    switch (pcomp->type->comp_id) {
+        case GX_COMPOSITOR_PDF14_TRANS: {
+            int op = ((const gs_pdf14trans_t *)pcomp)->params.pdf14_op;
+
+            bprof->comp_key = (op >= 0 && op < PROF_PDF14_OPS ?
+                               PROF_KEY_PDF14 + op : PROF_KEY_OTHER_COMP);
+            break;
+        }
+        case GX_COMPOSITOR_OVERPRINT:
+            bprof->comp_key = PROF_KEY_OVERPRINT;
+            break;
+        default:
+            bprof->comp_key = PROF_KEY_OTHER_COMP;
+    }
+    gp_get_realtime(bprof->comp_start);
+}
+
+void
+clist_band_profile_comp_end(clist_band_profile_t *bprof)
+{
+    long now[2];
+
+    gp_get_realtime(now);
+    bprof->count[bprof->comp_key]++;
+    bprof->nsec[bprof->comp_key] += prof_nsec_between(bprof->comp_start, now);
+}
+
+void
+clist_band_profile_end(clist_band_profile_t *bprof, int code)
+{
+    clist_profile_t *prof;
+    gp_file *f;
+    long now[2];
+    int tid, key;
+
+    if (bprof == NULL)
+        return;
+    prof = bprof->profile;
+    f = prof->file;
+    gp_get_realtime(now);
+    if (bprof->key >= 0)
+        bprof->nsec[bprof->key] += prof_nsec_between(bprof->last, now);
+
+    gx_monitor_enter(prof->lock);
+    tid = prof_thread_id(prof, bprof->dev);
+    if (bprof->band_first == bprof->band_last)
+        gp_fprintf(f, ",\n{\"name\":\"band %d\"", bprof->band_first);
+    else
+        gp_fprintf(f, ",\n{\"name\":\"bands %d-%d\"", bprof->band_first,
+                   bprof->band_last);
+    gp_fprintf(f, ",\"cat\":\"band\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,"
+               "\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"band\":%d,\"code\":%d",
+               tid, prof_nsec_between(prof->t0, bprof->start) / 1000.0,
+               prof_nsec_between(bprof->start, now) / 1000.0,
+               bprof->band_first, code);
+    /* Each command as [count, microseconds]. */
+    for (key = 0; key < PROF_NUM_KEYS; key++) {
+        if (bprof->count[key] == 0)
+            continue;
+        gp_fputs(",", f);
+        if (!prof_print_key(f, key))
+            gp_fprintf(f, "\"op_%d\"", key);
+        gp_fprintf(f, ":[%lu,%.3f]", bprof->count[key],
+                   bprof->nsec[key] / 1000.0);
+    }
+    gp_fputs("}}", f);
+    gp_fflush(f);
+    gx_monitor_leave(prof->lock);
+
+    gs_free_object(bprof->memory, bprof, "clist_band_profile_end");
+}
@@ -0,0 +1,78 @@
+/* Copyright (C) 2001-2019 Artifex Software, Inc.
+   All Rights Reserved.
+
+   This software is provided AS-IS with no warranty, either express or
+   implied.
+
+   This software is distributed under license and may not be copied,
+   modified or distributed except as expressly authorized under the terms
+   of the license contained in the file LICENSE in this distribution.
+
+   Refer to licensing information at http://www.artifex.com or contact
+   Artifex Software, Inc.,  1305 Grant Avenue - Suite 200, Novato,
+   CA 94945, U.S.A., +1(415)492-9861, for further information.
+*/
+
+
+/* Band rendering profiler for the command list */
+/* Requires gxclist.h */
+
+#ifndef gxclprof_INCLUDED
+#  define gxclprof_INCLUDED
+
+#include "gxclist.h"
+#include "gscompt.h"
+
+/*
+ * When the BandListProfile device parameter names a file, each band (or
+ * range of bands) played back for rendering is timed, and a summary of where
+ * the time went is written to the file as one event in the Chrome trace
+ * event format (a JSON array that chrome://tracing, Perfetto and similar
+ * viewers load directly).  Each event carries, as its args, the number of
+ * times each command opcode and each compositor operation was executed in
+ * the band and the wall clock time spent in it, in microseconds.  The
+ * rendering threads each appear as a separate thread in the trace.
+ *
+ * The time of a command runs from its opcode to the next opcode, so
+ * compositor operations, which are executed from within the extended
+ * create_compositor command (or from queued ones), are also included in
+ * the time of that command.
+ *
+ * A clist_profile_t is reference counted: it is shared between a printer
+ * device, the reader devices of its rendering threads, and any pages being
+ * printed in the background, and the file is completed when the last
+ * reference is released.  When profiling is off the only cost during
+ * playback is a test of a NULL pointer per command.
+ */
+
+/* Create a profile writing to the file fname (not null terminated). */
+int clist_profile_new(gs_memory_t *mem, const byte *fname, uint len,
+                      clist_profile_t **pprof);
+clist_profile_t *clist_profile_retain(clist_profile_t *prof);
+void clist_profile_release(clist_profile_t *prof);
+
+/* Return the file name of a profile, "" if prof is NULL. */
+const char *clist_profile_fname(const clist_profile_t *prof);
+
+/*
+ * Start profiling the playback of bands band_first..band_last by dev.
+ * Returns NULL if prof is NULL, or if there isn't enough memory, in which
+ * case the bands simply aren't profiled.
+ */
+clist_band_profile_t *clist_band_profile_begin(clist_profile_t *prof,
+                                               const gx_device *dev,
+                                               int band_first, int band_last,
+                                               gs_memory_t *mem);
+/* Write out the event for the bands and free bprof. */
+void clist_band_profile_end(clist_band_profile_t *bprof, int code);
+
+/* Note the start of a command; cbp points just after its opcode. */
+void clist_band_profile_cmd(clist_band_profile_t *bprof, int op,
+                            const byte *cbp);
+
+/* Bracket the execution of a compositor. */
+void clist_band_profile_comp_begin(clist_band_profile_t *bprof,
+                                   const gs_composite_t *pcomp);
+void clist_band_profile_comp_end(clist_band_profile_t *bprof);
+
+#endif /* gxclprof_INCLUDED */
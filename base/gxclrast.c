@@ -49,6 +49,7 @@
 #include "stream.h"
 #include "strimpl.h"
 #include "gxcomp.h"
+#include "gxclprof.h"
 #include "gsserial.h"
 #include "gxdhtserial.h"
 #include "gzht.h"
@@ -371,7 +372,8 @@ is_null_compositor_op(const byte *cbp, int *length)
 static int
 execute_compositor_queue(gx_device_clist_reader *cdev, gx_device **target, gx_device **tdev, gs_gstate *pgs,
                          gs_composite_t **ppcomp_first, gs_composite_t **ppcomp_last, gs_composite_t *pcomp_from,
-                         int x0, int y0, gs_memory_t *mem, bool idle)
+                         int x0, int y0, gs_memory_t *mem, bool idle,
+                         clist_band_profile_t *bprof)
 {
     while (pcomp_from != NULL) {
         gs_composite_t *pcomp = pcomp_from;
@@ -382,7 +384,11 @@ execute_compositor_queue(gx_device_clist_reader *cdev, gx_device **target, gx_de
         if (code < 0)
             return code;
         pcomp->idle |= idle;
+        if (bprof != NULL)
+            clist_band_profile_comp_begin(bprof, pcomp);
         code = apply_create_compositor(cdev, pgs, mem, pcomp, x0, y0, target); /* Releases the compositor. */
+        if (bprof != NULL)
+            clist_band_profile_comp_end(bprof);
         if (code < 0)
             return code;
         *tdev = *target;
@@ -475,7 +481,8 @@ read_set_misc_map(byte cb, command_buf_t *pcb, gs_gstate *pgs, gs_memory_t *mem)
 int
 clist_playback_band(clist_playback_action playback_action,
                     gx_device_clist_reader *cdev, stream *s,
-                    gx_device *target, int x0, int y0, gs_memory_t * mem)
+                    gx_device *target, int x0, int y0, gs_memory_t * mem,
+                    clist_band_profile_t *bprof)
 {
     byte *cbuf_storage;
     command_buf_t cbuf;
@@ -677,6 +684,8 @@ in:                             /* Initialize for a new page. */
             }
         }
         op = *cbp++;
+        if (bprof != NULL)
+            clist_band_profile_cmd(bprof, op, cbp);
 #ifdef DEBUG
         if (gs_debug_c('L')) {
             const char *const *sub = cmd_sub_op_names[op >> 4];
@@ -1641,7 +1650,7 @@ idata:                  data_size = 0;
                                             /* Execute idle. */
                                             enqueue_compositor(&pcomp_first, &pcomp_last, pcomp);
                                             code = execute_compositor_queue(cdev, &target, &tdev,
-                                                &gs_gstate, &pcomp_first, &pcomp_last, pcomp_opening, x0, y0, mem, true);
+                                                &gs_gstate, &pcomp_first, &pcomp_last, pcomp_opening, x0, y0, mem, true, bprof);
                                             if (code < 0)
                                                 goto out;
                                             break;
@@ -1649,14 +1658,14 @@ idata:                  data_size = 0;
                                             /* The opening command was executed. Execute the queue. */
                                             enqueue_compositor(&pcomp_first, &pcomp_last, pcomp);
                                             code = execute_compositor_queue(cdev, &target, &tdev,
-                                                &gs_gstate, &pcomp_first, &pcomp_last, pcomp_first, x0, y0, mem, false);
+                                                &gs_gstate, &pcomp_first, &pcomp_last, pcomp_first, x0, y0, mem, false, bprof);
                                             if (code < 0)
                                                 goto out;
                                             break;
                                         case COMP_REPLACE_PREV:
                                             /* Replace last compositors. */
                                             code = execute_compositor_queue(cdev, &target, &tdev,
-                                                &gs_gstate, &pcomp_first, &pcomp_last, pcomp_opening, x0, y0, mem, true);
+                                                &gs_gstate, &pcomp_first, &pcomp_last, pcomp_opening, x0, y0, mem, true, bprof);
                                             if (code < 0)
                                                 goto out;
                                             enqueue_compositor(&pcomp_first, &pcomp_last, pcomp);
@@ -1686,7 +1695,7 @@ idata:                  data_size = 0;
                                     } else if (cbp[0] == cmd_opv_end_page) {
                                         /* End page, drop the queue. */
                                         code = execute_compositor_queue(cdev, &target, &tdev,
-                                                &gs_gstate, &pcomp_first, &pcomp_last, pcomp_first, x0, y0, mem, true);
+                                                &gs_gstate, &pcomp_first, &pcomp_last, pcomp_first, x0, y0, mem, true, bprof);
                                         if (code < 0)
                                             goto out;
                                         break;
@@ -1750,7 +1759,7 @@ idata:                  data_size = 0;
                                     } else {
                                         /* A drawing command, execute entire queue. */
                                         code = execute_compositor_queue(cdev, &target, &tdev,
-                                            &gs_gstate, &pcomp_first, &pcomp_last, pcomp_first, x0, y0, mem, false);
+                                            &gs_gstate, &pcomp_first, &pcomp_last, pcomp_first, x0, y0, mem, false, bprof);
                                         if (code < 0)
                                             goto out;
                                         break;
@@ -31,6 +31,7 @@
 #include "gdevp14.h"
 #include "gsmemory.h"
 #include "gsicc_cache.h"
+#include "gxclprof.h"
 /*
  * We really don't like the fact that gdevprn.h is included here, since
  * command lists are supposed to be usable for purposes other than printer
@@ -565,6 +566,7 @@ clist_render_init(gx_device_clist *dev)
     crdev->icc_table = NULL;
     crdev->color_usage_array = NULL;
     crdev->render_threads = NULL;
+    crdev->band_sched = NULL;
 
     return 0;
 }
@@ -872,6 +874,7 @@ clist_playback_file_bands(clist_playback_action action,
     int code = 0;
     bool opened_bfile = false;
     bool opened_cfile = false;
+    clist_band_profile_t *bprof = NULL;
 
     /* We have to pick some allocator for rendering.... */
     gs_memory_t *mem =crdev->memory;
@@ -917,7 +920,12 @@ clist_playback_file_bands(clist_playback_action action,
         s.foreign = 1;
         s.state = (stream_state *)&rs;
 
-        code = clist_playback_band(action, crdev, &s, target, x0, y0, mem);
+        if (action != playback_action_setup)
+            bprof = clist_band_profile_begin(crdev->profile, (gx_device *)crdev,
+                                             band_first, band_last, mem);
+        code = clist_playback_band(action, crdev, &s, target, x0, y0, mem,
+                                   bprof);
+        clist_band_profile_end(bprof, code);
 #	ifdef DEBUG
         s_band_read_dnit_offset_map(crdev, (stream_state *)&rs);
 #	endif
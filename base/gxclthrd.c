@@ -32,6 +32,7 @@
 #include "gsmemory.h"
 #include "gsmchunk.h"
 #include "gxclthrd.h"
+#include "gxclprof.h"
 #include "gdevdevn.h"
 #include "gsicc_cache.h"
 #include "gsicc_manage.h"
@@ -39,9 +40,23 @@
 #include "gzht.h"		/* for gx_ht_cache_default_bits_size */
 
 /* Forward reference prototypes */
-static int clist_start_render_thread(gx_device *dev, int thread_index, int band);
+static int clist_resume_render_threads(gx_device *dev, int y, gx_process_page_options_t *options);
+static void clist_free_idle_render_threads(gx_device *dev);
+static int clist_alloc_band_sched(gx_device *dev, gs_memory_t *mem);
+static void clist_free_band_sched(clist_band_sched_t *sched);
+static int clist_init_band_sched_buffers(gx_device *dev, gx_process_page_options_t *options);
+static void clist_sched_deal_bands(gx_device_clist_reader *crdev, clist_band_sched_t *sched,
+                                   int first_band, int direction, int band_count);
+static void clist_sched_wake_threads(clist_band_sched_t *sched, bool all);
+static int clist_start_render_threads(gx_device *dev);
+static void clist_stop_render_threads(gx_device *dev);
 static void clist_render_thread(void *param);
 
+/* Each slot holds one rendered band waiting for delivery, so this (times */
+/* the number of threads) is the number of extra band buffers, and limits */
+/* how far the threads may run ahead of the band being delivered.         */
+#define CLIST_BAND_SLOTS_PER_THREAD 2
+
 /* clone a device and set params and its chunk memory                   */
 /* The chunk_base_mem MUST be thread safe                               */
 /* Return NULL on error, or the cloned device with the dev->memory set  */
@@ -103,6 +118,8 @@ setup_device_and_mem_for_thread(gs_memory_t *chunk_base_mem, gx_device *dev, boo
     ndev->log2_align_mod = dev->log2_align_mod;
     ndev->is_planar = dev->is_planar;
     ndev->icc_struct = NULL;
+    /* Share the profile, so put params of the same BandListProfile is a no-op */
+    npdev->clist_profile = clist_profile_retain(pdev->clist_profile);
 
     /* If the device ICC profile (or proof) is OI_PROFILE, then that was not handled
      * by put/get params, and we cannot share the profiles between the 'parent' output device
@@ -223,9 +240,9 @@ setup_device_and_mem_for_thread(gs_memory_t *chunk_base_mem, gx_device *dev, boo
     strcpy(fmode, "r");                 /* read access for threads */
     strncat(fmode, gp_fmode_binary_suffix, 1);
     if ((code=cdev->page_info.io_procs->fopen(cdev->page_info.cfname, fmode, &ncdev->page_info.cfile,
-                        thread_mem, thread_mem, true)) < 0 ||
+                        thread_mem, thread_mem, clist_compress_default)) < 0 ||
          (code=cdev->page_info.io_procs->fopen(cdev->page_info.bfname, fmode, &ncdev->page_info.bfile,
-                        thread_mem, thread_mem, false)) < 0)
+                        thread_mem, thread_mem, clist_compress_default)) < 0)
         goto out_cleanup;
 
     strcpy((ncdev->page_info.cfname), (cdev->page_info.cfname));
@@ -236,10 +253,19 @@ setup_device_and_mem_for_thread(gs_memory_t *chunk_base_mem, gx_device *dev, boo
     /* The threads are maintained until clist_finish_page.  At which
        point, the threads are torn down, the master clist reader device
        is changed to writer, and the icc_table and the icc_cache_cl freed */
-    if (dev->icc_struct == ndev->icc_struct) {
-    /* safe to share the link cache */
+    if (cdev->icc_cache_cl != NULL && gscms_is_threadsafe()) {
+        /* The links of a thread safe CMS can be used by several threads at
+           once, so all the threads share the link cache of the main device,
+           and each link is only built once (see gsicc_alloc_link_entry).
+           This holds even if the thread has its own icc_struct (OI_PROFILE
+           above), since the profiles it clones have the same hash codes.
+           A background printing thread sets up its own render threads, so
+           the count is only changed under the lock (see also
+           teardown_device_and_mem_for_thread). */
+        gx_monitor_enter(cdev->icc_cache_cl->lock);
         ncdev->icc_cache_cl = cdev->icc_cache_cl;
-        rc_increment(cdev->icc_cache_cl);		/* FIXME: needs to be incdemented safely */
+        rc_increment(cdev->icc_cache_cl);
+        gx_monitor_leave(cdev->icc_cache_cl->lock);
     } else {
         /* each thread needs its own link cache */
         if (cachep != NULL) {
@@ -293,6 +319,8 @@ out_cleanup:
 
     /* we can't get here with ndev == NULL */
     gdev_prn_free_memory(ndev);
+    clist_profile_release(npdev->clist_profile);
+    npdev->clist_profile = NULL;
     gs_free_object(thread_mem, ndev, "setup_device_and_mem_for_thread");
     gs_memory_chunk_release(thread_mem);
     return NULL;
@@ -302,7 +330,6 @@ out_cleanup:
 static int
 clist_setup_render_threads(gx_device *dev, int y, gx_process_page_options_t *options)
 {
-    gx_device_printer *pdev = (gx_device_printer *)dev;
     gx_device_clist *cldev = (gx_device_clist *)dev;
     gx_device_clist_common *cdev = (gx_device_clist_common *)cldev;
     gx_device_clist_reader *crdev = &cldev->reader;
@@ -321,10 +348,14 @@ clist_setup_render_threads(gx_device *dev, int y, gx_process_page_options_t *opt
     clist_icctable_entry_t *curr_entry;
     bool deep = device_is_deep(dev);
 
-    crdev->num_render_threads = pdev->num_render_threads_requested;
+    /* Reuse the threads from the previous page if we can */
+    if (clist_resume_render_threads(dev, y, options) > 0)
+        return 0;
+
+    crdev->num_render_threads = cdev->render_threads_requested;
 
     if(gs_debug[':'] != 0)
-        dmprintf1(mem, "%% %d rendering threads requested.\n", pdev->num_render_threads_requested);
+        dmprintf1(mem, "%% %d rendering threads requested.\n", cdev->render_threads_requested);
 
     if (crdev->page_uses_transparency) {
         reserve_pdf14_memory_size = (ESTIMATED_PDF14_ROW_SPACE(max(1, crdev->width), crdev->color_info.num_components, deep ? 16 : 8) >> 3);
@@ -421,10 +452,13 @@ clist_setup_render_threads(gx_device *dev, int y, gx_process_page_options_t *opt
         thread->cdev = ndev;
         thread->memory = ndev->memory;
         thread->band = -1;              /* a value that won't match any valid band */
+        thread->index = i;
         thread->options = options;
         thread->buffer = NULL;
+        /* The buffers migrate between the threads (with the bands they */
+        /* hold) so they must come from the thread safe allocator.      */
         if (options && options->init_buffer_fn) {
-            code = options->init_buffer_fn(options->arg, dev, thread->memory, dev->width, band_height, &thread->buffer);
+            code = options->init_buffer_fn(options->arg, dev, chunk_base_mem, dev->width, band_height, &thread->buffer);
             if (code < 0)
                 break;
         }
@@ -436,19 +470,18 @@ clist_setup_render_threads(gx_device *dev, int y, gx_process_page_options_t *opt
                                 thread->memory, &(crdev->color_usage_array[0]))) < 0)
             break;
         if ((thread->sema_this = gx_semaphore_label(gx_semaphore_alloc(thread->memory), "Band")) == NULL ||
-            (thread->sema_group = gx_semaphore_label(gx_semaphore_alloc(thread->memory), "Group")) == NULL) {
+            (thread->sema_wake = gx_semaphore_label(gx_semaphore_alloc(thread->memory), "Wake")) == NULL) {
             code = gs_error_VMerror;
             break;
         }
         /* We don't start the threads yet until we  free up the */
         /* reserve memory we have allocated for that band. */
-        thread->band = band;
     }
     /* If the code < 0, the last thread creation failed -- clean it up */
     if (code < 0) {
         /* NB: 'band' will be the one that failed, so will be the next_band needed to start */
         /* the following relies on 'free' ignoring NULL pointers */
-        gx_semaphore_free(crdev->render_threads[i].sema_group);
+        gx_semaphore_free(crdev->render_threads[i].sema_wake);
         gx_semaphore_free(crdev->render_threads[i].sema_this);
         if (crdev->render_threads[i].bdev != NULL)
             cdev->buf_procs.destroy_buf_device(crdev->render_threads[i].bdev);
@@ -465,7 +498,7 @@ clist_setup_render_threads(gx_device *dev, int y, gx_process_page_options_t *opt
             "clist_setup_render_threads");
         }
         if (crdev->render_threads[i].buffer != NULL && options && options->free_buffer_fn != NULL) {
-            options->free_buffer_fn(options->arg, dev, crdev->render_threads[i].memory, crdev->render_threads[i].buffer);
+            options->free_buffer_fn(options->arg, dev, chunk_base_mem, crdev->render_threads[i].buffer);
             crdev->render_threads[i].buffer = NULL;
         }
         if (crdev->render_threads[i].memory != NULL) {
@@ -492,10 +525,10 @@ clist_setup_render_threads(gx_device *dev, int y, gx_process_page_options_t *opt
             strcpy(fmode, "a+");        /* file already exists and we want to re-use it */
             strncat(fmode, gp_fmode_binary_suffix, 1);
             cdev->page_info.io_procs->fopen(cdev->page_info.cfname, fmode, &cdev->page_info.cfile,
-                                mem, cdev->bandlist_memory, true);
+                                mem, cdev->bandlist_memory, cdev->compression);
             cdev->page_info.io_procs->fseek(cdev->page_info.cfile, 0, SEEK_SET, cdev->page_info.cfname);
             cdev->page_info.io_procs->fopen(cdev->page_info.bfname, fmode, &cdev->page_info.bfile,
-                                mem, cdev->bandlist_memory, false);
+                                mem, cdev->bandlist_memory, cdev->compression);
             cdev->page_info.io_procs->fseek(cdev->page_info.bfile, 0, SEEK_SET, cdev->page_info.bfname);
         }
         emprintf1(mem, "Rendering threads not started, code=%d.\n", code);
@@ -505,15 +538,25 @@ clist_setup_render_threads(gx_device *dev, int y, gx_process_page_options_t *opt
      * threads since we deferred that in the thread setup loop above.
      * We know if we get here we can start at least 1 thread.
      */
-    for (j=0, code = 0; j<crdev->num_render_threads; j++) {
+    for (j=0; j<crdev->num_render_threads; j++)
         gs_free_object(mem, reserve_memory_array[j], "clist_setup_render_threads");
-        if (code == 0 && j < i)
-            code = clist_start_render_thread(dev, j, crdev->render_threads[j].band);
-    }
     gs_free_object(mem, reserve_memory_array, "clist_setup_render_threads");
     crdev->num_render_threads = i;
-    crdev->curr_render_thread = 0;
-    crdev->next_band = band;
+
+    /* Deal the bands out to the threads, starting from the one for 'y' */
+    code = clist_alloc_band_sched(dev, chunk_base_mem);
+    if (code >= 0)
+        code = clist_init_band_sched_buffers(dev, options);
+    if (code >= 0) {
+        clist_sched_deal_bands(crdev, crdev->band_sched, y / band_height,
+                               crdev->thread_lookahead_direction, band_count);
+        code = clist_start_render_threads(dev);
+    }
+    if (code < 0) {
+        clist_teardown_render_threads(dev);
+        emprintf1(mem, "Rendering threads not started, code=%d.\n", code);
+        return code;
+    }
 
     if(gs_debug[':'] != 0)
         dmprintf1(mem, "%% Using %d rendering threads\n", i);
@@ -528,6 +571,7 @@ teardown_device_and_mem_for_thread(gx_device *dev, gp_thread_id thread_id, bool
     gx_device_clist_common *thread_cdev = (gx_device_clist_common *)dev;
     gx_device_clist_reader *thread_crdev = (gx_device_clist_reader *)dev;
     gs_memory_t *thread_memory = dev->memory;
+    gsicc_link_cache_t *icc_cache;
 
     /* First finish the thread */
     gp_thread_finish(thread_id);
@@ -551,7 +595,21 @@ teardown_device_and_mem_for_thread(gx_device *dev, gp_thread_id thread_id, bool
          */
         thread_crdev->icc_table = NULL;
     }
-    rc_decrement(thread_crdev->icc_cache_cl, "teardown_render_thread");
+    /* The reference count of a shared link cache is changed under its lock
+       (see setup_device_and_mem_for_thread).  The last reference can't be
+       taken by anyone else, so that one is dropped (and the cache freed,
+       lock and all) outside it. */
+    icc_cache = thread_crdev->icc_cache_cl;
+    if (icc_cache != NULL) {
+        gx_monitor_enter(icc_cache->lock);
+        if (icc_cache->rc.ref_count > 1) {
+            rc_decrement_only(icc_cache, "teardown_render_thread");
+            gx_monitor_leave(icc_cache->lock);
+        } else {
+            gx_monitor_leave(icc_cache->lock);
+            rc_decrement_only(icc_cache, "teardown_render_thread");
+        }
+    }
     thread_crdev->icc_cache_cl = NULL;
     /*
      * Free the BufferSpace, close the band files, optionally unlinking them.
@@ -572,6 +630,8 @@ teardown_device_and_mem_for_thread(gx_device *dev, gp_thread_id thread_id, bool
     thread_cdev->do_not_open_or_close_bandfiles = true; /* we already closed the files */
 
     gdev_prn_free_memory((gx_device *)thread_cdev);
+    clist_profile_release(((gx_device_printer *)dev)->clist_profile);
+    ((gx_device_printer *)dev)->clist_profile = NULL;
     /* Free the device copy this thread used.  Note that the
        deviceN stuff if was allocated and copied earlier for the device
        will be freed with this call and the icc_struct ref count will be decremented. */
@@ -584,96 +644,712 @@ teardown_device_and_mem_for_thread(gx_device *dev, gp_thread_id thread_id, bool
     gs_memory_chunk_release(thread_memory);
 }
 
+/* Re-open the clist temp files of the main device so we can write to them */
+static void
+clist_reopen_page_files(gx_device *dev)
+{
+    gx_device_clist_common *cdev = (gx_device_clist_common *)dev;
+    gs_memory_t *mem = cdev->bandlist_memory;
+
+    if (cdev->page_info.cfile == NULL) {
+        char fmode[4];
+
+        strcpy(fmode, "a+");        /* file already exists and we want to re-use it */
+        strncat(fmode, gp_fmode_binary_suffix, 1);
+        cdev->page_info.io_procs->fopen(cdev->page_info.cfname, fmode, &cdev->page_info.cfile,
+                            mem, cdev->bandlist_memory, cdev->compression);
+        cdev->page_info.io_procs->fseek(cdev->page_info.cfile, 0, SEEK_SET, cdev->page_info.cfname);
+        cdev->page_info.io_procs->fopen(cdev->page_info.bfname, fmode, &cdev->page_info.bfile,
+                            mem, cdev->bandlist_memory, cdev->compression);
+        cdev->page_info.io_procs->fseek(cdev->page_info.bfile, 0, SEEK_SET, cdev->page_info.bfname);
+    }
+}
+
+/* Attach a thread device kept from an earlier page to the current page:  */
+/* open the main thread's files and share the page's tables.              */
+static int
+clist_attach_thread_device(gx_device *dev, gx_device *ndev)
+{
+    gx_device_clist_common *cdev = (gx_device_clist_common *)dev;
+    gx_device_clist_common *ncdev = (gx_device_clist_common *)ndev;
+    char fmode[4];
+    int code;
+
+    ndev->PageCount = dev->PageCount;       /* copy to prevent mismatch error */
+    ncdev->page_uses_transparency = cdev->page_uses_transparency;
+    if (dev_proc(dev, ret_devn_params)(dev) != NULL &&
+        (code = devn_copy_params(dev, ndev)) < 0)
+        return code;
+
+    strcpy(fmode, "r");                 /* read access for threads */
+    strncat(fmode, gp_fmode_binary_suffix, 1);
+    if ((code=cdev->page_info.io_procs->fopen(cdev->page_info.cfname, fmode, &ncdev->page_info.cfile,
+                        ndev->memory, ndev->memory, clist_compress_default)) < 0 ||
+         (code=cdev->page_info.io_procs->fopen(cdev->page_info.bfname, fmode, &ncdev->page_info.bfile,
+                        ndev->memory, ndev->memory, clist_compress_default)) < 0)
+        return code;
+    strcpy((ncdev->page_info.cfname), (cdev->page_info.cfname));
+    strcpy((ncdev->page_info.bfname), (cdev->page_info.bfname));
+    clist_render_init((gx_device_clist *)ndev);
+    ncdev->page_info.bfile_end_pos = cdev->page_info.bfile_end_pos;
+
+    ncdev->icc_table = cdev->icc_table;
+    ((gx_device_clist_reader *)ncdev)->color_usage_array =
+            ((gx_device_clist_reader *)cdev)->color_usage_array;
+    ncdev->trans_dev_icc_hash = cdev->trans_dev_icc_hash;
+    return 0;
+}
+
+/* Detach a thread device from the page, closing (but not deleting) the   */
+/* files and dropping the tables that belong to the main device.          */
+static void
+clist_detach_thread_device(gx_device *ndev)
+{
+    gx_device_clist_common *ncdev = (gx_device_clist_common *)ndev;
+
+    if (ncdev->page_info.bfile != NULL)
+        ncdev->page_info.io_procs->fclose(ncdev->page_info.bfile, ncdev->page_info.bfname, false);
+    if (ncdev->page_info.cfile != NULL)
+        ncdev->page_info.io_procs->fclose(ncdev->page_info.cfile, ncdev->page_info.cfname, false);
+    ncdev->page_info.bfile = ncdev->page_info.cfile = NULL;
+    ncdev->icc_table = NULL;
+    ((gx_device_clist_reader *)ncdev)->color_usage_array = NULL;
+    if (dev_proc(ndev, ret_devn_params)(ndev) != NULL)
+        devn_free_params(ndev);
+}
+
+/* Free the thread control structures and the devices of threads that    */
+/* have finished (or were never started).                                 */
+static void
+clist_free_render_thread_array(gx_device *dev, clist_render_thread_control_t *threads, int num_threads)
+{
+    gx_device_clist_common *cdev = (gx_device_clist_common *)dev;
+    gs_memory_t *mem = cdev->bandlist_memory;
+    int i;
+
+    for (i = (num_threads - 1); i >= 0; i--) {
+        clist_render_thread_control_t *thread = &(threads[i]);
+        gx_device_clist_common *thread_cdev = (gx_device_clist_common *)thread->cdev;
+
+        /* Free control semaphores */
+        gx_semaphore_free(thread->sema_wake);
+        gx_semaphore_free(thread->sema_this);
+        /* destroy the thread's buffer device */
+        if (thread->bdev != NULL)
+            thread_cdev->buf_procs.destroy_buf_device(thread->bdev);
+
+        if (thread->options) {
+            if (thread->options->free_buffer_fn && thread->buffer) {
+                thread->options->free_buffer_fn(thread->options->arg, dev, mem->thread_safe_memory, thread->buffer);
+                thread->buffer = NULL;
+            }
+            thread->options = NULL;
+        }
+        if (gs_debug[':'])
+            dmprintf3(thread->memory, "%% Thread %d rendered %d bands (%d stolen)\n",
+                      i, thread->bands_rendered, thread->bands_stolen);
+#ifdef DEBUG
+        if (gs_debug[':'])
+            dmprintf2(thread->memory, "%% Thread %d total usertime=%ld msec\n", i, thread->cputime);
+        dmprintf1(thread->memory, "\nThread %d ", i);
+#endif
+        teardown_device_and_mem_for_thread((gx_device *)thread_cdev, thread->thread, false);
+    }
+    gs_free_object(mem, threads, "clist_teardown_render_threads");
+}
+
+/* Dump the estimated costs of the bands against their rendering times, */
+/* both also as a percentage of the page total, for -Z:                  */
+static void
+clist_dump_band_costs(gx_device *dev, clist_band_sched_t *sched)
+{
+    gx_device_clist_common *cdev = (gx_device_clist_common *)dev;
+    gs_memory_t *mem = cdev->bandlist_memory;
+    double total_cost = 0, total_time = 0;
+    int band;
+
+    for (band = 0; band < cdev->nbands; band++) {
+        if (sched->render_time[band] >= 0) {
+            total_cost += sched->cost[band];
+            total_time += sched->render_time[band];
+        }
+    }
+    if (total_cost == 0)
+        total_cost = 1;
+    if (total_time == 0)
+        total_time = 1;
+    for (band = 0; band < cdev->nbands; band++) {
+        if (sched->render_time[band] >= 0)
+            dmprintf5(mem, "%% Band %d: estimated cost %lu (%.1f%%), time %ld usec (%.1f%%)\n",
+                      band, sched->cost[band], 100.0 * sched->cost[band] / total_cost,
+                      sched->render_time[band], 100.0 * sched->render_time[band] / total_time);
+    }
+}
+
+/* Stop the render threads of the page and get the main thread's band   */
+/* buffer back if it is in a slot or a thread. Also frees the slots'     */
+/* process_page buffers, which only last for the one call.              */
+static void
+clist_recover_page_data(gx_device *dev)
+{
+    gx_device_clist *cldev = (gx_device_clist *)dev;
+    gx_device_clist_common *cdev = (gx_device_clist_common *)dev;
+    gx_device_clist_reader *crdev = &cldev->reader;
+    clist_band_sched_t *sched = crdev->band_sched;
+    int i;
+
+    /* Wait for all threads to finish their bands */
+    clist_stop_render_threads(dev);
+    if (sched->render_time != NULL)
+        clist_dump_band_costs(dev, sched);
+
+    for (i = 0; i < sched->num_slots; i++) {
+        if (sched->slots[i].data == crdev->main_thread_data) {
+            sched->slots[i].data = cdev->data;
+            cdev->data = crdev->main_thread_data;
+        }
+        if (sched->slots[i].buffer != NULL) {
+            gx_process_page_options_t *options = crdev->render_threads[0].options;
+
+            if (options && options->free_buffer_fn)
+                options->free_buffer_fn(options->arg, dev, sched->memory, sched->slots[i].buffer);
+            sched->slots[i].buffer = NULL;
+        }
+    }
+    for (i = 0; i < crdev->num_render_threads; i++) {
+        gx_device_clist_common *thread_cdev =
+            (gx_device_clist_common *)crdev->render_threads[i].cdev;
+
+        if (thread_cdev->data == crdev->main_thread_data) {
+            thread_cdev->data = cdev->data;
+            cdev->data = crdev->main_thread_data;
+        }
+    }
+}
+
+/* Shut down the render threads of the page and free them, without     */
+/* keeping them for the next page. Used when the threads could not all  */
+/* be started, or on an error, when some of them may never have run.    */
+static void
+clist_free_page_render_threads(gx_device *dev)
+{
+    gx_device_clist *cldev = (gx_device_clist *)dev;
+    gx_device_clist_reader *crdev = &cldev->reader;
+    clist_band_sched_t *sched = crdev->band_sched;
+    int i;
+
+    if (sched != NULL) {
+        clist_recover_page_data(dev);
+        gx_monitor_enter(sched->lock);
+        sched->shutdown = true;
+        clist_sched_wake_threads(sched, true);
+        gx_monitor_leave(sched->lock);
+        for (i = 0; i < crdev->num_render_threads; i++) {
+            gp_thread_finish(crdev->render_threads[i].thread);
+            crdev->render_threads[i].thread = NULL;
+        }
+    }
+    clist_free_render_thread_array(dev, crdev->render_threads, crdev->num_render_threads);
+    crdev->render_threads = NULL;
+    if (sched != NULL)
+        clist_free_band_sched(sched);
+    crdev->band_sched = NULL;
+    clist_reopen_page_files(dev);
+}
+
+/* Stop the render threads at the end of a page, and keep them (with the  */
+/* devices detached from the page) for the next page.                     */
+void
+clist_finish_render_threads(gx_device *dev)
+{
+    gx_device_clist *cldev = (gx_device_clist *)dev;
+    gx_device_clist_common *cdev = (gx_device_clist_common *)dev;
+    gx_device_clist_reader *crdev = &cldev->reader;
+    clist_band_sched_t *sched = crdev->band_sched;
+    int i;
+
+    if (crdev->render_threads == NULL)
+        return;
+    if (sched == NULL || sched->error < 0) {
+        /* Never got going, or failed: there is nothing worth keeping */
+        clist_free_page_render_threads(dev);
+        return;
+    }
+    clist_recover_page_data(dev);
+    for (i = 0; i < crdev->num_render_threads; i++) {
+        clist_render_thread_control_t *thread = &(crdev->render_threads[i]);
+        gx_device_clist_common *thread_cdev = (gx_device_clist_common *)thread->cdev;
+
+        if (thread->bdev != NULL) {
+            thread_cdev->buf_procs.destroy_buf_device(thread->bdev);
+            thread->bdev = NULL;
+        }
+        if (thread->options) {
+            if (thread->options->free_buffer_fn && thread->buffer)
+                thread->options->free_buffer_fn(thread->options->arg, dev, sched->memory, thread->buffer);
+            thread->buffer = NULL;
+            thread->options = NULL;
+        }
+        clist_detach_thread_device((gx_device *)thread_cdev);
+    }
+    /* Only the threads of the last page are kept */
+    clist_free_idle_render_threads(dev);
+    cdev->idle_render_threads = crdev->render_threads;
+    crdev->render_threads = NULL;
+    crdev->band_sched = NULL;
+
+    clist_reopen_page_files(dev);
+}
+
+/* Shut down the rendering threads (for this page and those kept from     */
+/* earlier pages) and free up the related memory.                         */
 void
 clist_teardown_render_threads(gx_device *dev)
+{
+    gx_device_clist *cldev = (gx_device_clist *)dev;
+    gx_device_clist_reader *crdev = &cldev->reader;
+
+    if (!CLIST_IS_WRITER(cldev) && crdev->render_threads != NULL)
+        clist_free_page_render_threads(dev);
+    clist_free_idle_render_threads(dev);
+}
+
+/* Finish the threads kept between pages, and free them */
+static void
+clist_free_idle_render_threads(gx_device *dev)
+{
+    gx_device_clist_common *cdev = (gx_device_clist_common *)dev;
+    clist_render_thread_control_t *threads = cdev->idle_render_threads;
+    clist_band_sched_t *sched;
+    int i;
+
+    if (threads == NULL)
+        return;
+    cdev->idle_render_threads = NULL;
+    sched = threads[0].sched;
+    gx_monitor_enter(sched->lock);
+    sched->shutdown = true;
+    clist_sched_wake_threads(sched, true);
+    gx_monitor_leave(sched->lock);
+    for (i = 0; i < sched->num_threads; i++) {
+        gp_thread_finish(threads[i].thread);
+        threads[i].thread = NULL;
+    }
+    clist_free_render_thread_array(dev, threads, sched->num_threads);
+    clist_free_band_sched(sched);
+}
+
+/* Compare the color_info the threads were set up for with the device's. */
+/* gx_color_info_equal leaves out the component count and layout.        */
+static bool
+clist_color_info_match(const gx_device_color_info *p1, const gx_device_color_info *p2)
+{
+    int i;
+
+    if (!gx_color_info_equal(p1, p2) ||
+        p1->num_components != p2->num_components ||
+        p1->max_gray != p2->max_gray)
+        return false;
+    for (i = 0; i < p1->num_components; i++)
+        if (p1->comp_shift[i] != p2->comp_shift[i] ||
+            p1->comp_bits[i] != p2->comp_bits[i] ||
+            p1->comp_mask[i] != p2->comp_mask[i])
+            return false;
+    return true;
+}
+
+/* Check whether the idle threads can render the current page */
+static bool
+clist_render_threads_match(gx_device *dev, clist_band_sched_t *sched)
+{
+    gx_device_clist_common *cdev = (gx_device_clist_common *)dev;
+    cmm_dev_profile_t *icc_struct = dev->icc_struct;
+
+    return sched->num_threads_requested == cdev->render_threads_requested &&
+        sched->width == dev->width && sched->height == dev->height &&
+        sched->HWResolution[0] == dev->HWResolution[0] &&
+        sched->HWResolution[1] == dev->HWResolution[1] &&
+        clist_color_info_match(&sched->color_info, &dev->color_info) &&
+        sched->is_planar == dev->is_planar &&
+        sched->interpolate_control == dev->interpolate_control &&
+        sched->nbands == cdev->nbands &&
+        sched->band_params.BandWidth == cdev->page_info.band_params.BandWidth &&
+        sched->band_params.BandHeight == cdev->page_info.band_params.BandHeight &&
+        sched->band_params.BandBufferSpace == cdev->page_info.band_params.BandBufferSpace &&
+        sched->band_params.tile_cache_size == cdev->page_info.band_params.tile_cache_size &&
+        sched->tile_cache_size == cdev->page_info.tile_cache_size &&
+        sched->icc_struct == icc_struct &&
+        (icc_struct == NULL ||
+         (sched->device_profile == icc_struct->device_profile[0] &&
+          sched->proof_profile == icc_struct->proof_profile));
+}
+
+/* Reattach the threads kept from the previous page and start them. */
+/* Returns 1 if the threads were started, 0 if there were no usable */
+/* threads, in which case any kept threads have been freed.         */
+static int
+clist_resume_render_threads(gx_device *dev, int y, gx_process_page_options_t *options)
 {
     gx_device_clist *cldev = (gx_device_clist *)dev;
     gx_device_clist_common *cdev = (gx_device_clist_common *)dev;
     gx_device_clist_reader *crdev = &cldev->reader;
-    gs_memory_t *mem = cdev->bandlist_memory;
+    clist_render_thread_control_t *threads = cdev->idle_render_threads;
+    clist_band_sched_t *sched;
+    int band_height = crdev->page_info.band_params.BandHeight;
+    int i, code = 0;
+
+    if (threads == NULL)
+        return 0;
+    sched = threads[0].sched;
+    if (!clist_render_threads_match(dev, sched) ||
+        ((gx_device_clist_common *)threads[0].cdev)->profile != cdev->profile) {
+        clist_free_idle_render_threads(dev);
+        return 0;
+    }
+    cdev->idle_render_threads = NULL;
+    crdev->render_threads = threads;
+    crdev->num_render_threads = sched->num_threads;
+    crdev->band_sched = sched;
+    crdev->main_thread_data = cdev->data;
+    crdev->thread_lookahead_direction = (y < (cdev->height - 1)) ? 1 : -1;
+
+    for (i = 0; i < sched->num_threads && code >= 0; i++) {
+        clist_render_thread_control_t *thread = &(threads[i]);
+
+        thread->options = options;
+        code = clist_attach_thread_device(dev, thread->cdev);
+        if (code >= 0 && options && options->init_buffer_fn)
+            code = options->init_buffer_fn(options->arg, dev, sched->memory, dev->width,
+                                           band_height, &thread->buffer);
+        if (code >= 0)
+            code = gdev_create_buf_device(cdev->buf_procs.create_buf_device,
+                                &(thread->bdev), thread->cdev, 0, NULL,
+                                thread->memory, &(crdev->color_usage_array[0]));
+    }
+    if (code >= 0)
+        code = clist_init_band_sched_buffers(dev, options);
+    if (code >= 0) {
+        clist_sched_deal_bands(crdev, sched, y / band_height,
+                               crdev->thread_lookahead_direction, cdev->nbands);
+        code = clist_start_render_threads(dev);
+    }
+    if (code < 0) {
+        clist_teardown_render_threads(dev);
+        return 0;
+    }
+    if (gs_debug[':'] != 0)
+        dmprintf1(cdev->bandlist_memory, "%% Reusing %d rendering threads\n", sched->num_threads);
+    return 1;
+}
+
+/* ---------------- Band scheduling ---------------- */
+
+/* Allocate the scheduler, with its slots and band tables, and record the */
+/* configuration the threads are set up for. The slots have band buffers  */
+/* the same size as those of the thread devices, from the thread safe     */
+/* allocator since the buffers are swapped between the threads.           */
+static int
+clist_alloc_band_sched(gx_device *dev, gs_memory_t *mem)
+{
+    gx_device_clist *cldev = (gx_device_clist *)dev;
+    gx_device_clist_reader *crdev = &cldev->reader;
+    gx_device_clist_common *thread_cdev = (gx_device_clist_common *)crdev->render_threads[0].cdev;
+    int num_threads = crdev->num_render_threads;
+    clist_band_sched_t *sched;
     int i;
 
-    if (crdev->render_threads != NULL) {
-        /* Wait for all threads to finish */
-        for (i = (crdev->num_render_threads - 1); i >= 0; i--) {
-            clist_render_thread_control_t *thread = &(crdev->render_threads[i]);
+    sched = (clist_band_sched_t *)gs_alloc_bytes(mem, sizeof(clist_band_sched_t),
+                                                 "clist_alloc_band_sched");
+    if (sched == NULL)
+        return_error(gs_error_VMerror);
+    memset(sched, 0, sizeof(clist_band_sched_t));
+    sched->memory = mem;
+    sched->num_threads = num_threads;
+    sched->num_slots = num_threads * CLIST_BAND_SLOTS_PER_THREAD;
+    sched->threads = crdev->render_threads;
+
+    sched->num_threads_requested = crdev->render_threads_requested;
+    sched->width = dev->width;
+    sched->height = dev->height;
+    sched->HWResolution[0] = dev->HWResolution[0];
+    sched->HWResolution[1] = dev->HWResolution[1];
+    sched->color_info = dev->color_info;
+    sched->is_planar = dev->is_planar;
+    sched->interpolate_control = dev->interpolate_control;
+    sched->nbands = crdev->nbands;
+    sched->band_params = crdev->page_info.band_params;
+    sched->tile_cache_size = crdev->page_info.tile_cache_size;
+    sched->icc_struct = dev->icc_struct;
+    if (dev->icc_struct != NULL) {
+        sched->device_profile = dev->icc_struct->device_profile[0];
+        sched->proof_profile = dev->icc_struct->proof_profile;
+    }
+
+    sched->slots = (clist_band_slot_t *)gs_alloc_byte_array(mem, sched->num_slots,
+                            sizeof(clist_band_slot_t), "clist_alloc_band_sched");
+    sched->cost = (ulong *)gs_alloc_byte_array(mem, crdev->nbands, sizeof(ulong),
+                                               "clist_alloc_band_sched");
+    sched->taken = gs_alloc_bytes(mem, crdev->nbands, "clist_alloc_band_sched");
+    if (sched->slots == NULL || sched->cost == NULL || sched->taken == NULL)
+        goto fail;
+    memset(sched->slots, 0, sched->num_slots * sizeof(clist_band_slot_t));
+    if (gs_debug[':'] != 0) {
+        sched->render_time = (long *)gs_alloc_byte_array(mem, crdev->nbands, sizeof(long),
+                                                         "clist_alloc_band_sched");
+        if (sched->render_time == NULL)
+            goto fail;
+    }
+    for (i = 0; i < sched->num_slots; i++) {
+        clist_band_slot_t *slot = &(sched->slots[i]);
+
+        slot->band = -1;
+        slot->data = slot->alloc_data = gs_alloc_bytes(mem, thread_cdev->data_size,
+                                                       "clist band slot");
+        if (slot->data == NULL)
+            goto fail;
+    }
+    if ((sched->lock = gx_monitor_label(gx_monitor_alloc(mem), "BandSched")) == NULL ||
+        (sched->sema_ready = gx_semaphore_label(gx_semaphore_alloc(mem), "BandReady")) == NULL)
+        goto fail;
+
+    for (i = 0; i < num_threads; i++)
+        crdev->render_threads[i].sched = sched;
+    crdev->band_sched = sched;
+    return 0;
+
+fail:
+    clist_free_band_sched(sched);
+    return_error(gs_error_VMerror);
+}
 
-            if (thread->status == THREAD_BUSY)
-                gx_semaphore_wait(thread->sema_this);
+/* Free the scheduler. The slots' process_page buffers must be freed first */
+static void
+clist_free_band_sched(clist_band_sched_t *sched)
+{
+    gs_memory_t *mem = sched->memory;
+    int i;
+
+    if (sched->slots != NULL) {
+        for (i = 0; i < sched->num_slots; i++)
+            gs_free_object(mem, sched->slots[i].alloc_data, "clist band slot");
+        gs_free_object(mem, sched->slots, "clist_free_band_sched");
+    }
+    gs_free_object(mem, sched->cost, "clist_free_band_sched");
+    gs_free_object(mem, sched->taken, "clist_free_band_sched");
+    gs_free_object(mem, sched->render_time, "clist_free_band_sched");
+    gx_semaphore_free(sched->sema_ready);
+    gx_monitor_free(sched->lock);
+    gs_free_object(mem, sched, "clist_free_band_sched");
+}
+
+/* Allocate the process_page buffers of the slots, for this page only */
+static int
+clist_init_band_sched_buffers(gx_device *dev, gx_process_page_options_t *options)
+{
+    gx_device_clist *cldev = (gx_device_clist *)dev;
+    gx_device_clist_reader *crdev = &cldev->reader;
+    clist_band_sched_t *sched = crdev->band_sched;
+    int i, code;
+
+    if (options == NULL || options->init_buffer_fn == NULL)
+        return 0;
+    for (i = 0; i < sched->num_slots; i++) {
+        code = options->init_buffer_fn(options->arg, dev, sched->memory, dev->width,
+                                       crdev->page_info.band_params.BandHeight,
+                                       &sched->slots[i].buffer);
+        if (code < 0)
+            return code;
+    }
+    return 0;
+}
+
+/* Estimate the cost of rendering a band from the statistics recorded by */
+/* the clist writer, in (very roughly) the time to read a command byte.  */
+static ulong
+clist_band_cost(gx_device_clist_reader *crdev, int band)
+{
+    const gx_color_usage_t *usage = &(crdev->color_usage_array[band]);
+    ulong band_area = (ulong)crdev->width * crdev->page_band_height;
+    ulong cost = usage->cmd_bytes + usage->image_area + usage->path_segments * 16;
+
+    /* Each group or mask is composited over (up to) the whole band, and */
+    /* so is the page group in the bands that use transparency.          */
+    cost += usage->trans_groups * band_area;
+    if (usage->trans_bbox.p.y <= usage->trans_bbox.q.y)
+        cost += band_area;
+    return cost;
+}
+
+/* Deal the bands, in delivery order, round robin to the threads, and set */
+/* their costs. Only called while the threads are stopped.                */
+static void
+clist_sched_deal_bands(gx_device_clist_reader *crdev, clist_band_sched_t *sched,
+                       int first_band, int direction, int band_count)
+{
+    int i;
+
+    sched->first_band = first_band;
+    sched->direction = direction;
+    sched->num_positions = direction > 0 ? band_count - first_band : first_band + 1;
+    sched->num_taken = 0;
+    sched->out_pos = 0;
+    sched->abort = false;
+    sched->error = 0;
+    for (i = 0; i < sched->num_slots; i++)
+        sched->slots[i].band = -1;
+    memset(sched->taken, 0, sched->num_positions);
+    for (i = 0; i < band_count; i++) {
+        sched->cost[i] = crdev->color_usage_array == NULL ? 0 : clist_band_cost(crdev, i);
+        if (sched->render_time != NULL)
+            sched->render_time[i] = -1;
+    }
+}
+
+/* Take the next band for thread 'index'. Called with the lock held.      */
+/* Returns the band, -1 if none may be started until the main thread has  */
+/* collected a band, or -2 if there is nothing more to do.                */
+static int
+clist_sched_take_band(clist_band_sched_t *sched, int index, bool *stolen)
+{
+    int limit = min(sched->out_pos + sched->num_slots, sched->num_positions);
+    int pos, best = -1;
+    ulong best_cost = 0, cost;
+    bool best_own = false, own;
+
+    if (sched->abort || sched->error < 0 || sched->num_taken == sched->num_positions)
+        return -2;
+    /* The most expensive band in the window, our own if there's a tie */
+    for (pos = sched->out_pos; pos < limit; pos++) {
+        if (sched->taken[pos])
+            continue;
+        cost = sched->cost[sched->first_band + pos * sched->direction];
+        own = pos % sched->num_threads == index;
+        if (best < 0 || cost > best_cost || (cost == best_cost && own && !best_own)) {
+            best = pos;
+            best_cost = cost;
+            best_own = own;
         }
-        /* then free each thread's memory */
-        for (i = (crdev->num_render_threads - 1); i >= 0; i--) {
-            clist_render_thread_control_t *thread = &(crdev->render_threads[i]);
-            gx_device_clist_common *thread_cdev = (gx_device_clist_common *)thread->cdev;
-
-            /* Free control semaphores */
-            gx_semaphore_free(thread->sema_group);
-            gx_semaphore_free(thread->sema_this);
-            /* destroy the thread's buffer device */
-            thread_cdev->buf_procs.destroy_buf_device(thread->bdev);
+    }
+    if (best < 0)
+        return -1;
+    *stolen = !best_own;
+    sched->taken[best] = 1;
+    sched->num_taken++;
+    return sched->first_band + best * sched->direction;
+}
 
-            if (thread->options) {
-                if (thread->options->free_buffer_fn && thread->buffer) {
-                    thread->options->free_buffer_fn(thread->options->arg, dev, thread->memory, thread->buffer);
-                    thread->buffer = NULL;
-                }
-                thread->options = NULL;
-            }
+/* Park a band rendered by 'thread' in a free slot, swapping the buffers. */
+/* Called with the lock held. The window in clist_sched_take_band ensures */
+/* that there is always a free slot.                                      */
+static int
+clist_sched_park_band(clist_band_sched_t *sched, clist_render_thread_control_t *thread, int band)
+{
+    gx_device_clist_common *thread_cdev = (gx_device_clist_common *)thread->cdev;
+    int i;
 
-            /* before freeing this device's memory, swap with cdev if it was the main_thread_data */
-            if (thread_cdev->data == crdev->main_thread_data) {
-                thread_cdev->data = cdev->data;
-                cdev->data = crdev->main_thread_data;
-            }
-#ifdef DEBUG
-            if (gs_debug[':'])
-                dmprintf2(thread->memory, "%% Thread %d total usertime=%ld msec\n", i, thread->cputime);
-            dmprintf1(thread->memory, "\nThread %d ", i);
-#endif
-            teardown_device_and_mem_for_thread((gx_device *)thread_cdev, thread->thread, false);
+    for (i = 0; i < sched->num_slots; i++) {
+        clist_band_slot_t *slot = &(sched->slots[i]);
+
+        if (slot->band < 0) {
+            byte *tmp = slot->data;
+            void *buffer = slot->buffer;
+
+            slot->data = thread_cdev->data;
+            thread_cdev->data = tmp;
+            slot->buffer = thread->buffer;
+            thread->buffer = buffer;
+            slot->band = band;
+            return 0;
         }
-        gs_free_object(mem, crdev->render_threads, "clist_teardown_render_threads");
-        crdev->render_threads = NULL;
+    }
+    return_error(gs_error_unknownerror);	/* shouldn't happen */
+}
 
-        /* Now re-open the clist temp files so we can write to them */
-        if (cdev->page_info.cfile == NULL) {
-            char fmode[4];
+/* Wake threads waiting for the window to move, all of them or just one. */
+/* Called with the lock held. Each thread waits on its own semaphore, so  */
+/* that a signal is never shared by several waiters.                      */
+static void
+clist_sched_wake_threads(clist_band_sched_t *sched, bool all)
+{
+    int i;
 
-            strcpy(fmode, "a+");        /* file already exists and we want to re-use it */
-            strncat(fmode, gp_fmode_binary_suffix, 1);
-            cdev->page_info.io_procs->fopen(cdev->page_info.cfname, fmode, &cdev->page_info.cfile,
-                                mem, cdev->bandlist_memory, true);
-            cdev->page_info.io_procs->fseek(cdev->page_info.cfile, 0, SEEK_SET, cdev->page_info.cfname);
-            cdev->page_info.io_procs->fopen(cdev->page_info.bfname, fmode, &cdev->page_info.bfile,
-                                mem, cdev->bandlist_memory, false);
-            cdev->page_info.io_procs->fseek(cdev->page_info.bfile, 0, SEEK_SET, cdev->page_info.bfname);
+    for (i = 0; i < sched->num_threads; i++) {
+        clist_render_thread_control_t *thread = &(sched->threads[i]);
+
+        if (thread->waiting) {
+            thread->waiting = false;
+            gx_semaphore_signal(thread->sema_wake);
+            if (!all)
+                break;
         }
     }
 }
 
+/* Start the threads on the bands that have been dealt. Threads kept from */
+/* an earlier page are woken, the others are created.                     */
 static int
-clist_start_render_thread(gx_device *dev, int thread_index, int band)
+clist_start_render_threads(gx_device *dev)
 {
     gx_device_clist *cldev = (gx_device_clist *)dev;
     gx_device_clist_reader *crdev = &cldev->reader;
-    int code;
+    clist_band_sched_t *sched = crdev->band_sched;
+    int i, code = 0;
 
-    crdev->render_threads[thread_index].band = band;
-    crdev->render_threads[thread_index].status = THREAD_BUSY;
+    gx_monitor_enter(sched->lock);
+    for (i = 0; i < crdev->num_render_threads; i++) {
+        crdev->render_threads[i].band = -1;
+        crdev->render_threads[i].status = THREAD_BUSY;
+    }
+    sched->running = true;
+    clist_sched_wake_threads(sched, true);
+    gx_monitor_leave(sched->lock);
 
-    /* Finally, fire it up */
-    code = gp_thread_start(clist_render_thread,
-                           &(crdev->render_threads[thread_index]),
-                           &(crdev->render_threads[thread_index].thread));
-    gp_thread_label(crdev->render_threads[thread_index].thread, "Band");
+    for (i = 0; i < crdev->num_render_threads; i++) {
+        clist_render_thread_control_t *thread = &(crdev->render_threads[i]);
 
+        if (thread->thread != NULL)
+            continue;
+        /* Finally, fire it up */
+        code = gp_thread_start(clist_render_thread, thread, &(thread->thread));
+        if (code < 0) {
+            thread->status = THREAD_IDLE;
+            thread->thread = NULL;
+            break;
+        }
+        gp_thread_label(thread->thread, "Band");
+    }
     return code;
 }
 
+/* Stop the rendering threads (once their current bands are finished)     */
+/* and wait for them to be idle.                                          */
 static void
-clist_render_thread(void *data)
+clist_stop_render_threads(gx_device *dev)
+{
+    gx_device_clist *cldev = (gx_device_clist *)dev;
+    gx_device_clist_reader *crdev = &cldev->reader;
+    clist_band_sched_t *sched = crdev->band_sched;
+    int i;
+
+    if (sched == NULL || !sched->running)
+        return;
+    gx_monitor_enter(sched->lock);
+    sched->abort = true;
+    clist_sched_wake_threads(sched, true);
+    gx_monitor_leave(sched->lock);
+    for (i = 0; i < crdev->num_render_threads; i++) {
+        clist_render_thread_control_t *thread = &(crdev->render_threads[i]);
+
+        if (thread->thread != NULL)
+            gx_semaphore_wait(thread->sema_this);
+    }
+    sched->running = false;
+}
+
+/* Render one band into the thread's device buffer */
+static int
+clist_render_band(clist_render_thread_control_t *thread, int band)
 {
-    clist_render_thread_control_t *thread = (clist_render_thread_control_t *)data;
     gx_device *dev = thread->cdev;
     gx_device_clist *cldev = (gx_device_clist *)dev;
     gx_device_clist_reader *crdev = &cldev->reader;
@@ -684,15 +1360,10 @@ clist_render_thread(void *data)
     uint raster = gx_device_raster_plane(dev, NULL);
     int code;
     int band_height = crdev->page_band_height;
-    int band = thread->band;
     int band_begin_line = band * band_height;
     int band_end_line = band_begin_line + band_height;
     int band_num_lines;
-#ifdef DEBUG
-    long starttime[2], endtime[2];
 
-    gp_get_usertime(starttime); /* thread start time */
-#endif
     if (band_end_line > dev->height)
         band_end_line = dev->height;
     band_num_lines = band_end_line - band_begin_line;
@@ -713,23 +1384,76 @@ clist_render_thread(void *data)
     crdev->ymin = band_begin_line;
     crdev->ymax = band_end_line;
     crdev->offset_map = NULL;
-    if (code < 0)
-        thread->status = THREAD_ERROR;          /* shouldn't happen */
-    else
-        thread->status = THREAD_DONE;    /* OK */
+    return code;
+}
 
+static void
+clist_render_thread(void *data)
+{
+    clist_render_thread_control_t *thread = (clist_render_thread_control_t *)data;
+    clist_band_sched_t *sched = thread->sched;
+    bool stolen = false;
+    int band, code = 0;
+#ifdef DEBUG
+    long starttime[2], endtime[2];
+
+    gp_get_usertime(starttime); /* thread start time */
+#endif
+    for (;;) {
+        gx_monitor_enter(sched->lock);
+        if (sched->shutdown) {
+            gx_monitor_leave(sched->lock);
+            break;
+        }
+        band = thread->status == THREAD_BUSY ?
+                clist_sched_take_band(sched, thread->index, &stolen) : -1;
+        if (band == -2) {
+            /* No more bands for this page: report and wait for the next */
+            thread->status = code < 0 ? THREAD_ERROR : THREAD_DONE;
+            code = 0;
+            thread->waiting = true;
+            gx_monitor_leave(sched->lock);
+            gx_semaphore_signal(thread->sema_this);
+            gx_semaphore_wait(thread->sema_wake);
+            continue;
+        }
+        thread->waiting = (band == -1);
+        gx_monitor_leave(sched->lock);
+        if (band < 0) {
+            /* Wait for the main thread to collect a band, or for a page */
+            gx_semaphore_wait(thread->sema_wake);
+            continue;
+        }
+        thread->band = band;
+        if (sched->render_time != NULL) {
+            long t0[2], t1[2];
+
+            gp_get_realtime(t0);
+            code = clist_render_band(thread, band);
+            gp_get_realtime(t1);
+            sched->render_time[band] = (t1[0] - t0[0]) * 1000000 + (t1[1] - t0[1]) / 1000;
+        } else
+            code = clist_render_band(thread, band);
+
+        gx_monitor_enter(sched->lock);
+        if (code >= 0)
+            code = clist_sched_park_band(sched, thread, band);
+        if (code < 0 && sched->error == 0)
+            sched->error = code;
+        thread->band = -1;
+        gx_monitor_leave(sched->lock);
+        gx_semaphore_signal(sched->sema_ready);
+        if (code < 0)
+            continue;           /* shouldn't happen */
+        thread->bands_rendered++;
+        if (stolen)
+            thread->bands_stolen++;
+    }
 #ifdef DEBUG
     gp_get_usertime(endtime);
     thread->cputime += (endtime[0] - starttime[0]) * 1000 +
              (endtime[1] - starttime[1]) / 1000000;
 #endif
-    /*
-     * Signal the semaphores. We signal the 'group' first since even if
-     * the waiter is released on the group, it still needs to check
-     * status on the thread
-     */
-    gx_semaphore_signal(thread->sema_group);
-    gx_semaphore_signal(thread->sema_this);
 }
 
 /*
@@ -737,8 +1461,8 @@ clist_render_thread(void *data)
  * device (the main thread)
  * Return 0 if OK, < 0 is the error code from the thread
  *
- * After swapping the pointers, start up the completed thread with the
- * next band remaining to do (if any)
+ * The band is swapped out of the slot it was parked in, and the slot
+ * is freed, which allows the threads to start another band (if any)
  */
 static int
 clist_get_band_from_thread(gx_device *dev, int band_needed, gx_process_page_options_t *options)
@@ -746,88 +1470,79 @@ clist_get_band_from_thread(gx_device *dev, int band_needed, gx_process_page_opti
     gx_device_clist *cldev = (gx_device_clist *)dev;
     gx_device_clist_common *cdev = (gx_device_clist_common *)dev;
     gx_device_clist_reader *crdev = &cldev->reader;
+    clist_band_sched_t *sched = crdev->band_sched;
+    clist_band_slot_t *slot = NULL;
     int i, code = 0;
-    int thread_index = crdev->curr_render_thread;
-    clist_render_thread_control_t *thread = &(crdev->render_threads[thread_index]);
-    gx_device_clist_common *thread_cdev = (gx_device_clist_common *)thread->cdev;
     int band_height = crdev->page_info.band_params.BandHeight;
     int band_count = cdev->nbands;
     byte *tmp;                  /* for swapping data areas */
 
-    /* We expect that the thread needed will be the 'current' thread */
-    if (thread->band != band_needed) {
-        int band = band_needed;
-
-        emprintf3(thread->memory,
-                  "thread->band = %d, band_needed = %d, direction = %d, ",
-                  thread->band, band_needed, crdev->thread_lookahead_direction);
+    /* We expect that the band needed will be the next one delivered */
+    if (band_needed != sched->first_band + sched->out_pos * sched->direction) {
+        emprintf3(dev->memory,
+                  "next band = %d, band_needed = %d, direction = %d, ",
+                  sched->first_band + sched->out_pos * sched->direction,
+                  band_needed, crdev->thread_lookahead_direction);
 
         /* Probably we went in the wrong direction, so let the threads */
-        /* all complete, then restart them in the opposite direction   */
+        /* all stop, then restart them in the opposite direction       */
         /* If the caller is 'bouncing around' we may end up back here, */
         /* but that is a VERY rare case (we haven't seen it yet).      */
-        for (i=0; i < crdev->num_render_threads; i++) {
-            clist_render_thread_control_t *thread = &(crdev->render_threads[i]);
-
-            if (thread->status == THREAD_BUSY)
-                gx_semaphore_wait(thread->sema_this);
-        }
+        clist_stop_render_threads(dev);
         crdev->thread_lookahead_direction *= -1;      /* reverse direction (but may be overruled below) */
         if (band_needed == band_count-1)
             crdev->thread_lookahead_direction = -1;   /* assume backwards if we are asking for the last band */
         if (band_needed == 0)
             crdev->thread_lookahead_direction = 1;    /* force forward if we are looking for band 0 */
 
-        dmprintf1(thread->memory, "new_direction = %d\n", crdev->thread_lookahead_direction);
+        dmprintf1(dev->memory, "new_direction = %d\n", crdev->thread_lookahead_direction);
 
-        /* Loop starting the threads in the new lookahead_direction */
-        for (i=0; (i < crdev->num_render_threads) && (band >= 0) && (band < band_count);
-                i++, band += crdev->thread_lookahead_direction) {
-            thread = &(crdev->render_threads[i]);
-            thread->band = -1;          /* a value that won't match any valid band */
-            /* Start thread 'i' to do band */
-            if ((code = clist_start_render_thread(dev, i, band)) < 0)
+        clist_sched_deal_bands(crdev, sched, band_needed, crdev->thread_lookahead_direction, band_count);
+        if ((code = clist_start_render_threads(dev)) < 0)
+            return code;
+    }
+    /* Wait for the band to be parked */
+    for (;;) {
+        gx_monitor_enter(sched->lock);
+        for (i = 0; i < sched->num_slots; i++) {
+            if (sched->slots[i].band == band_needed) {
+                slot = &(sched->slots[i]);
                 break;
+            }
         }
-        crdev->next_band = i;			/* may be < 0 or == band_count, but that is handled later */
-        crdev->curr_render_thread = thread_index = 0;
-        thread = &(crdev->render_threads[0]);
-        thread_cdev = (gx_device_clist_common *)thread->cdev;
+        code = sched->error;
+        gx_monitor_leave(sched->lock);
+        if (slot != NULL || code < 0)
+            break;
+        gx_semaphore_wait(sched->sema_ready);
     }
-    /* Wait for this thread */
-    gx_semaphore_wait(thread->sema_this);
-    gp_thread_finish(thread->thread);
-    thread->thread = NULL;
-    if (thread->status == THREAD_ERROR)
+    if (slot == NULL)
         return_error(gs_error_unknownerror);          /* FAIL */
 
     if (options && options->output_fn) {
-        code = options->output_fn(options->arg, dev, thread->buffer);
+        code = options->output_fn(options->arg, dev, slot->buffer);
         if (code < 0)
             return code;
     }
 
     /* Swap the data areas to avoid the copy */
     tmp = cdev->data;
-    cdev->data = thread_cdev->data;
-    thread_cdev->data = tmp;
-    thread->status = THREAD_IDLE;        /* the data is no longer valid */
-    thread->band = -1;
+    cdev->data = slot->data;
+    slot->data = tmp;
     /* Update the bounds for this band */
     cdev->ymin =  band_needed * band_height;
     cdev->ymax =  cdev->ymin + band_height;
     if (cdev->ymax > dev->height)
         cdev->ymax = dev->height;
 
-    if (crdev->next_band >= 0 && crdev->next_band < band_count) {
-        code = clist_start_render_thread(dev, thread_index, crdev->next_band);
-        crdev->next_band += crdev->thread_lookahead_direction;
-    }
-    /* bump the 'curr' to the next thread */
-    crdev->curr_render_thread = crdev->curr_render_thread == crdev->num_render_threads - 1 ?
-                0 : crdev->curr_render_thread + 1;
+    /* Free the slot, which moves the window on for the threads */
+    gx_monitor_enter(sched->lock);
+    slot->band = -1;
+    sched->out_pos++;
+    clist_sched_wake_threads(sched, false);
+    gx_monitor_leave(sched->lock);
 
-    return code;
+    return 0;
 }
 
 /* Copy a rasterized rectangle to the client, rasterizing if needed. */
@@ -837,7 +1552,6 @@ static int
 clist_get_bits_rect_mt(gx_device *dev, const gs_int_rect * prect,
                          gs_get_bits_params_t *params, gs_int_rect **unread)
 {
-    gx_device_printer *pdev = (gx_device_printer *)dev;
     gx_device_clist *cldev = (gx_device_clist *)dev;
     gx_device_clist_common *cdev = (gx_device_clist_common *)dev;
     gx_device_clist_reader *crdev = &cldev->reader;
@@ -858,7 +1572,7 @@ clist_get_bits_rect_mt(gx_device *dev, const gs_int_rect * prect,
 
     /* This page might not want multiple threads */
     /* Also we don't support plane extraction using multiple threads */
-    if (pdev->num_render_threads_requested < 1 || (options & GB_SELECT_PLANES))
+    if (cdev->render_threads_requested < 1 || (options & GB_SELECT_PLANES))
         return clist_get_bits_rectangle(dev, prect, params, unread);
 
     if (prect->p.x < 0 || prect->q.x > dev->width ||
@@ -976,6 +1690,9 @@ clist_process_page(gx_device *dev, gx_process_page_options_t *options)
     int y;
     int line_count;
     int band_height = crdev->page_band_height;
+    int num_bands = (dev->height + band_height - 1) / band_height;
+    int reverse = !!(options->options & GX_PROCPAGE_BOTTOM_UP);
+    int i, band;
     gs_int_rect band_rect;
     int lines_rasterized;
     gx_device *bdev;
@@ -994,17 +1711,20 @@ clist_process_page(gx_device *dev, gx_process_page_options_t *options)
     }
 
     render_plane.index = -1;
-    for (y = 0; y < dev->height; y += lines_rasterized)
+    /* One band at a time, in the same order as clist_process_page_mt */
+    for (i = 0; i < num_bands; i++)
     {
+        band = reverse ? num_bands - 1 - i : i;
+        y = band * band_height;
         line_count = band_height;
         if (line_count > dev->height - y)
             line_count = dev->height - y;
         code = gdev_create_buf_device(cdev->buf_procs.create_buf_device,
                                       &bdev, cdev->target, y, &render_plane,
                                       dev->memory,
-                                      &(crdev->color_usage_array[y/band_height]));
+                                      &(crdev->color_usage_array[band]));
         if (code < 0)
-            return code;
+            break;
         code = clist_rasterize_lines(dev, y, line_count, bdev, &render_plane, &my);
         if (code >= 0)
         {
@@ -1035,7 +1755,6 @@ clist_process_page(gx_device *dev, gx_process_page_options_t *options)
 static int
 clist_process_page_mt(gx_device *dev, gx_process_page_options_t *options)
 {
-    gx_device_printer *pdev = (gx_device_printer *)dev;
     gx_device_clist *cldev = (gx_device_clist *)dev;
     gx_device_clist_reader *crdev = &cldev->reader;
     int band_height = crdev->page_info.band_params.BandHeight;
@@ -1046,7 +1765,7 @@ clist_process_page_mt(gx_device *dev, gx_process_page_options_t *options)
 
     /* This page might not want multiple threads */
     /* Also we don't support plane extraction using multiple threads */
-    if (pdev->num_render_threads_requested < 1)
+    if (crdev->render_threads_requested < 1)
         return clist_process_page(dev, options);
 
     if ((code = clist_close_writer_and_init_reader(cldev)) < 0)
@@ -1059,7 +1778,7 @@ clist_process_page_mt(gx_device *dev, gx_process_page_options_t *options)
 
     if (reverse)
     {
-        for (band = num_bands-1; band > 0; band--)
+        for (band = num_bands-1; band >= 0; band--)
         {
             code = clist_get_band_from_thread(dev, band, options);
             if (code < 0)
@@ -1076,7 +1795,11 @@ clist_process_page_mt(gx_device *dev, gx_process_page_options_t *options)
         }
     }
 
-    /* Always free up thread stuff before exiting*/
+    /* Keep the threads for the next page */
+    clist_finish_render_threads(dev);
+    return code;
+
+    /* Free up thread stuff on an error */
 free_thread_out:
     clist_teardown_render_threads(dev);
     return code;
@@ -1088,11 +1811,12 @@ test_threads(void *dummy)
 }
 
 int
-clist_enable_multi_thread_render(gx_device *dev)
+clist_enable_multi_thread_render(gx_device *dev, int num_threads)
 {
     int code = -1;
     gp_thread_id thread;
 
+    ((gx_device_clist_common *)dev)->render_threads_requested = num_threads;
     if (dev->procs.get_bits_rectangle == clist_get_bits_rect_mt)
         return 1;	/* no need to test again */
     /* We need to test gp_thread_start since we may be on a platform  */
@@ -38,6 +38,73 @@ gx_device * setup_device_and_mem_for_thread(gs_memory_t *chunk_base_mem, gx_devi
 /* Exported for use by background printing.                             */
 void teardown_device_and_mem_for_thread(gx_device *dev, gp_thread_id thread_id, bool bg_print);
 
+/*
+ * Band scheduling for multi-threaded rendering.
+ *
+ * There are no per-thread queues: the bands of the page have a single
+ * array of 'taken' flags, indexed by delivery position, under the sched
+ * lock. A rendering thread takes the band with the highest cost estimate
+ * (from the statistics the clist writer keeps in the per band color_usage)
+ * among those not yet taken within the window. Positions are assigned
+ * round robin to the threads only to break ties, so a thread prefers its
+ * own positions when costs are equal; taking another thread's position is
+ * counted as 'stolen' in the -Z: statistics. So the expensive bands start
+ * first, and one slow band no longer stalls the bands behind it.
+ *
+ * A rendered band is 'parked' in a slot (by swapping band buffers) until
+ * the main thread collects it, always in band order. Bands are only
+ * started within a window of num_slots bands from the next band to be
+ * delivered, which bounds the memory used and guarantees a free slot.
+ *
+ * At the end of a page the threads are not finished: they wait, with
+ * their devices detached from the page, in the pool kept in the clist
+ * device's idle_render_threads. The next page with the same configuration
+ * reattaches the devices and wakes the threads, saving the cloning of the
+ * devices, their allocators and link caches, and the thread creation.
+ */
+typedef struct clist_band_slot_s {
+    int band;			/* band held, -1 if the slot is free */
+    byte *data;			/* band buffer (swapped with the devices) */
+    byte *alloc_data;		/* buffer allocated for the slot */
+    void *buffer;		/* process_page buffer for 'band' */
+} clist_band_slot_t;
+
+struct clist_band_sched_s {
+    gs_memory_t *memory;	/* thread safe allocator for the sched */
+    gx_monitor_t *lock;		/* protects everything below */
+    gx_semaphore_t *sema_ready;	/* signalled when a band is parked */
+    int num_threads;
+    int num_slots;
+    clist_band_slot_t *slots;
+    ulong *cost;		/* estimated cost of each band */
+    long *render_time;		/* usec to render each band, only with -Z: */
+    byte *taken;		/* flags the delivery positions started */
+    int num_taken;
+    int first_band;		/* band at delivery position 0 */
+    int direction;		/* +1 or -1 */
+    int num_positions;		/* bands to deliver in this direction */
+    int out_pos;		/* position of the next band to deliver */
+    bool abort;			/* stop taking bands */
+    int error;			/* first error from a thread, 0 if none */
+    bool running;		/* the threads are rendering a page */
+    bool shutdown;		/* the threads must exit */
+    clist_render_thread_control_t *threads;
+    /* The configuration the thread devices were set up for, which must */
+    /* match for them to be reused for another page.                    */
+    int width, height;
+    float HWResolution[2];
+    gx_device_color_info color_info;
+    int is_planar;
+    int interpolate_control;
+    int nbands;
+    gx_band_params_t band_params;
+    uint tile_cache_size;
+    int num_threads_requested;
+    cmm_dev_profile_t *icc_struct;
+    cmm_profile_t *device_profile;
+    cmm_profile_t *proof_profile;
+};
+
 /* Following is used for clist background printing and multi-threaded rendering */
 typedef enum {
     THREAD_ERROR = -1,
@@ -51,10 +118,15 @@ struct clist_render_thread_control_s {
                                 /* values allow waiting until status < 2 */
     gs_memory_t *memory;	/* thread's 'chunk' memory allocator */
     gx_semaphore_t *sema_this;
-    gx_semaphore_t *sema_group;
     gx_device *cdev;	/* clist device copy */
     gx_device *bdev;	/* this thread's buffer device */
-    int band;
+    int band;		/* band being rendered, -1 if none */
+    int index;		/* index of this thread (for tie breaks) */
+    clist_band_sched_t *sched;	/* scheduler shared with the main thread */
+    gx_semaphore_t *sema_wake;	/* signalled when the band window moves */
+    bool waiting;		/* waiting on sema_wake (under sched->lock) */
+    int bands_rendered;	/* statistics, reported with -Z: */
+    int bands_stolen;
     gp_thread_id thread;
 
     /* For process_page mode */
@@ -184,6 +184,11 @@ cmd_write_band(gx_device_clist_writer * cldev, int band_min, int band_max,
                   band_min, band_max, cb.pos);
         cldev->page_info.io_procs->fwrite_chars(&cb, sizeof(cb), bfile);
         if (cp != 0) {
+            /* Commands for a range of bands cost the same for all of them */
+            /* so we only count those for single bands.                    */
+            gx_color_usage_t *usage = (band_min == band_max && band_min < cldev->nbands ?
+                                       &cldev->states[band_min].color_usage : NULL);
+
             pcl->tail->next = 0;	/* terminate the list */
             for (; cp != 0; cp = cp->next) {
 #ifdef DEBUG
@@ -198,6 +203,8 @@ cmd_write_band(gx_device_clist_writer * cldev, int band_min, int band_max,
                 if_debug2m('L', cldev->memory, "[L]Wrote cmd id=%ld at %"PRId64"\n",
                            cp->id, cldev->page_info.io_procs->ftell(cfile));
                 cldev->page_info.io_procs->fwrite_chars(cp + 1, cp->size, cfile);
+                if (usage != NULL)
+                    usage->cmd_bytes += cp->size;
             }
             pcl->head = pcl->tail = 0;
         }
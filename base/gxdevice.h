@@ -302,6 +302,12 @@ dev_proc_fill_rectangle_hl_color(gx_default_fill_rectangle_hl_color);
 dev_proc_include_color_space(gx_default_include_color_space);
 dev_proc_fill_linear_color_scanline(gx_default_fill_linear_color_scanline);
 dev_proc_fill_linear_color_scanline(gx_hl_fill_linear_color_scanline);
+/* gx_default_fill_linear_color_scanline with the runs of constant color
+   filled by fill_run rather than by the device's fill_rectangle. */
+int gx_fill_linear_color_scanline_runs(gx_device *dev, const gs_fill_attributes *fa,
+        int i0, int j, int w,
+        const frac31 *c0, const int32_t *c0f, const int32_t *cg_num, int32_t cg_den,
+        dev_proc_fill_rectangle((*fill_run)));
 dev_proc_fill_linear_color_trapezoid(gx_default_fill_linear_color_trapezoid);
 dev_proc_fill_linear_color_triangle(gx_default_fill_linear_color_triangle);
 dev_proc_update_spot_equivalent_colors(gx_default_update_spot_equivalent_colors);
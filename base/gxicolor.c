@@ -440,6 +440,237 @@ decode_row(const gx_image_enum *penum, const byte *psrc, int spp, byte *pdes,
     }
 }
 
+/* Pack a pixel of (at most 4) 8 bit components into a bits32 */
+static forceinline bits32
+image_icc_cache_pack(const byte *p, int n)
+{
+    switch (n) {
+        case 1:
+            return p[0];
+        case 2:
+            return p[0] | ((bits32)p[1] << 8);
+        case 3:
+            return p[0] | ((bits32)p[1] << 8) | ((bits32)p[2] << 16);
+        default:
+            return p[0] | ((bits32)p[1] << 8) | ((bits32)p[2] << 16) |
+                   ((bits32)p[3] << 24);
+    }
+}
+
+#define IMAGE_ICC_CACHE_SLOT(key)\
+  ((uint)((((key) * (bits32)0x9e3779b1) & 0xffffffff) >>\
+          (32 - GX_IMAGE_ICC_CACHE_BITS)))
+
+/* Check whether the cache is worth keeping every this many rows */
+#define IMAGE_ICC_CACHE_CHECK_ROWS 16
+
+/* Collect the pixels of a row that are not in the cache into miss_src,
+   claiming entries for them, and return how many there are.  Only the
+   first pixel of each run of equal pixels is looked up.  An entry holds
+   only one colour in any row, so a colour whose entry was claimed by
+   another colour of the row is converted without going into the cache
+   (its miss_slot is GX_IMAGE_ICC_CACHE_SIZE). */
+static forceinline int
+image_icc_cache_collect(gx_image_icc_cache_t *cache, const byte *psrc,
+                        int width, const int spp)
+{
+    uint row = cache->row, slot;
+    bits32 key, prev = ~image_icc_cache_pack(psrc, spp);
+    byte *miss = cache->miss_src;
+    int k, j, num_miss = 0;
+
+    for (k = 0; k < width; k++, psrc += spp) {
+        key = image_icc_cache_pack(psrc, spp);
+        if (key == prev)
+            continue;
+        prev = key;
+        slot = IMAGE_ICC_CACHE_SLOT(key);
+        if (cache->stamp[slot] == row) {
+            if (cache->key[slot] == key)
+                continue;
+            slot = GX_IMAGE_ICC_CACHE_SIZE;
+        } else {
+            cache->stamp[slot] = row;
+            if (cache->valid[slot] && cache->key[slot] == key)
+                continue;
+            cache->key[slot] = key;
+            cache->valid[slot] = false;
+        }
+        for (j = 0; j < spp; j++)
+            *miss++ = psrc[j];
+        cache->miss_slot[num_miss++] = slot;
+    }
+    return num_miss;
+}
+
+/* Write out the conversion of a row, once all its colours are in the
+   cache, or among the misses that aren't, in the order collected. */
+static forceinline void
+image_icc_cache_fill(const gx_image_icc_cache_t *cache, const byte *psrc,
+                     int width, const int spp, byte *pdes, const int spp_cm,
+                     int planestride)
+{
+    bits32 key, prev = ~image_icc_cache_pack(psrc, spp), value = 0;
+    uint slot;
+    int k, j, m = 0;
+
+#define IMAGE_ICC_CACHE_LOOKUP()\
+    key = image_icc_cache_pack(psrc, spp);\
+    if (key != prev) {\
+        prev = key;\
+        slot = IMAGE_ICC_CACHE_SLOT(key);\
+        if (cache->key[slot] == key)\
+            value = cache->value[slot];\
+        else {\
+            while (cache->miss_slot[m] < GX_IMAGE_ICC_CACHE_SIZE)\
+                m++;\
+            value = image_icc_cache_pack(cache->miss_des + m * spp_cm, spp_cm);\
+            m++;\
+        }\
+    }
+
+    if (planestride == 0) {
+        for (k = 0; k < width; k++, psrc += spp) {
+            IMAGE_ICC_CACHE_LOOKUP();
+            for (j = 0; j < spp_cm; j++)
+                *pdes++ = (byte)(value >> (8 * j));
+        }
+    } else {
+        for (k = 0; k < width; k++, psrc += spp) {
+            IMAGE_ICC_CACHE_LOOKUP();
+            for (j = 0; j < spp_cm; j++)
+                pdes[j * planestride] = (byte)(value >> (8 * j));
+            pdes++;
+        }
+    }
+#undef IMAGE_ICC_CACHE_LOOKUP
+}
+
+/* Convert a row of width pixels through the ICC link, using the image's
+   conversion cache.  Only the first pixel of each run of equal pixels is
+   looked up in the cache, and only the pixels that are not found there
+   are converted, packed together into one call to the link.  The output
+   is chunky, or planar with planes planestride apart if planestride is
+   not 0.  Returns 1 if the row was converted, 0 if the caller should
+   convert it instead, because the cache can't be allocated or isn't
+   paying for itself in this image. */
+static int
+image_color_icc_cached(gx_image_enum *penum, gx_device *dev,
+                       const byte *psrc, int width, int spp,
+                       byte *pdes, int spp_cm, int planestride)
+{
+    gx_image_icc_cache_t *cache = penum->icc_cache;
+    gsicc_bufferdesc_t input_buff_desc;
+    gsicc_bufferdesc_t output_buff_desc;
+    uint slot;
+    int j, num_miss, code;
+
+    if (width <= 0)
+        return 0;
+    if (cache == NULL) {
+        gs_memory_t *mem = penum->memory->non_gc_memory;
+
+        cache = (gx_image_icc_cache_t *)gs_alloc_bytes(mem, sizeof(*cache),
+                                                "image_color_icc_cached");
+        if (cache == NULL)
+            return 0;
+        memset(cache->stamp, 0, sizeof(cache->stamp));
+        memset(cache->valid, 0, sizeof(cache->valid));
+        cache->row = 0;
+        cache->max_width = width;
+        cache->miss_src = gs_alloc_bytes(mem, (size_t)width * spp,
+                                         "image_color_icc_cached");
+        cache->miss_des = gs_alloc_bytes(mem, (size_t)width * spp_cm,
+                                         "image_color_icc_cached");
+        cache->miss_slot = (ushort *)gs_alloc_bytes(mem,
+                                         (size_t)width * sizeof(ushort),
+                                         "image_color_icc_cached");
+        cache->disabled = (cache->miss_src == NULL ||
+                           cache->miss_des == NULL ||
+                           cache->miss_slot == NULL);
+        cache->pixels = 0;
+        cache->mapped = 0;
+        penum->icc_cache = cache;
+    }
+    /* Give up on images where most pixels miss, the cache then only adds
+       to the cost of the conversion. */
+    if (!cache->disabled && cache->row > 0 &&
+        (cache->row % IMAGE_ICC_CACHE_CHECK_ROWS) == 0 &&
+        cache->mapped > cache->pixels / 4 * 3)
+        cache->disabled = true;
+    cache->pixels += width;
+    if (cache->disabled || width > cache->max_width) {
+        cache->mapped += width;
+        return 0;
+    }
+    cache->row++;
+
+    /* The common cases get their own copies of the loops */
+    switch (spp) {
+        case 1:
+            num_miss = image_icc_cache_collect(cache, psrc, width, 1);
+            break;
+        case 3:
+            num_miss = image_icc_cache_collect(cache, psrc, width, 3);
+            break;
+        case 4:
+            num_miss = image_icc_cache_collect(cache, psrc, width, 4);
+            break;
+        default:
+            num_miss = image_icc_cache_collect(cache, psrc, width, spp);
+            break;
+    }
+    if (num_miss > 0) {
+        gsicc_init_buffer(&input_buff_desc, spp, 1, false, false, false, 0,
+                          num_miss * spp, 1, num_miss);
+        gsicc_init_buffer(&output_buff_desc, spp_cm, 1, false, false, false, 0,
+                          num_miss * spp_cm, 1, num_miss);
+        code = (penum->icc_link->procs.map_buffer)(dev, penum->icc_link,
+                                                   &input_buff_desc,
+                                                   &output_buff_desc,
+                                                   (void *)cache->miss_src,
+                                                   (void *)cache->miss_des);
+        if (code < 0)
+            return code;
+        for (j = 0; j < num_miss; j++) {
+            slot = cache->miss_slot[j];
+            if (slot < GX_IMAGE_ICC_CACHE_SIZE) {
+                cache->value[slot] =
+                    image_icc_cache_pack(cache->miss_des + j * spp_cm, spp_cm);
+                cache->valid[slot] = true;
+            }
+        }
+        cache->mapped += num_miss;
+    }
+
+    /* Now every colour of the row is in the cache, or among the misses */
+    switch (spp * 8 + spp_cm) {
+        case 3 * 8 + 1:
+            image_icc_cache_fill(cache, psrc, width, 3, pdes, 1, planestride);
+            break;
+        case 3 * 8 + 3:
+            image_icc_cache_fill(cache, psrc, width, 3, pdes, 3, planestride);
+            break;
+        case 3 * 8 + 4:
+            image_icc_cache_fill(cache, psrc, width, 3, pdes, 4, planestride);
+            break;
+        case 4 * 8 + 1:
+            image_icc_cache_fill(cache, psrc, width, 4, pdes, 1, planestride);
+            break;
+        case 4 * 8 + 3:
+            image_icc_cache_fill(cache, psrc, width, 4, pdes, 3, planestride);
+            break;
+        case 4 * 8 + 4:
+            image_icc_cache_fill(cache, psrc, width, 4, pdes, 4, planestride);
+            break;
+        default:
+            image_icc_cache_fill(cache, psrc, width, spp, pdes, spp_cm,
+                                 planestride);
+            break;
+    }
+    return 1;
+}
+
 /* Common code shared amongst the thresholding and non thresholding color image
    renderers */
 static int
@@ -460,6 +691,7 @@ image_color_icc_prep(gx_image_enum *penum_orig, const byte *psrc, uint w,
     cmm_dev_profile_t *dev_profile;
     byte *psrc_decode;
     const byte *planar_src;
+    const byte *cm_src;
     byte *planar_des;
     int j, k;
 
@@ -550,11 +782,9 @@ image_color_icc_prep(gx_image_enum *penum_orig, const byte *psrc, uint w,
                               false, false, true, span, span,
                               1, width);
             }
-            /* For now, just blast it all through the link. If we had a significant reduction
-               we will want to repack the data first and then do this.  That will be
-               an optimization shortly.  For now just allocate a new output
-               buffer.  We can reuse the old one if the number of channels in the output is
-               less than or equal to the new one.  */
+            /* Allocate a new output buffer.  We could reuse the old one if the
+               number of channels in the output is less than or equal to the
+               new one.  */
             if (need_decode) {
                 /* Need decode and CM.  This is slow but does not happen that often */
                 psrc_decode = gs_alloc_bytes(pgs->memory, w,
@@ -566,20 +796,30 @@ image_color_icc_prep(gx_image_enum *penum_orig, const byte *psrc, uint w,
                     decode_row_cie(penum, psrc, spp, psrc_decode,
                                     psrc_decode+w, get_cie_range(penum->pcs));
                 }
-                (penum->icc_link->procs.map_buffer)(dev, penum->icc_link,
-                                                    &input_buff_desc,
-                                                    &output_buff_desc,
-                                                    (void*) psrc_decode,
-                                                    (void*) *psrc_cm);
-                gs_free_object(pgs->memory, psrc_decode, "image_color_icc_prep");
+                cm_src = psrc_decode;
             } else {
                 /* CM only. No decode */
+                psrc_decode = NULL;
+                cm_src = psrc;
+            }
+            /* Images with few colours, or long runs of one, go through the
+               conversion cache, which only converts the colours it hasn't
+               seen yet. */
+            code = 0;
+            if (spp <= 4 && spp_cm <= 4)
+                code = image_color_icc_cached(penum_orig, dev, cm_src,
+                                              width, spp, *psrc_cm, spp_cm,
+                                              force_planar ? span : 0);
+            if (code == 0)
                 (penum->icc_link->procs.map_buffer)(dev, penum->icc_link,
                                                     &input_buff_desc,
                                                     &output_buff_desc,
-                                                    (void*) psrc,
+                                                    (void*) cm_src,
                                                     (void*) *psrc_cm);
-            }
+            if (psrc_decode != NULL)
+                gs_free_object(pgs->memory, psrc_decode, "image_color_icc_prep");
+            if (code < 0)
+                return code;
         }
     }
     *spp_cm_out = spp_cm;
@@ -505,6 +505,21 @@ gx_image1_end_image(gx_image_enum_common_t * info, bool draw_last)
     if (penum->icc_link != NULL) {
         gsicc_release_link(penum->icc_link);
     }
+    if (penum->icc_cache != NULL) {
+        gx_image_icc_cache_t *cache = penum->icc_cache;
+        gs_memory_t *cmem = mem->non_gc_memory;
+
+        if_debug4m(gs_debug_flag_icc, mem,
+                   "[icc]image conversion cache: %ld pixels, %ld converted, hit rate %d%%%s\n",
+                   cache->pixels, cache->mapped,
+                   cache->pixels == 0 ? 0 :
+                       (int)((cache->pixels - cache->mapped) * 100.0 / cache->pixels),
+                   cache->disabled ? " (disabled)" : "");
+        gs_free_object(cmem, cache->miss_slot, "image icc cache");
+        gs_free_object(cmem, cache->miss_des, "image icc cache");
+        gs_free_object(cmem, cache->miss_src, "image icc cache");
+        gs_free_object(cmem, cache, "image icc cache");
+    }
     if (penum->color_cache != NULL) {
         gs_free_object(mem, penum->color_cache->device_contone,
                         "device_contone");
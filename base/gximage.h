@@ -151,6 +151,32 @@ typedef struct gx_image_color_cache_s {
     byte *device_contone;
 } gx_image_color_cache_t;
 
+/*
+ * A direct mapped cache of the ICC conversions of the pixels of an 8 bit
+ * colour image, for images with few distinct colours or with long runs of
+ * one colour (screenshots, scanned documents).  See image_color_icc_prep.
+ * It is only used when the source and the device both have at most 4
+ * components, so that a pixel packs into a bits32.  It lives in non-gc
+ * memory.
+ */
+#define GX_IMAGE_ICC_CACHE_BITS 10
+#define GX_IMAGE_ICC_CACHE_SIZE (1 << GX_IMAGE_ICC_CACHE_BITS)
+typedef struct gx_image_icc_cache_s {
+    bits32 key[GX_IMAGE_ICC_CACHE_SIZE];    /* source pixel */
+    bits32 value[GX_IMAGE_ICC_CACHE_SIZE];  /* device pixel */
+    uint stamp[GX_IMAGE_ICC_CACHE_SIZE];    /* row last used in, 0 if none */
+    bool valid[GX_IMAGE_ICC_CACHE_SIZE];    /* value is set */
+    uint row;
+    int max_width;              /* pixels the miss buffers hold */
+    byte *miss_src;             /* source pixels not found in the cache */
+    byte *miss_des;             /* ... and their conversions */
+    ushort *miss_slot;          /* ... and their entries */
+    bool disabled;              /* not paying for itself in this image */
+    /* Statistics, reported at the end of the image */
+    long pixels;                /* pixels converted */
+    long mapped;                /* pixels that went through the link */
+} gx_image_icc_cache_t;
+
 /* Main state structure */
 
 typedef struct gx_device_rop_texture_s gx_device_rop_texture;
@@ -282,6 +308,8 @@ struct gx_image_enum_s {
     gx_device_color *icolor0;
     gx_device_color *icolor1;
     gsicc_link_t *icc_link; /* ICC link to avoid recreation with every line */
+    gx_image_icc_cache_t *icc_cache; /* Conversions of recent pixels, not */
+                                     /* traced, allocated from non-gc memory */
     gx_image_color_cache_t *color_cache;  /* A cache that is con-tone values */
     byte *ht_buffer;            /* A buffer to contain halftoned data */
     int ht_stride;
@@ -811,6 +811,7 @@ gx_image_enum_begin(gx_device * dev, const gs_gstate * pgs,
     penum->buffer_size = bsize;
     penum->line = NULL;
     penum->icc_link = NULL;
+    penum->icc_cache = NULL;
     penum->color_cache = NULL;
     penum->ht_buffer = NULL;
     penum->thresh_buffer = NULL;
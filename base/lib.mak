@@ -55,7 +55,8 @@ GLCCSHARED=$(CC_SHARED) $(GLCCFLAGS)
 # We can't use $(CC_) for GLLCMS2MTCC because that includes /Za on
 # msvc builds, and lcms configures itself to depend on msvc extensions
 # (inline asm, including windows.h) when compiled under msvc.
-GLLCMS2MTCC=$(CC) $(LCMS2MT_CFLAGS) $(CFLAGS) $(I_)$(GLI_) $(II)$(LCMS2MTSRCDIR)$(D)include$(_I) $(GLF_)
+# $(CAPOPT) is needed for HAVE_SSE2, as in LCMS2_CC.
+GLLCMS2MTCC=$(CC) $(LCMS2MT_CFLAGS) $(GENOPT) $(CAPOPT) $(CFLAGS) $(I_)$(GLI_) $(II)$(LCMS2MTSRCDIR)$(D)include$(_I) $(GLF_)
 lcms2mt_h=$(LCMS2MTSRCDIR)$(D)include$(D)lcms2mt.h
 lcms2mt_plugin_h=$(LCMS2MTSRCDIR)$(D)include$(D)lcms2mt_plugin.h
 icc34_h=$(GLSRC)icc34.h
@@ -603,6 +604,7 @@ spngpx_h=$(GLSRC)spngpx.h
 spprint_h=$(GLSRC)spprint.h
 spsdf_h=$(GLSRC)spsdf.h
 srlx_h=$(GLSRC)srlx.h
+sblzx_h=$(GLSRC)sblzx.h $(scommon_h)
 spwgx_h=$(GLSRC)spwgx.h
 surfx_h=$(SURFX_H)
 sstring_h=$(GLSRC)sstring.h
@@ -715,7 +717,7 @@ $(GLOBJ)gxcht.$(OBJ) : $(GLSRC)gxcht.c $(AK) $(gx_h) $(gserrors_h)\
 
 $(GLOBJ)gxclip.$(OBJ) : $(GLSRC)gxclip.c $(AK) $(gx_h)\
  $(gxclip_h) $(gxcpath_h) $(gxdevice_h) $(gxpath_h) $(gzcpath_h)\
- $(LIB_MAK) $(MAKEDIRS)
+ $(gxdevsop_h) $(LIB_MAK) $(MAKEDIRS)
 	$(GLCC) $(GLO_)gxclip.$(OBJ) $(C_) $(GLSRC)gxclip.c
 
 $(GLOBJ)gxcmap.$(OBJ) : $(GLSRC)gxcmap.c $(AK) $(gx_h) $(gserrors_h)\
@@ -2086,7 +2088,7 @@ $(GLD)page.dev : $(LIB_MAK) $(ECHOGS_XE) $(page_) $(LIB_MAK) $(MAKEDIRS)
 $(GLOBJ)gdevprn.$(OBJ) : $(GLSRC)gdevprn.c $(ctype__h) $(gdevprn_h) $(gp_h)\
  $(gsdevice_h) $(gsfname_h) $(gsparam_h) $(gxclio_h) $(gxgetbit_h)\
  $(gdevplnx_h) $(gstrans_h) $(gdevkrnlsclass_h) $(gxdownscale_h) $(gdevdevn_h)\
- $(gxdevsop_h) $(gsbitops_h) $(LIB_MAK) $(MAKEDIRS)
+ $(gxdevsop_h) $(gsbitops_h) $(gxclprof_h) $(LIB_MAK) $(MAKEDIRS)
 	$(GLCC) $(GLO_)gdevprn.$(OBJ) $(C_) $(GLSRC)gdevprn.c
 
 $(GLOBJ)gdevmplt.$(OBJ) : $(GLSRC)gdevmplt.c $(gdevmplt_h) $(gdevp14_h)\
@@ -2169,9 +2171,11 @@ $(GLD)imasklib.dev : $(LIB_MAK) $(ECHOGS_XE) $(imasklib_) $(LIB_MAK) $(MAKEDIRS)
 gxcldev_h=$(GLSRC)gxcldev.h
 gxclpage_h=$(GLSRC)gxclpage.h
 gxclpath_h=$(GLSRC)gxclpath.h
+gxclprof_h=$(GLSRC)gxclprof.h
 
 clbase1_=$(GLOBJ)gxclist.$(OBJ) $(GLOBJ)gxclbits.$(OBJ) $(GLOBJ)gxclpage.$(OBJ)
-clbase2_=$(GLOBJ)gxclrast.$(OBJ) $(GLOBJ)gxclread.$(OBJ) $(GLOBJ)gxclrect.$(OBJ)
+clbase2_=$(GLOBJ)gxclrast.$(OBJ) $(GLOBJ)gxclread.$(OBJ) $(GLOBJ)gxclrect.$(OBJ)\
+ $(GLOBJ)gxclprof.$(OBJ)
 clbase3_=$(GLOBJ)gxclutil.$(OBJ) $(GLOBJ)gsparams.$(OBJ) $(GLOBJ)gxshade6.$(OBJ)
 # gxclrect.c requires rop_proc_table, so we need gsroptab here.
 clbase4_=$(GLOBJ)gsroptab.$(OBJ) $(GLOBJ)gsroprun.$(OBJ) $(GLOBJ)stream.$(OBJ)
@@ -2227,16 +2231,21 @@ $(GLOBJ)gxclrast.$(OBJ) : $(GLSRC)gxclrast.c $(AK) $(gx_h)\
  $(stream_h) $(strimpl_h) $(gxcomp_h)\
  $(gsserial_h) $(gxdhtserial_h) $(gzht_h)\
  $(gxshade_h) $(gxshade4_h) $(gsicc_manage_h)\
- $(gsicc_h) $(LIB_MAK) $(MAKEDIRS)
+ $(gsicc_h) $(gxclprof_h) $(LIB_MAK) $(MAKEDIRS)
 	$(GLCC) $(GLO_)gxclrast.$(OBJ) $(C_) $(GLSRC)gxclrast.c
 
 $(GLOBJ)gxclread.$(OBJ) : $(GLSRC)gxclread.c $(AK) $(gx_h) $(gserrors_h)\
  $(memory__h) $(gp_h) $(gpcheck_h) $(gdevplnx_h) $(gdevprn_h) $(gscoord_h)\
  $(gsdevice_h) $(gxcldev_h) $(gxdevice_h) $(gxdevmem_h) $(gxgetbit_h)\
  $(gxhttile_h) $(gsmemory_h) $(stream_h) $(strimpl_h) $(gsicc_cache_h)\
- $(gdevp14_h) $(LIB_MAK) $(MAKEDIRS)
+ $(gdevp14_h) $(gxclprof_h) $(LIB_MAK) $(MAKEDIRS)
 	$(GLCC) $(GLO_)gxclread.$(OBJ) $(C_) $(GLSRC)gxclread.c
 
+$(GLOBJ)gxclprof.$(OBJ) : $(GLSRC)gxclprof.c $(AK) $(gx_h) $(gserrors_h)\
+ $(memory__h) $(gp_h) $(gxsync_h) $(gxdevice_h) $(gxcomp_h) $(gstrans_h)\
+ $(gxcldev_h) $(gxclpath_h) $(gxclprof_h) $(LIB_MAK) $(MAKEDIRS)
+	$(GLCC) $(GLO_)gxclprof.$(OBJ) $(C_) $(GLSRC)gxclprof.c
+
 $(GLOBJ)gxclrect.$(OBJ) : $(GLSRC)gxclrect.c $(AK) $(gx_h)\
  $(gserrors_h)\
  $(gsutil_h) $(gxcldev_h) $(gxdevice_h) $(gxdevmem_h) $(gxclpath_h)\
@@ -2285,7 +2294,8 @@ $(GLOBJ)gxclfile.$(OBJ) : $(GLSRC)gxclfile.c $(stdio__h) $(string__h)\
 
 # Implement band lists in memory (RAM).
 
-clmemory_=$(GLOBJ)gxclmem.$(OBJ) $(GLOBJ)gxcl$(BAND_LIST_COMPRESSOR).$(OBJ)
+clmemory_=$(GLOBJ)gxclmem.$(OBJ) $(GLOBJ)gxcl$(BAND_LIST_COMPRESSOR).$(OBJ)\
+ $(GLOBJ)sblz.$(OBJ)
 $(GLD)clmemory.dev : $(LIB_MAK) $(ECHOGS_XE) $(clmemory_) $(GLD)s$(BAND_LIST_COMPRESSOR)e.dev \
   $(GLD)s$(BAND_LIST_COMPRESSOR)d.dev $(LIB_MAK) $(MAKEDIRS)
 	$(SETMOD) $(GLD)clmemory $(clmemory_)
@@ -2296,9 +2306,16 @@ $(GLD)clmemory.dev : $(LIB_MAK) $(ECHOGS_XE) $(clmemory_) $(GLD)s$(BAND_LIST_COM
 gxclmem_h=$(GLSRC)gxclmem.h
 
 $(GLOBJ)gxclmem.$(OBJ) : $(GLSRC)gxclmem.c $(AK) $(gx_h) $(gserrors_h)\
- $(LIB_MAK) $(memory__h) $(gxclmem_h) $(gssprintf_h) $(valgrind_h) $(LIB_MAK) $(MAKEDIRS)
+ $(LIB_MAK) $(memory__h) $(gp_h) $(gxclmem_h) $(gssprintf_h) $(gxsync_h) $(sblzx_h)\
+ $(valgrind_h) $(LIB_MAK) $(MAKEDIRS)
 	$(GLCC) $(GLO_)gxclmem.$(OBJ) $(C_) $(GLSRC)gxclmem.c
 
+# The fast compression method for RAM-based band lists (BandListCompression).
+
+$(GLOBJ)sblz.$(OBJ) : $(GLSRC)sblz.c $(AK) $(memory__h) $(std_h)\
+ $(gsmemory_h) $(strimpl_h) $(sblzx_h) $(LIB_MAK) $(MAKEDIRS)
+	$(GLCC) $(GLO_)sblz.$(OBJ) $(C_) $(GLSRC)sblz.c
+
 # Implement the compression method for RAM-based band lists.
 
 $(GLOBJ)gxcllzw.$(OBJ) : $(GLSRC)gxcllzw.c $(std_h) $(AK)\
@@ -2316,7 +2333,8 @@ $(GLOBJ)gxclthrd.$(OBJ) :  $(GLSRC)gxclthrd.c $(gxsync_h) $(AK) $(gxclthrd_h)\
  $(gdevplnx_h) $(gdevprn_h) $(gp_h) $(gpcheck_h) $(gsdevice_h) $(gserrors_h)\
  $(gsmchunk_h) $(gsmemory_h) $(gx_h) $(gxcldev_h) $(gdevdevn_h)\
  $(gsicc_cache_h) $(gxdevice_h) $(gxdevmem_h) $(gxgetbit_h) $(memory__h)\
- $(gsicc_manage_h) $(gdevppla_h) $(gstrans_h) $(gzht_h) $(LIB_MAK) $(MAKEDIRS)
+ $(gsicc_manage_h) $(gdevppla_h) $(gstrans_h) $(gzht_h) $(gxclprof_h)\
+ $(LIB_MAK) $(MAKEDIRS)
 	$(GLCC) $(GLO_)gxclthrd.$(OBJ) $(C_) $(GLSRC)gxclthrd.c
 
 $(GLOBJ)gsmchunk.$(OBJ) :  $(GLSRC)gsmchunk.c $(AK) $(gx_h) $(gsstype_h)\
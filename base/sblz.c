@@ -0,0 +1,402 @@
+/* Copyright (C) 2001-2019 Artifex Software, Inc.
+   All Rights Reserved.
+
+   This software is provided AS-IS with no warranty, either express or
+   implied.
+
+   This software is distributed under license and may not be copied,
+   modified or distributed except as expressly authorized under the terms
+   of the license contained in the file LICENSE in this distribution.
+
+   Refer to licensing information at http://www.artifex.com or contact
+   Artifex Software, Inc.,  1305 Grant Avenue - Suite 200, Novato,
+   CA 94945, U.S.A., +1(415)492-9861, for further information.
+*/
+
+
+/* Block LZ compression and decompression filters */
+#include "memory_.h"
+#include "std.h"
+#include "gsmemory.h"
+#include "strimpl.h"
+#include "sblzx.h"
+
+/*
+ * A block is encoded as a sequence of tokens, each made of:
+ *	a byte whose high 4 bits are the number of literal bytes and low 4
+ *	  bits the match length minus BLZ_MIN_MATCH; 15 in either means
+ *	  that more bytes follow, each added to the length, up to and
+ *	  including the first that is not 255;
+ *	the literal bytes;
+ *	the distance back to the match, 2 bytes, low byte first;
+ *	the rest of the match length, if any.
+ * The last token has only literals, and ends the block.
+ */
+#define BLZ_MIN_MATCH 4
+#define BLZ_METHOD_STORED 0
+#define BLZ_METHOD_LZ 1
+
+private_st_BLZ_state();
+
+#define blz_hash(p)\
+  ((uint)((((bits32)(p)[0] | ((bits32)(p)[1] << 8) | ((bits32)(p)[2] << 16) |\
+            ((bits32)(p)[3] << 24)) * 2654435761u) & 0xffffffff) >> (32 - BLZ_HASH_LOG))
+
+/* Write a length of 15 or more as the bytes following the token. */
+static byte *
+blz_put_length(byte *op, uint len)
+{
+    for (len -= 15; len >= 255; len -= 255)
+        *op++ = 255;
+    *op++ = (byte)len;
+    return op;
+}
+
+/*
+ * Compress len bytes from src into dst.  Return the compressed size, or -1
+ * if it would be more than dst_size.
+ */
+static int
+blz_compress(const byte *src, uint len, byte *dst, uint dst_size, ushort *hash)
+{
+    const byte *ip = src, *anchor = src;
+    const byte *const iend = src + len;
+    byte *op = dst;
+    byte *const oend = dst + dst_size;
+    uint lit;
+
+    /* Only the positions before ip are ever used from hash, so */
+    /* positions left over from a previous block are harmless. */
+    while (iend - ip >= BLZ_MIN_MATCH) {
+        uint h = blz_hash(ip);
+        const byte *ref = src + hash[h];
+        const byte *mp;
+        uint mlen;
+
+        hash[h] = (ushort)(ip - src);
+        if (ref >= ip || ref[0] != ip[0] || ref[1] != ip[1] ||
+            ref[2] != ip[2] || ref[3] != ip[3]) {
+            /* Step faster through data that doesn't compress. */
+            ip += 1 + ((ip - anchor) >> 6);
+            continue;
+        }
+        for (mp = ip + BLZ_MIN_MATCH, ref += BLZ_MIN_MATCH;
+             mp < iend && *mp == *ref; ++mp, ++ref)
+            DO_NOTHING;
+        ref -= mp - ip;
+        while (ip > anchor && ref > src && ip[-1] == ref[-1])
+            --ip, --ref;
+        lit = ip - anchor;
+        mlen = mp - ip - BLZ_MIN_MATCH;
+        if (oend - op < (int)(lit + lit / 255 + mlen / 255 + 5))
+            return -1;
+        *op++ = (byte)((min(lit, 15) << 4) | min(mlen, 15));
+        if (lit >= 15)
+            op = blz_put_length(op, lit);
+        memcpy(op, anchor, lit);
+        op += lit;
+        *op++ = (byte)(ip - ref);
+        *op++ = (byte)((ip - ref) >> 8);
+        if (mlen >= 15)
+            op = blz_put_length(op, mlen);
+        ip = anchor = mp;
+    }
+    lit = iend - anchor;
+    if (oend - op < (int)(lit + lit / 255 + 2))
+        return -1;
+    *op++ = (byte)(min(lit, 15) << 4);
+    if (lit >= 15)
+        op = blz_put_length(op, lit);
+    memcpy(op, anchor, lit);
+    op += lit;
+    return op - dst;
+}
+
+/*
+ * Decompress len bytes from src into dst.  Return the decompressed size,
+ * or -1 if the data is invalid or would be more than dst_size.
+ */
+static int
+blz_decompress(const byte *src, uint len, byte *dst, uint dst_size)
+{
+    const byte *ip = src;
+    const byte *const iend = src + len;
+    byte *op = dst;
+    byte *const oend = dst + dst_size;
+
+    while (ip < iend) {
+        uint token = *ip++;
+        uint n = token >> 4;
+        uint dist;
+        const byte *ref;
+
+        if (n == 15) {
+            uint b;
+
+            do {
+                if (ip >= iend)
+                    return -1;
+                n += b = *ip++;
+            } while (b == 255);
+        }
+        if (n > (uint)(iend - ip) || n > (uint)(oend - op))
+            return -1;
+        memcpy(op, ip, n);
+        op += n;
+        ip += n;
+        if (ip >= iend)
+            break;		/* last token */
+        if (iend - ip < 2)
+            return -1;
+        dist = ip[0] | (ip[1] << 8);
+        ip += 2;
+        if (dist == 0 || dist > (uint)(op - dst))
+            return -1;
+        n = token & 15;
+        if (n == 15) {
+            uint b;
+
+            do {
+                if (ip >= iend)
+                    return -1;
+                n += b = *ip++;
+            } while (b == 255);
+        }
+        n += BLZ_MIN_MATCH;
+        if (n > (uint)(oend - op))
+            return -1;
+        ref = op - dist;
+        if (dist >= n) {
+            memcpy(op, ref, n);
+            op += n;
+        } else {
+            /* The match overlaps what it is producing. */
+            while (n--)
+                *op++ = *ref++;
+        }
+    }
+    return op - dst;
+}
+
+/* ------ Common ------ */
+
+static byte *
+blz_alloc_buffer(stream_BLZ_state *ss, byte **pbuf, const char *cname)
+{
+    if (*pbuf == NULL)
+        *pbuf = gs_alloc_bytes(ss->memory->non_gc_memory,
+                               BLZ_HEADER_SIZE + BLZ_MAX_BLOCK, cname);
+    return *pbuf;
+}
+
+/* Write out as much of the pending output as we can. */
+static int
+blz_flush(stream_BLZ_state *ss, stream_cursor_write * pw)
+{
+    uint count = min(ss->out_count - ss->out_next, pw->limit - pw->ptr);
+
+    memcpy(pw->ptr + 1, ss->out + ss->out_next, count);
+    pw->ptr += count;
+    ss->out_next += count;
+    return (ss->out_next < ss->out_count ? 1 : 0);
+}
+
+static int
+s_BLZ_reinit(stream_state * st)
+{
+    stream_BLZ_state *const ss = (stream_BLZ_state *) st;
+
+    ss->done = false;
+    ss->header_count = 0;
+    ss->buf_count = 0;
+    ss->out_count = ss->out_next = 0;
+    return 0;
+}
+
+static void
+s_BLZ_set_defaults(stream_state * st)
+{
+    stream_BLZ_state *const ss = (stream_BLZ_state *) st;
+
+    ss->buf = NULL;
+    ss->out = NULL;
+    ss->hash = NULL;
+}
+
+static void
+s_BLZ_release(stream_state * st)
+{
+    stream_BLZ_state *const ss = (stream_BLZ_state *) st;
+    gs_memory_t *mem = ss->memory->non_gc_memory;
+
+    gs_free_object(mem, ss->buf, "s_BLZ_release(buf)");
+    gs_free_object(mem, ss->out, "s_BLZ_release(out)");
+    gs_free_object(mem, ss->hash, "s_BLZ_release(hash)");
+    s_BLZ_set_defaults(st);
+}
+
+/* ------ BLZ encoder ------ */
+
+static int
+s_BLZE_init(stream_state * st)
+{
+    stream_BLZ_state *const ss = (stream_BLZ_state *) st;
+
+    if (ss->hash == NULL) {
+        ss->hash = (ushort *)
+            gs_alloc_byte_array(ss->memory->non_gc_memory, 1 << BLZ_HASH_LOG,
+                                sizeof(ushort), "s_BLZE_init(hash)");
+        if (ss->hash == NULL)
+            return ERRC;
+        memset(ss->hash, 0, sizeof(ushort) << BLZ_HASH_LOG);
+    }
+    return s_BLZ_reinit(st);
+}
+
+static int
+s_BLZE_process(stream_state * st, stream_cursor_read * pr,
+               stream_cursor_write * pw, bool last)
+{
+    stream_BLZ_state *const ss = (stream_BLZ_state *) st;
+    uint avail = pr->limit - pr->ptr;
+    const byte *src;
+    byte *dst;
+    uint len;
+    int size;
+
+    if (ss->done) {
+        if (avail != 0)
+            return ERRC;	/* only one block per stream */
+        return blz_flush(ss, pw);
+    }
+    if (avail > BLZ_MAX_BLOCK - ss->buf_count)
+        return ERRC;
+    if (!last || ss->buf_count != 0) {
+        /* Collect the block until we have all of it. */
+        if (avail != 0) {
+            if (blz_alloc_buffer(ss, &ss->buf, "s_BLZE_process(buf)") == NULL)
+                return ERRC;
+            memcpy(ss->buf + ss->buf_count, pr->ptr + 1, avail);
+            ss->buf_count += avail;
+            pr->ptr += avail;
+        }
+        if (!last)
+            return 0;
+        src = ss->buf;
+        len = ss->buf_count;
+    } else {
+        /* The whole block is here: compress it in place. */
+        src = pr->ptr + 1;
+        len = avail;
+        pr->ptr += avail;
+    }
+    ss->done = true;
+    /* Compress directly into the caller's buffer if it is big enough. */
+    if (pw->limit - pw->ptr >= BLZ_HEADER_SIZE + len)
+        dst = pw->ptr + 1;
+    else if ((dst = blz_alloc_buffer(ss, &ss->out, "s_BLZE_process(out)")) == NULL)
+        return ERRC;
+    size = (len > BLZ_MIN_MATCH ?
+            blz_compress(src, len, dst + BLZ_HEADER_SIZE, len - 1, ss->hash) :
+            -1);
+    if (size < 0) {
+        /* Not worth compressing: store it. */
+        memcpy(dst + BLZ_HEADER_SIZE, src, len);
+        size = len;
+        dst[0] = BLZ_METHOD_STORED;
+    } else
+        dst[0] = BLZ_METHOD_LZ;
+    dst[1] = (byte)len;
+    dst[2] = (byte)(len >> 8);
+    dst[3] = (byte)size;
+    dst[4] = (byte)(size >> 8);
+    if (dst == pw->ptr + 1) {
+        pw->ptr += BLZ_HEADER_SIZE + size;
+        return 0;
+    }
+    ss->out_count = BLZ_HEADER_SIZE + size;
+    ss->out_next = 0;
+    return blz_flush(ss, pw);
+}
+
+const stream_template s_BLZE_template = {
+    &st_BLZ_state, s_BLZE_init, s_BLZE_process, 1, 1, s_BLZ_release,
+    s_BLZ_set_defaults, s_BLZ_reinit
+};
+
+/* ------ BLZ decoder ------ */
+
+static int
+s_BLZD_init(stream_state * st)
+{
+    return s_BLZ_reinit(st);
+}
+
+static int
+s_BLZD_process(stream_state * st, stream_cursor_read * pr,
+               stream_cursor_write * pw, bool last)
+{
+    stream_BLZ_state *const ss = (stream_BLZ_state *) st;
+    uint method, raw_size, size, avail;
+    const byte *src;
+    byte *dst;
+    int count;
+
+    if (ss->done)
+        return (blz_flush(ss, pw) ? 1 : EOFC);
+    /* Read the header, which may be split across calls. */
+    while (ss->header_count < BLZ_HEADER_SIZE) {
+        if (pr->ptr >= pr->limit)
+            return 0;
+        ss->header[ss->header_count++] = *++(pr->ptr);
+    }
+    method = ss->header[0];
+    raw_size = ss->header[1] | (ss->header[2] << 8);
+    size = ss->header[3] | (ss->header[4] << 8);
+    if (method > BLZ_METHOD_LZ ||
+        (method == BLZ_METHOD_STORED && size != raw_size))
+        return ERRC;
+    avail = pr->limit - pr->ptr;
+    if (ss->buf_count == 0 && avail >= size) {
+        /* The whole block is here: decompress it in place. */
+        src = pr->ptr + 1;
+        pr->ptr += size;
+    } else {
+        /* Collect the block until we have all of it. */
+        uint n = min(avail, size - ss->buf_count);
+
+        if (blz_alloc_buffer(ss, &ss->buf, "s_BLZD_process(buf)") == NULL)
+            return ERRC;
+        memcpy(ss->buf + ss->buf_count, pr->ptr + 1, n);
+        pr->ptr += n;
+        ss->buf_count += n;
+        if (ss->buf_count < size)
+            return 0;
+        src = ss->buf;
+    }
+    ss->done = true;
+    /* Decompress directly into the caller's buffer if it is big enough. */
+    if (pw->limit - pw->ptr >= raw_size)
+        dst = pw->ptr + 1;
+    else if ((dst = blz_alloc_buffer(ss, &ss->out, "s_BLZD_process(out)")) == NULL)
+        return ERRC;
+    if (method == BLZ_METHOD_STORED) {
+        memcpy(dst, src, size);
+        count = size;
+    } else
+        count = blz_decompress(src, size, dst, raw_size);
+    if (count != raw_size)
+        return ERRC;
+    if (dst == pw->ptr + 1) {
+        pw->ptr += raw_size;
+        return EOFC;
+    }
+    ss->out_count = raw_size;
+    ss->out_next = 0;
+    return (blz_flush(ss, pw) ? 1 : EOFC);
+}
+
+const stream_template s_BLZD_template = {
+    &st_BLZ_state, s_BLZD_init, s_BLZD_process, 1, 1, s_BLZ_release,
+    s_BLZ_set_defaults, s_BLZ_reinit
+};
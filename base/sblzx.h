@@ -0,0 +1,66 @@
+/* Copyright (C) 2001-2019 Artifex Software, Inc.
+   All Rights Reserved.
+
+   This software is provided AS-IS with no warranty, either express or
+   implied.
+
+   This software is distributed under license and may not be copied,
+   modified or distributed except as expressly authorized under the terms
+   of the license contained in the file LICENSE in this distribution.
+
+   Refer to licensing information at http://www.artifex.com or contact
+   Artifex Software, Inc.,  1305 Grant Avenue - Suite 200, Novato,
+   CA 94945, U.S.A., +1(415)492-9861, for further information.
+*/
+
+
+/* Definitions for block LZ filters */
+/* Requires scommon.h; strimpl.h if any templates are referenced */
+
+#ifndef sblzx_INCLUDED
+#  define sblzx_INCLUDED
+
+#include "scommon.h"
+
+/*
+ * These filters implement a simple byte oriented LZ77 compression that is
+ * much faster than zlib, especially for decompression, at the cost of a
+ * lower compression ratio.  They are meant for blocks of data that are
+ * compressed and read back whole, such as the blocks of a band list in
+ * memory: each stream (between init or reinit and EOD) holds exactly one
+ * block of at most BLZ_MAX_BLOCK bytes.  The encoder collects the whole
+ * block before compressing it, and the decoder returns EOFC at its end.
+ *
+ * The encoded block is a header of BLZ_HEADER_SIZE bytes (the method, then
+ * the decoded and encoded lengths, 2 bytes each, low byte first) followed
+ * by the block itself, either stored or as a sequence of LZ4 style
+ * literal runs and back references.
+ */
+#define BLZ_MAX_BLOCK 65535
+#define BLZ_HEADER_SIZE 5
+#define BLZ_HASH_LOG 12
+
+typedef struct stream_BLZ_state_s {
+    stream_state_common;
+    /* The following change dynamically. */
+    bool done;			/* the block has been encoded or decoded */
+    byte header[BLZ_HEADER_SIZE];
+    uint header_count;		/* (decoder) header bytes read so far */
+    byte *buf;			/* block collected from several calls */
+    uint buf_count;
+    byte *out;			/* output that didn't fit in the caller's */
+    uint out_count, out_next;	/* buffer, waiting to be written */
+    ushort *hash;		/* (encoder) recent positions, by hash */
+} stream_BLZ_state;
+
+typedef stream_BLZ_state stream_BLZE_state;
+typedef stream_BLZ_state stream_BLZD_state;
+
+/* The buffers are allocated from the non-GC memory of the stream. */
+#define private_st_BLZ_state()	/* in sblz.c */\
+  gs_private_st_simple(st_BLZ_state, stream_BLZ_state, "BLZ state")
+
+extern const stream_template s_BLZE_template;
+extern const stream_template s_BLZD_template;
+
+#endif /* sblzx_INCLUDED */
@@ -369,7 +369,11 @@ const gx_device_bit gs_bitrgbtags_device =
         NULL,  /* buffer_memory */
         NULL,  /* bandlist_memory */
         0,     /* clist_disable_mask */
+        clist_compress_default, /* clist_compression */
+        NULL,  /* clist_profile */
         false, /* bg_print_requested */
+        1,     /* bg_print_queue_depth */
+        0,     /* bg_print_max_memory */
         {0},   /* bg_print */
         0,     /* num_render_threads_requested */
         NULL,  /* saved_pages_list */
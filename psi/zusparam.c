@@ -510,6 +510,30 @@ set_icc_directory(i_ctx_t *i_ctx_p, gs_param_string * pval)
     return gs_seticcdirectory(igs, pval);
 }
 
+static void
+current_icc_link_cache_directory(i_ctx_t *i_ctx_p, gs_param_string * pval)
+{
+    gs_currenticclinkcachedirectory(igs, pval);
+}
+
+static int
+set_icc_link_cache_directory(i_ctx_t *i_ctx_p, gs_param_string * pval)
+{
+    gs_param_string cur;
+
+    /* The directory is one of the places that may be written with SAFER
+       (see .lockfileaccess and .locksafe_userparams), so once that is
+       locked it can only be set to what it already is. */
+    if (i_ctx_p->LockFilePermissions || gs_is_path_control_active(imemory)) {
+        gs_currenticclinkcachedirectory(igs, &cur);
+        if (pval->size != cur.size ||
+            (cur.size != 0 && memcmp(pval->data, cur.data, cur.size) != 0))
+            return_error(gs_error_invalidaccess);
+        return 0;
+    }
+    return gs_seticclinkcachedirectory(igs, pval);
+}
+
 static void
 current_srcgtag_icc(i_ctx_t *i_ctx_p, gs_param_string * pval)
 {
@@ -620,6 +644,8 @@ static const string_param_def_t user_string_params[] =
     {"DefaultCMYKProfile", current_default_cmyk_icc, set_default_cmyk_icc},
     {"NamedProfile", current_named_icc, set_named_profile_icc},
     {"ICCProfilesDir", current_icc_directory, set_icc_directory},
+    {"ICCLinkCacheDir", current_icc_link_cache_directory,
+     set_icc_link_cache_directory},
     {"LabProfile", current_lab_icc, set_lab_icc},
     {"DeviceNProfile", current_devicen_icc, set_devicen_profile_icc},
     {"SourceObjectICC", current_srcgtag_icc, set_srcgtag_icc}
@@ -0,0 +1,242 @@
+#!/usr/bin/env python
+
+# Copyright (C) 2001-2019 Artifex Software, Inc.
+# All Rights Reserved.
+#
+# This software is provided AS-IS with no warranty, either express or
+# implied.
+#
+# This software is distributed under license and may not be copied,
+# modified or distributed except as expressly authorized under the terms
+# of the license contained in the file LICENSE in this distribution.
+#
+# Refer to licensing information at http://www.artifex.com or contact
+# Artifex Software, Inc.,  1305 Grant Avenue - Suite 200, Novato,
+# CA 94945, U.S.A., +1(415)492-9861, for further information.
+#
+
+# This script compares the cost of the transparency (pdf14) compositor
+# at 8 and 16 bits per component.  For each blend mode it writes a test
+# file of overlapping transparent fills and transparency groups, renders
+# it to an 8 and a 16 bit per component device, and reports the times.
+#
+# Given a second executable with -b it instead compares the two builds
+# on the same files, for instance a build configured with --disable-sse2
+# against the default one to measure the SIMD compose and blend kernels,
+# or a build from before a change to the blend mode kernels.
+
+USAGE = """\
+Usage: python pdf14bench.py [options] [blendmode ...]
+  -g gs         the Ghostscript executable (default bin/gs)
+  -r res        the resolution (default 150)
+  -n count      the number of times to run each job, the best is used
+                (default 3)
+  -b gs         compare with this executable rather than 8 with 16 bits
+  -c            compare tiff32nc with tiff64nc (CMYK) rather than
+                tiff24nc with tiff48nc (RGB)
+  -k dir        keep the test files and output in dir
+The blend modes default to all of them; 'separable' and 'nonseparable'
+stand for the two kinds."""
+HELP = """\
+An example of usage:
+        python toolbin/pdf14bench.py -r 300 Normal Multiply Luminosity
+prints one line per blend mode giving the time taken at 8 and at 16 bits
+per component, and the ratio between them.  To measure the SSE2 kernels,
+build a second copy with ./configure --disable-sse2 and run
+        python toolbin/pdf14bench.py -b ../nosse2/bin/gs
+which prints, for each blend mode and bit depth, the time taken by bin/gs,
+by the -b executable and the speed up of bin/gs.  Similarly a change to
+the separable blend modes can be measured against a build of a checkout
+from before it with
+        python toolbin/pdf14bench.py -b ../before/bin/gs separable"""
+
+import getopt
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+
+BLEND_MODES = ['Normal', 'Multiply', 'Screen', 'Overlay', 'Darken',
+               'Lighten', 'ColorDodge', 'ColorBurn', 'HardLight',
+               'SoftLight', 'Difference', 'Exclusion', 'Hue', 'Saturation',
+               'Color', 'Luminosity']
+SEPARABLE = BLEND_MODES[:12]
+
+#---------------- Test file ----------------#
+
+def colour(i, cmyk):
+    # Reproducible colours, spread around the space.
+    c = [((i * 37 + k * 91) % 101) / 100.0 for k in range(4)]
+    if cmyk:
+        return '%.2f %.2f %.2f %.2f k' % tuple(c)
+    return '%.2f %.2f %.2f rg' % tuple(c[:3])
+
+def page_content(cmyk):
+    # Overlapping fills marked directly into the page group, then groups
+    # that are composed into it.
+    out = ['/GS0 gs']
+    for i in range(48):
+        x = 20 + (i % 8) * 60
+        y = 40 + (i // 8) * 110
+        out.append('%s %d %d 180 220 re f' % (colour(i, cmyk), x, y))
+    for i in range(24):
+        x = 10 + (i % 6) * 90
+        y = 20 + (i // 6) * 180
+        out.append('q 1 0 0 1 %d %d cm /Fm%d Do Q' % (x, y, i % 4))
+    return '\n'.join(out) + '\n'
+
+def group_content(i, cmyk):
+    out = ['/GS1 gs']
+    for k in range(3):
+        out.append('%s %d %d 200 260 re f' %
+                   (colour(i * 3 + k, cmyk), k * 50, k * 40))
+    return '\n'.join(out) + '\n'
+
+def write_pdf(fname, blend_mode, cmyk):
+    gstates = ('<< /GS0 << /ca 0.7 /BM /%s >> /GS1 << /ca 0.8 /BM /%s >> >>'
+               % (blend_mode, blend_mode))
+    content = page_content(cmyk)
+    objs = ['<< /Type /Catalog /Pages 2 0 R >>',
+            '<< /Type /Pages /Kids [3 0 R] /Count 1 >>',
+            '<< /Type /Page /Parent 2 0 R /MediaBox [0 0 612 792] '
+            '/Contents 4 0 R '
+            '/Resources << /ExtGState %s /XObject << %s >> >> >>' %
+            (gstates,
+             ' '.join(['/Fm%d %d 0 R' % (i, 5 + i) for i in range(4)])),
+            '<< /Length %d >>\nstream\n%sendstream' % (len(content), content)]
+    for i in range(4):
+        form = group_content(i, cmyk)
+        objs.append('<< /Type /XObject /Subtype /Form /BBox [0 0 320 360] '
+                    '/Group << /S /Transparency /I %s /K false >> '
+                    '/Resources << /ExtGState %s >> /Length %d >>\n'
+                    'stream\n%sendstream' %
+                    (i & 1 and 'true' or 'false', gstates, len(form), form))
+    pdf = '%PDF-1.4\n'
+    offsets = []
+    for i in range(len(objs)):
+        offsets.append(len(pdf))
+        pdf += '%d 0 obj\n%s\nendobj\n' % (i + 1, objs[i])
+    xref = len(pdf)
+    pdf += 'xref\n0 %d\n0000000000 65535 f \n' % (len(objs) + 1)
+    for o in offsets:
+        pdf += '%010d 00000 n \n' % o
+    pdf += ('trailer\n<< /Size %d /Root 1 0 R >>\nstartxref\n%d\n%%%%EOF\n'
+            % (len(objs) + 1, xref))
+    f = open(fname, 'w')
+    f.write(pdf)
+    f.close()
+
+#---------------- Timing ----------------#
+
+def run(gs, device, res, fname, outname, count):
+    args = [gs, '-q', '-dNOPAUSE', '-dBATCH', '-dSAFER',
+            '-sDEVICE=' + device, '-r%d' % res,
+            '-sOutputFile=' + outname, fname]
+    best = None
+    for i in range(count):
+        # Use the CPU time of the child rather than the elapsed time, it is
+        # much less disturbed by whatever else the machine is doing.
+        start = os.times()
+        if subprocess.call(args) != 0:
+            raise RuntimeError('%s failed' % ' '.join(args))
+        end = os.times()
+        t = (end[2] + end[3]) - (start[2] + start[3])
+        if best is None or t < best:
+            best = t
+    return best
+
+def compare_depths(gs, modes, devices, res, count, cmyk, dir):
+    print('%-12s %10s %10s %7s' % ('blend mode', devices[0], devices[1],
+                                   '16/8'))
+    total = [0.0, 0.0]
+    for m in modes:
+        fname = os.path.join(dir, m + '.pdf')
+        write_pdf(fname, m, cmyk)
+        t = []
+        for d in devices:
+            t.append(run(gs, d, res, fname,
+                         os.path.join(dir, '%s_%s.tif' % (m, d)), count))
+        total[0] += t[0]
+        total[1] += t[1]
+        print('%-12s %10.3f %10.3f %7.2f' % (m, t[0], t[1], t[1] / t[0]))
+    print('%-12s %10.3f %10.3f %7.2f' % ('total', total[0], total[1],
+                                         total[1] / total[0]))
+
+def compare_builds(gs, base, modes, devices, res, count, cmyk, dir):
+    line = '%-12s' % 'blend mode'
+    for d in devices:
+        line += ' %9s %9s %6s' % (d, 'base', 'x')
+    print(line)
+    total = [0.0] * (2 * len(devices))
+    for m in modes:
+        fname = os.path.join(dir, m + '.pdf')
+        write_pdf(fname, m, cmyk)
+        line = '%-12s' % m
+        for i in range(len(devices)):
+            d = devices[i]
+            t = run(gs, d, res, fname,
+                    os.path.join(dir, '%s_%s.tif' % (m, d)), count)
+            b = run(base, d, res, fname,
+                    os.path.join(dir, '%s_%s_base.tif' % (m, d)), count)
+            total[2 * i] += t
+            total[2 * i + 1] += b
+            line += ' %9.3f %9.3f %6.2f' % (t, b, b / t)
+        print(line)
+    line = '%-12s' % 'total'
+    for i in range(len(devices)):
+        line += ' %9.3f %9.3f %6.2f' % (total[2 * i], total[2 * i + 1],
+                                        total[2 * i + 1] / total[2 * i])
+    print(line)
+
+def main(argv):
+    gs, base, res, count, cmyk, keep = 'bin/gs', None, 150, 3, False, None
+    try:
+        opts, modes = getopt.getopt(argv, 'g:b:r:n:ck:h')
+    except getopt.GetoptError:
+        print(USAGE)
+        return 1
+    for o, a in opts:
+        if o == '-g': gs = a
+        elif o == '-b': base = a
+        elif o == '-r': res = int(a)
+        elif o == '-n': count = int(a)
+        elif o == '-c': cmyk = True
+        elif o == '-k': keep = a
+        elif o == '-h':
+            print(USAGE)
+            print(HELP)
+            return 0
+    expanded = []
+    for m in modes:
+        if m == 'separable':
+            expanded += SEPARABLE
+        elif m == 'nonseparable':
+            expanded += BLEND_MODES[len(SEPARABLE):]
+        elif m in BLEND_MODES:
+            expanded.append(m)
+        else:
+            print('Unknown blend mode ' + m)
+            return 1
+    modes = expanded
+    if not modes:
+        modes = BLEND_MODES
+    devices = cmyk and ('tiff32nc', 'tiff64nc') or ('tiff24nc', 'tiff48nc')
+    if keep:
+        dir = keep
+        if not os.path.isdir(dir):
+            os.makedirs(dir)
+    else:
+        dir = tempfile.mkdtemp(prefix='pdf14bench')
+    try:
+        if base:
+            compare_builds(gs, base, modes, devices, res, count, cmyk, dir)
+        else:
+            compare_depths(gs, modes, devices, res, count, cmyk, dir)
+    finally:
+        if not keep:
+            shutil.rmtree(dir)
+    return 0
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv[1:]))
@@ -0,0 +1,106 @@
+#!/usr/bin/env python
+
+# Copyright (C) 2001-2019 Artifex Software, Inc.
+# All Rights Reserved.
+#
+# This software is provided AS-IS with no warranty, either express or
+# implied.
+#
+# This software is distributed under license and may not be copied,
+# modified or distributed except as expressly authorized under the terms
+# of the license contained in the file LICENSE in this distribution.
+#
+# Refer to licensing information at http://www.artifex.com or contact
+# Artifex Software, Inc.,  1305 Grant Avenue - Suite 200, Novato,
+# CA 94945, U.S.A., +1(415)492-9861, for further information.
+#
+
+
+# Check that the ICC link store (the ICCLinkCacheDir user parameter) only
+# writes where it is allowed to: with -dSAFER a job can't point it
+# somewhere else, and a relative directory isn't accepted at all.
+
+import os, shutil, subprocess, tempfile
+from gstestutils import GSTestCase, gsRunTestsMain
+
+# Fill with an RGB color on a CMYK device, so that a link has to be built.
+job = '0.2 0.4 0.6 setrgbcolor 0 0 100 100 rectfill showpage'
+
+def run_gs(gsroot, dir, args, ps):
+    cmd = [os.path.join(gsroot, 'bin', 'gs'), '-q', '-dNOPAUSE', '-dBATCH',
+           '-sDEVICE=tiff32nc', '-r72',
+           '-sOutputFile=' + os.path.join(dir, 'out.tif')] + args + \
+          ['-c', ps]
+    p = subprocess.Popen(cmd, cwd=dir, stdout=subprocess.PIPE,
+                         stderr=subprocess.STDOUT)
+    out = p.communicate()[0]
+    return p.returncode, out
+
+def links(dir):
+    return [f for f in os.listdir(dir) if f.startswith('gslink_')]
+
+class GSCheckLinkStoreSafer(GSTestCase):
+
+    def __init__(self, gsroot):
+        self.gsroot = gsroot
+        GSTestCase.__init__(self)
+
+    def runTest(self):
+        """With -dSAFER the link store must stay in ICCLinkCacheDir."""
+        messages = []
+        top = tempfile.mkdtemp(prefix='gscheck_icc')
+        try:
+            store = os.path.join(top, 'store')
+            other = os.path.join(top, 'other')
+            os.mkdir(store)
+            os.mkdir(other)
+            # The directory given on the command line is used.
+            code, out = run_gs(self.gsroot, top,
+                               ['-dSAFER',
+                                '-sICCLinkCacheDir=' + store + os.sep],
+                               job)
+            if code != 0:
+                messages.append('gs failed: %s' % out)
+            if not links(store):
+                messages.append('no link was written to ' + store)
+            # But a job can't move it elsewhere.
+            code, out = run_gs(self.gsroot, top,
+                               ['-dSAFER',
+                                '-sICCLinkCacheDir=' + store + os.sep],
+                               '{ << /ICCLinkCacheDir (%s%s) >> '
+                               'setuserparams } stopped '
+                               '{ (denied) print } if ' % (other, os.sep) +
+                               job)
+            if 'denied'.encode() not in out:
+                messages.append('ICCLinkCacheDir could be changed with '
+                                '-dSAFER')
+            if links(other):
+                messages.append('a link was written to ' + other)
+            # Nor set one if there wasn't one to start with.
+            code, out = run_gs(self.gsroot, top, ['-dSAFER'],
+                               '<< /ICCLinkCacheDir (%s%s) >> '
+                               'setuserparams ' % (other, os.sep) + job)
+            if links(other):
+                messages.append('a link was written to ' + other +
+                                ' when it is not in PermitFileWriting')
+            # A relative directory is refused.
+            code, out = run_gs(self.gsroot, top, [],
+                               '{ << /ICCLinkCacheDir (other%s) >> '
+                               'setuserparams } stopped '
+                               '{ (refused) print } if ' % os.sep + job)
+            if 'refused'.encode() not in out:
+                messages.append('a relative ICCLinkCacheDir was accepted')
+            if links(other) or links(top):
+                messages.append('a link was written to a relative '
+                                'ICCLinkCacheDir')
+        finally:
+            shutil.rmtree(top)
+        self.failIfMessages(messages)
+
+# Add the tests defined in this file to a suite.
+
+def addTests(suite, gsroot, **args):
+    suite.addTest(GSCheckLinkStoreSafer(gsroot))
+
+if __name__ == "__main__":
+    gsRunTestsMain(addTests)